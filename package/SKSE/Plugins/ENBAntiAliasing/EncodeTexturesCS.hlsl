@@ -2,12 +2,25 @@ Texture2D<float2> TAAMask : register(t0);
 
 RWTexture2D<float> AlphaMask : register(u0);
 
-[numthreads(8, 8, 1)] void main(uint3 dispatchID
-								: SV_DispatchThreadID) {
+// Thread group shape picked by the autotuner
+#if !defined(GROUP_SIZE_X)
+#	define GROUP_SIZE_X 8
+#	define GROUP_SIZE_Y 8
+#endif
+
+[numthreads(GROUP_SIZE_X, GROUP_SIZE_Y, 1)] void main(uint3 dispatchID
+													  : SV_DispatchThreadID) {
+#if defined(HALF)
+	min16float2 taaMask = (min16float2)TAAMask[dispatchID.xy];
+
+	min16float alphaMask = taaMask.x * 0.5;
+	alphaMask = lerp(alphaMask, 1.0, taaMask.y);
+#else
 	float2 taaMask = TAAMask[dispatchID.xy];	
 
 	float alphaMask = taaMask.x * 0.5;
 	alphaMask = lerp(alphaMask, 1.0, taaMask.y);
+#endif
 
 	AlphaMask[dispatchID.xy] = alphaMask;
 }
@@ -37,53 +37,141 @@
 Texture2D<float3> Source : register(t0);
 RWTexture2D<float3> Dest : register(u0);
 
-float getRCASLuma(float3 rgb)
+// Thread group shape picked by the autotuner, tiled dispatches always use the classifier's 8x8 tiles
+#if !defined(GROUP_SIZE_X)
+#	define GROUP_SIZE_X 8
+#	define GROUP_SIZE_Y 8
+#endif
+
+#if defined(TILED)
+// Packed x | y << 16 coordinates of the 8x8 tiles that passed classification
+StructuredBuffer<uint> Tiles : register(t1);
+#endif
+
+cbuffer RCASCB : register(b0)
 {
-	return dot(rgb, float3(0.5, 1.0, 0.5));
-}
+	float Sharpness;
+	uint2 ScreenSize;
+	float pad0;
+};
 
-[numthreads(8, 8, 1)] void main(uint3 DTid
-								: SV_DispatchThreadID) {
-	float3 e = Source.Load(int3(DTid.x, DTid.y, 0)).rgb;
+// The output is 8 bits per channel so 16-bit math is enough where the device supports it
+#if defined(HALF)
+typedef min16float real;
+typedef min16float2 real2;
+typedef min16float3 real3;
+#else
+typedef float real;
+typedef float2 real2;
+typedef float3 real3;
+#endif
 
-	float3 b = Source.Load(int3(DTid.x, DTid.y - 1, 0)).rgb;
-	float3 d = Source.Load(int3(DTid.x - 1, DTid.y, 0)).rgb;
-	float3 f = Source.Load(int3(DTid.x + 1, DTid.y, 0)).rgb;
-	float3 h = Source.Load(int3(DTid.x, DTid.y + 1, 0)).rgb;
+// Taps past the screen edge repeat the edge texel, which is also what the tile classifier assumes
+real3 LoadClamped(int2 coord)
+{
+	return (real3)Source.Load(int3(clamp(coord, 0, (int2)ScreenSize - 1), 0)).rgb;
+}
 
-	// Luma times 2.
-	float bL = getRCASLuma(b);
-	float dL = getRCASLuma(d);
-	float eL = getRCASLuma(e);
-	float fL = getRCASLuma(f);
-	float hL = getRCASLuma(h);
+real getRCASLuma(real3 rgb)
+{
+	return dot(rgb, real3(0.5, 1.0, 0.5));
+}
 
+// Taps in the cross pattern b, d, f, h around e, with luma already computed
+real3 RCASFilter(real3 b, real3 d, real3 e, real3 f, real3 h, real bL, real dL, real eL, real fL, real hL)
+{
 	// Noise detection.
-	float nz = (bL + dL + fL + hL) * 0.25 - eL;
-	float range = max(max(max(bL, dL), max(hL, fL)), eL) - min(min(min(bL, dL), min(eL, fL)), hL);
+	real nz = (bL + dL + fL + hL) * 0.25 - eL;
+	real range = max(max(max(bL, dL), max(hL, fL)), eL) - min(min(min(bL, dL), min(eL, fL)), hL);
 	nz = saturate(abs(nz) * rcp(range));
 	nz = -0.5 * nz + 1.0;
 
 	// Min and max of ring.
-	float3 minRGB = min(min(b, d), min(f, h));
-	float3 maxRGB = max(max(b, d), max(f, h));
+	real3 minRGB = min(min(b, d), min(f, h));
+	real3 maxRGB = max(max(b, d), max(f, h));
 
 	// Immediate constants for peak range.
 	float2 peakC = float2(1.0, -4.0);
 
 	// Limiters, these need to use high precision reciprocal operations.
 	// Decided to use standard rcp for now in hopes of optimizing it
-	float3 hitMin = minRGB * rcp(4.0 * maxRGB);
-	float3 hitMax = (peakC.xxx - maxRGB) * rcp(4.0 * minRGB + peakC.yyy);
+	// Float even in the half variant along with the resolve, 16-bit reciprocals near the clip points and a 16-bit sum
+	// of the taps each cost most of an output step
+	float3 hitMin = (float3)minRGB * rcp(4.0 * (float3)maxRGB);
+	float3 hitMax = (peakC.xxx - (float3)maxRGB) * rcp(4.0 * (float3)minRGB + peakC.yyy);
 	float3 lobeRGB = max(-hitMin, hitMax);
-	float lobe = max(-0.1875, min(max(lobeRGB.r, max(lobeRGB.g, lobeRGB.b)), 0.0)) * SHARPNESS;
+	float lobe = max(-0.1875, min(max(lobeRGB.r, max(lobeRGB.g, lobeRGB.b)), 0.0)) * Sharpness;
 
 	// Apply noise removal.
 	lobe *= nz;
 
 	// Resolve, which needs medium precision rcp approximation to avoid visible tonality changes.
 	float rcpL = rcp(4.0 * lobe + 1.0);
-	float3 output = ((b + d + f + h) * lobe + e) * rcpL;
+	return (real3)((((float3)b + (float3)d + (float3)f + (float3)h) * lobe + (float3)e) * rcpL);
+}
+
+#if defined(GROUPSHARED)
+// Group tile plus a one texel border, each texel is fetched once and its luma computed once
+#	define HALO_WIDTH (GROUP_SIZE_X + 2)
+#	define HALO_HEIGHT (GROUP_SIZE_Y + 2)
+
+groupshared real3 CachedColor[HALO_WIDTH * HALO_HEIGHT];
+groupshared real CachedLuma[HALO_WIDTH * HALO_HEIGHT];
+
+void RCAS(uint2 tileOrigin, uint2 groupThreadID, uint groupIndex)
+{
+	for (uint i = groupIndex; i < HALO_WIDTH * HALO_HEIGHT; i += GROUP_SIZE_X * GROUP_SIZE_Y) {
+		real3 color = LoadClamped(int2(tileOrigin) + int2(i % HALO_WIDTH, i / HALO_WIDTH) - 1);
+		CachedColor[i] = color;
+		CachedLuma[i] = getRCASLuma(color);
+	}
 
-	Dest[DTid.xy] = output;
-}
\ No newline at end of file
+	GroupMemoryBarrierWithGroupSync();
+
+	uint center = (groupThreadID.y + 1) * HALO_WIDTH + groupThreadID.x + 1;
+
+	real3 output = RCASFilter(
+		CachedColor[center - HALO_WIDTH], CachedColor[center - 1], CachedColor[center], CachedColor[center + 1], CachedColor[center + HALO_WIDTH],
+		CachedLuma[center - HALO_WIDTH], CachedLuma[center - 1], CachedLuma[center], CachedLuma[center + 1], CachedLuma[center + HALO_WIDTH]);
+
+	Dest[tileOrigin + groupThreadID] = output;
+}
+#else
+void RCAS(uint2 tileOrigin, uint2 groupThreadID, uint groupIndex)
+{
+	int2 DTid = tileOrigin + groupThreadID;
+
+	real3 e = LoadClamped(DTid);
+
+	real3 b = LoadClamped(DTid + int2(0, -1));
+	real3 d = LoadClamped(DTid + int2(-1, 0));
+	real3 f = LoadClamped(DTid + int2(1, 0));
+	real3 h = LoadClamped(DTid + int2(0, 1));
+
+	// Luma times 2.
+	real bL = getRCASLuma(b);
+	real dL = getRCASLuma(d);
+	real eL = getRCASLuma(e);
+	real fL = getRCASLuma(f);
+	real hL = getRCASLuma(h);
+
+	Dest[DTid] = RCASFilter(b, d, e, f, h, bL, dL, eL, fL, hL);
+}
+#endif
+
+#if defined(TILED)
+[numthreads(8, 8, 1)] void main(uint3 groupID
+								: SV_GroupID, uint3 groupThreadID
+								: SV_GroupThreadID, uint groupIndex
+								: SV_GroupIndex) {
+	uint tile = Tiles[groupID.x];
+	RCAS(uint2(tile & 0xFFFF, tile >> 16) * 8, groupThreadID.xy, groupIndex);
+}
+#else
+[numthreads(GROUP_SIZE_X, GROUP_SIZE_Y, 1)] void main(uint3 groupID
+													  : SV_GroupID, uint3 groupThreadID
+													  : SV_GroupThreadID, uint groupIndex
+													  : SV_GroupIndex) {
+	RCAS(groupID.xy * uint2(GROUP_SIZE_X, GROUP_SIZE_Y), groupThreadID.xy, groupIndex);
+}
+#endif
@@ -0,0 +1,57 @@
+// Finds the 8x8 tiles RCAS would actually change. Flat areas (sky, fog, untextured surfaces) have almost no local
+// contrast, RCAS leaves them as they are, so only tiles above the threshold are appended for the indirect dispatch.
+// RCASClassifier.h holds a CPU reference of this shader and derives the threshold.
+
+Texture2D<float3> Source : register(t0);
+AppendStructuredBuffer<uint> Tiles : register(u0);
+
+cbuffer RCASClassifyCB : register(b0)
+{
+	uint2 ScreenSize;
+	// Per-channel range from which RCAS may move a texel by half an 8-bit step
+	float ContrastThreshold;
+	float pad0;
+};
+
+// Tile plus the one texel halo RCAS reads around it, per channel. Colours are not negative, so their bits order
+// like the values.
+groupshared uint TileMin[3];
+groupshared uint TileMax[3];
+
+void Accumulate(int2 tileOrigin, uint index)
+{
+	// Clamped exactly like RCAS's taps
+	int2 coord = clamp(tileOrigin + int2(index % 10, index / 10) - 1, 0, (int2)ScreenSize - 1);
+	uint3 color = asuint(Source.Load(int3(coord, 0)));
+	InterlockedMin(TileMin[0], color.r);
+	InterlockedMin(TileMin[1], color.g);
+	InterlockedMin(TileMin[2], color.b);
+	InterlockedMax(TileMax[0], color.r);
+	InterlockedMax(TileMax[1], color.g);
+	InterlockedMax(TileMax[2], color.b);
+}
+
+[numthreads(8, 8, 1)] void main(uint3 groupID
+								: SV_GroupID, uint groupIndex
+								: SV_GroupIndex) {
+	if (groupIndex < 3) {
+		TileMin[groupIndex] = 0xFFFFFFFF;
+		TileMax[groupIndex] = 0;
+	}
+	GroupMemoryBarrierWithGroupSync();
+
+	int2 tileOrigin = groupID.xy * 8;
+
+	// 100 halo texels over 64 threads
+	Accumulate(tileOrigin, groupIndex);
+	if (groupIndex < 36)
+		Accumulate(tileOrigin, groupIndex + 64);
+
+	GroupMemoryBarrierWithGroupSync();
+
+	if (groupIndex == 0) {
+		float3 range = asfloat(uint3(TileMax[0], TileMax[1], TileMax[2])) - asfloat(uint3(TileMin[0], TileMin[1], TileMin[2]));
+		if (max(range.r, max(range.g, range.b)) >= ContrastThreshold)
+			Tiles.Append(groupID.x | (groupID.y << 16));
+	}
+}
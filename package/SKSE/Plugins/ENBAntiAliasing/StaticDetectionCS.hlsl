@@ -0,0 +1,49 @@
+// Reduces a frame to the largest motion vector (in pixels) or the largest colour change against a reference,
+// used to detect when the scene has stopped moving.
+
+#if defined(COMPARE_COLOR)
+Texture2D<float3> Color : register(t0);
+Texture2D<float3> Reference : register(t1);
+#else
+Texture2D<float2> MotionVectors : register(t0);
+#endif
+
+// [0] max motion in pixels, [1] max colour delta, both as float bits which order like uints for positive values
+RWByteAddressBuffer Statistics : register(u0);
+
+cbuffer StaticDetectionCB : register(b0)
+{
+	float2 ScreenSize;
+	float2 pad0;
+};
+
+groupshared uint GroupMax;
+
+[numthreads(8, 8, 1)] void main(uint3 dispatchID
+								: SV_DispatchThreadID, uint groupIndex
+								: SV_GroupIndex) {
+	if (groupIndex == 0)
+		GroupMax = 0;
+	GroupMemoryBarrierWithGroupSync();
+
+	float value = 0.0;
+	if (all(dispatchID.xy < (uint2)ScreenSize)) {
+#if defined(COMPARE_COLOR)
+		float3 delta = abs(Color[dispatchID.xy] - Reference[dispatchID.xy]);
+		value = max(delta.r, max(delta.g, delta.b));
+#else
+		value = length(MotionVectors[dispatchID.xy] * ScreenSize);
+#endif
+	}
+
+	InterlockedMax(GroupMax, asuint(value));
+	GroupMemoryBarrierWithGroupSync();
+
+	if (groupIndex == 0) {
+#if defined(COMPARE_COLOR)
+		Statistics.InterlockedMax(4, GroupMax);
+#else
+		Statistics.InterlockedMax(0, GroupMax);
+#endif
+	}
+}
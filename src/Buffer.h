@@ -2,6 +2,7 @@
 
 #include <DirectXMath.h>
 #include <d3d11.h>
+#include <d3d11_1.h>
 
 #include <Windows.Foundation.h>
 #include <stdio.h>
@@ -9,6 +10,9 @@
 #include <wrl\client.h>
 #include <wrl\wrappers\corewrappers.h>
 
+#include "DirtyRanges.h"
+#include "RingAllocator.h"
+
 template <typename T>
 D3D11_BUFFER_DESC StructuredBufferDesc(uint64_t count, bool uav = true, bool dynamic = false)
 {
@@ -82,6 +86,111 @@ private:
 	D3D11_BUFFER_DESC desc;
 };
 
+// Packs all of a frame's constant data into one dynamic buffer and binds slices of it with D3D11.1 offsets
+class ConstantBufferRing
+{
+public:
+	static constexpr UINT Alignment = RingAllocator::Alignment;
+	static constexpr UINT FrameLatency = RingAllocator::FrameLatency;
+
+	struct Allocation
+	{
+		ID3D11Buffer* buffer = nullptr;
+		UINT firstConstant = 0;
+		UINT numConstants = 0;
+	};
+
+	explicit ConstantBufferRing(UINT a_size) :
+		ring(AlignUp(a_size))
+	{
+		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+		auto ctx = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+		if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+			offsetBinding = options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+		if (offsetBinding)
+			offsetBinding = SUCCEEDED(ctx->QueryInterface(IID_PPV_ARGS(context1.ReleaseAndGetAddressOf())));
+
+		desc = ConstantBufferDesc(ring.GetCapacity(), true);
+		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, resource.ReleaseAndGetAddressOf()));
+
+		D3D11_QUERY_DESC queryDesc{ D3D11_QUERY_EVENT, 0 };
+		for (auto& fence : fences)
+			DX::ThrowIfFailed(device->CreateQuery(&queryDesc, fence.ReleaseAndGetAddressOf()));
+	}
+
+	static constexpr UINT AlignUp(size_t a_size)
+	{
+		return RingAllocator::AlignUp(a_size);
+	}
+
+	// Retires frames whose fence has been reached, freeing their part of the ring
+	void BeginFrame()
+	{
+		ID3D11DeviceContext* ctx = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+		ring.BeginFrame([&](uint32_t a_fence) {
+			return ctx->GetData(fences[a_fence].Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+		});
+	}
+
+	// Issues the fence for everything allocated since BeginFrame
+	void EndFrame()
+	{
+		ID3D11DeviceContext* ctx = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+		ctx->End(fences[ring.EndFrame()].Get());
+	}
+
+	Allocation Allocate(void const* src_data, size_t data_size)
+	{
+		ID3D11DeviceContext* ctx = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+		data_size = std::min<size_t>(data_size, desc.ByteWidth);
+		UINT size = AlignUp(data_size);
+
+		D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+		UINT offset = offsetBinding ? ring.Reserve(size) : RingAllocator::Full;
+		if (offset == RingAllocator::Full) {
+			// Out of space, or no offset binding: let the driver rename the buffer and start over
+			mapType = D3D11_MAP_WRITE_DISCARD;
+			ring.Reset();
+			offset = offsetBinding ? ring.Reserve(size) : 0;
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mapped_buffer{};
+		DX::ThrowIfFailed(ctx->Map(resource.Get(), 0u, mapType, 0u, &mapped_buffer));
+		memcpy((uint8_t*)mapped_buffer.pData + offset, src_data, data_size);
+		ctx->Unmap(resource.Get(), 0);
+
+		return { resource.Get(), offset / 16, size / 16 };
+	}
+
+	template <typename T>
+	Allocation Allocate(T const& src_data)
+	{
+		return Allocate(&src_data, sizeof(T));
+	}
+
+	void CSSetConstantBuffer(UINT a_slot, Allocation const& a_allocation)
+	{
+		ID3D11Buffer* buffers[1] = { a_allocation.buffer };
+		if (offsetBinding) {
+			context1->CSSetConstantBuffers1(a_slot, 1, buffers, &a_allocation.firstConstant, &a_allocation.numConstants);
+		} else {
+			ID3D11DeviceContext* ctx = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+			ctx->CSSetConstantBuffers(a_slot, 1, buffers);
+		}
+	}
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Buffer> resource;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context1;
+	D3D11_BUFFER_DESC desc;
+	bool offsetBinding = false;
+
+	RingAllocator ring;
+	Microsoft::WRL::ComPtr<ID3D11Query> fences[FrameLatency];
+};
+
 template <typename T>
 D3D11_BUFFER_DESC StructuredBufferDesc(UINT a_count = 1, bool cpu_access = true)
 {
@@ -91,7 +200,7 @@ D3D11_BUFFER_DESC StructuredBufferDesc(UINT a_count = 1, bool cpu_access = true)
 	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 	if (!cpu_access)
 		desc.BindFlags = desc.BindFlags | D3D11_BIND_UNORDERED_ACCESS;
-	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.CPUAccessFlags = cpu_access ? D3D11_CPU_ACCESS_WRITE : 0;
 	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
 	desc.StructureByteStride = sizeof(T);
 	desc.ByteWidth = sizeof(T) * a_count;
@@ -138,27 +247,147 @@ public:
 		uavs.push_back(uav);
 	}
 
-	void Update(void const* src_data, [[maybe_unused]] size_t data_size)
+	bool IsDynamic() const { return desc.Usage == D3D11_USAGE_DYNAMIC; }
+
+	// Uploads the first data_size bytes of the buffer
+	void Update(void const* src_data, size_t data_size)
+	{
+		data_size = std::min<size_t>(data_size, desc.ByteWidth);
+		if (IsDynamic()) {
+			ID3D11DeviceContext* ctx = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+			D3D11_MAPPED_SUBRESOURCE mapped_buffer{};
+			ZeroMemory(&mapped_buffer, sizeof(D3D11_MAPPED_SUBRESOURCE));
+			DX::ThrowIfFailed(ctx->Map(resource.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &mapped_buffer));
+			memcpy(mapped_buffer.pData, src_data, data_size);
+			ctx->Unmap(resource.Get(), 0);
+			appendOffset = (UINT)data_size;
+		} else {
+			UpdateRange(src_data, 0, data_size);
+			Flush();
+		}
+	}
+
+	template <typename T>
+	void UpdateList(T const& src_data, std::int64_t count)
 	{
+		Update(&src_data, sizeof(T) * count);
+	}
+
+	// Records a partial write to a default-usage buffer, uploaded on the next Flush
+	void UpdateRange(void const* src_data, size_t offset, size_t data_size)
+	{
+		if (offset >= desc.ByteWidth || data_size == 0)
+			return;
+		data_size = std::min<size_t>(data_size, desc.ByteWidth - offset);
+
+		if (shadow.empty())
+			shadow.resize(desc.ByteWidth);
+		memcpy(shadow.data() + offset, src_data, data_size);
+
+		dirtyRanges.Mark((UINT)offset, (UINT)(offset + data_size));
+	}
+
+	template <typename T>
+	void UpdateElements(T const* src_data, UINT first, UINT num)
+	{
+		UpdateRange(src_data, (size_t)first * sizeof(T), (size_t)num * sizeof(T));
+	}
+
+	// Uploads all dirty ranges. Small uploads go through UpdateSubresource, which lets the driver buffer them, larger
+	// ones are staged through a ring of upload buffers so the CPU never waits on a copy still reading one of them.
+	void Flush()
+	{
+		if (dirtyRanges.Empty())
+			return;
+
 		ID3D11DeviceContext* ctx = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+		if (dirtyRanges.GetBytes() > SmallUpload && MapUpload(ctx)) {
+			auto& upload = uploads[uploadIndex];
+			for (auto& range : dirtyRanges.Get()) {
+				D3D11_BOX box{ range.begin, 0, 0, range.end, 1, 1 };
+				ctx->CopySubresourceRegion(resource.Get(), 0, range.begin, 0, 0, upload.Get(), 0, &box);
+			}
+			uploadIndex = (uploadIndex + 1) % UploadCount;
+		} else {
+			for (auto& range : dirtyRanges.Get()) {
+				D3D11_BOX box{ range.begin, 0, 0, range.end, 1, 1 };
+				ctx->UpdateSubresource(resource.Get(), 0, &box, shadow.data() + range.begin, 0, 0);
+			}
+		}
+
+		dirtyRanges.Clear();
+	}
+
+	// Writes after the data already in a dynamic buffer without disturbing it, returns the first element written
+	UINT Append(void const* src_data, size_t data_size)
+	{
+		ID3D11DeviceContext* ctx = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+		data_size = std::min<size_t>(data_size, desc.ByteWidth);
+
+		D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+		if (appendOffset + data_size > desc.ByteWidth) {
+			mapType = D3D11_MAP_WRITE_DISCARD;
+			appendOffset = 0;
+		}
+
 		D3D11_MAPPED_SUBRESOURCE mapped_buffer{};
-		ZeroMemory(&mapped_buffer, sizeof(D3D11_MAPPED_SUBRESOURCE));
-		DX::ThrowIfFailed(ctx->Map(resource.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &mapped_buffer));
-		memcpy(mapped_buffer.pData, src_data, desc.ByteWidth);
+		DX::ThrowIfFailed(ctx->Map(resource.Get(), 0u, mapType, 0u, &mapped_buffer));
+		memcpy((uint8_t*)mapped_buffer.pData + appendOffset, src_data, data_size);
 		ctx->Unmap(resource.Get(), 0);
+
+		UINT first = appendOffset / desc.StructureByteStride;
+		appendOffset += (UINT)data_size;
+		return first;
 	}
+
 	template <typename T>
-	void UpdateList(T const& src_data, std::int64_t count)
+	UINT AppendList(T const* src_data, UINT num)
 	{
-		Update(&src_data, sizeof(T) * count);
+		return Append(src_data, sizeof(T) * num);
 	}
+
 	std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> srvs;
 	std::vector<Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView>> uavs;
 
 private:
+	// Dirty bytes up to this are uploaded with UpdateSubresource
+	static constexpr uint64_t SmallUpload = 64 * 1024;
+	// Upload buffers cycled through, each a full copy of the buffer, so one is free again by the time it comes round
+	static constexpr UINT UploadCount = 3;
+
+	// Copies the dirty ranges into the next upload buffer, false if the GPU is still copying out of it
+	bool MapUpload(ID3D11DeviceContext* a_context)
+	{
+		auto& upload = uploads[uploadIndex];
+		if (!upload) {
+			auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+			D3D11_BUFFER_DESC uploadDesc{};
+			uploadDesc.Usage = D3D11_USAGE_STAGING;
+			uploadDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			uploadDesc.ByteWidth = desc.ByteWidth;
+			DX::ThrowIfFailed(device->CreateBuffer(&uploadDesc, nullptr, upload.ReleaseAndGetAddressOf()));
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mapped_buffer{};
+		if (FAILED(a_context->Map(upload.Get(), 0u, D3D11_MAP_WRITE, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped_buffer)))
+			return false;
+		for (auto& range : dirtyRanges.Get())
+			memcpy((uint8_t*)mapped_buffer.pData + range.begin, shadow.data() + range.begin, range.end - range.begin);
+		a_context->Unmap(upload.Get(), 0);
+		return true;
+	}
+
 	Microsoft::WRL::ComPtr<ID3D11Buffer> resource;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> uploads[UploadCount];
+	UINT uploadIndex = 0;
 	D3D11_BUFFER_DESC desc;
 	UINT count;
+
+	// Only holds the bytes written through UpdateRange, the rest may be initial data or written by the GPU
+	std::vector<uint8_t> shadow;
+	DirtyRanges dirtyRanges{ DirtyRanges::ExactGap };
+	UINT appendOffset = 0;
 };
 
 class Buffer
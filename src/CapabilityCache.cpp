@@ -0,0 +1,97 @@
+#include "CapabilityCache.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "INITokenizer.h"
+
+std::optional<bool> CapabilityCache::GetDLSS(std::string_view a_adapter)
+{
+	std::lock_guard<std::mutex> lk(lock);
+	Load();
+	auto entry = dlss.find(a_adapter);
+	if (entry == dlss.end())
+		return std::nullopt;
+	return entry->second;
+}
+
+void CapabilityCache::SetDLSS(std::string_view a_adapter, bool a_supported)
+{
+	std::lock_guard<std::mutex> lk(lock);
+	Load();
+	auto [entry, inserted] = dlss.try_emplace(std::string(a_adapter), a_supported);
+	if (!inserted && entry->second == a_supported)
+		return;
+	entry->second = a_supported;
+
+	// Entries of the same adapter from earlier boots can never match again
+	auto name = GetAdapterName(a_adapter);
+	std::erase_if(dlss, [&](const auto& a_entry) { return a_entry.first != a_adapter && GetAdapterName(a_entry.first) == name; });
+	Save();
+}
+
+bool CapabilityCache::ShouldLoadStreamline(std::string_view a_expectedAdapter)
+{
+	if (GetDLSS(a_expectedAdapter) != false)
+		return true;
+
+	std::lock_guard<std::mutex> lk(lock);
+	skipped = std::string(a_expectedAdapter);
+	return false;
+}
+
+bool CapabilityCache::CheckDeviceAdapter(std::string_view a_adapter)
+{
+	std::lock_guard<std::mutex> lk(lock);
+	if (!skipped || *skipped == a_adapter)
+		return false;
+
+	logger::info("[CapabilityCache] The device was created on {} instead of {}, loading Streamline after all", a_adapter, *skipped);
+	if (dlss.erase(*skipped))
+		Save();
+	skipped.reset();
+	return true;
+}
+
+std::string_view CapabilityCache::GetAdapterName(std::string_view a_adapter)
+{
+	return a_adapter.substr(0, a_adapter.find('@'));
+}
+
+void CapabilityCache::Load()
+{
+	if (loaded)
+		return;
+	loaded = true;
+
+	if (std::ifstream file{ path }) {
+		std::stringstream text;
+		text << file.rdbuf();
+		Parse(text.str(), dlss);
+	}
+}
+
+void CapabilityCache::Save()
+{
+	auto text = Serialize(dlss);
+
+	std::ofstream file{ path, std::ios::trunc };
+	if (!file || !file.write(text.data(), text.size()))
+		logger::warn("[CapabilityCache] Failed to write {}", path.string());
+}
+
+void CapabilityCache::Parse(std::string_view a_text, Entries& a_entries)
+{
+	Util::ForEachINIValue(a_text, [&](std::string_view a_section, std::string_view a_key, std::string_view a_value) {
+		if (a_section == "DLSS" && !a_key.empty() && (a_value == "0" || a_value == "1"))
+			a_entries.insert_or_assign(std::string(a_key), a_value == "1");
+	});
+}
+
+std::string CapabilityCache::Serialize(const Entries& a_entries)
+{
+	std::string output = "# Whether DLSS is available, per vendor, device, driver version and LUID\n# Delete this file to probe again\n[DLSS]\n";
+	for (auto& [adapter, supported] : a_entries)
+		output.append(adapter).append(supported ? " = 1\n" : " = 0\n");
+	return output;
+}
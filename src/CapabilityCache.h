@@ -0,0 +1,53 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Remembers whether DLSS was available per adapter, so setups known not to support it never load Streamline. Keys are
+// Util::GetAdapterKey with the LUID, e.g. 10DE-2684-32.0.15.6094@00000000-0000D2C4, which tells identical adapters
+// apart. LUIDs change every boot, so entries are only reused until the next reboot and older ones of the same adapter
+// are replaced.
+class CapabilityCache
+{
+public:
+	static CapabilityCache* GetSingleton()
+	{
+		static CapabilityCache singleton;
+		return &singleton;
+	}
+
+	using Entries = std::map<std::string, bool, std::less<>>;
+
+	std::filesystem::path path = L"Data/SKSE/Plugins/ENBAntiAliasing/Capabilities.ini";
+
+	// Unset when a_adapter was never probed
+	std::optional<bool> GetDLSS(std::string_view a_adapter);
+	// Only touches the file when the stored value changes
+	void SetDLSS(std::string_view a_adapter, bool a_supported);
+
+	// Before the device exists, with the adapter the game is expected to create it on. False when DLSS is known to be
+	// unavailable there, Streamline then is not loaded.
+	bool ShouldLoadStreamline(std::string_view a_expectedAdapter);
+	// Once the game creates its device. True when Streamline was skipped for another adapter than a_adapter, as on
+	// hybrid laptops, and has to be loaded now. The entry behind the skip is dropped so later launches do not repeat it.
+	bool CheckDeviceAdapter(std::string_view a_adapter);
+
+	static void Parse(std::string_view a_text, Entries& a_entries);
+	static std::string Serialize(const Entries& a_entries);
+
+private:
+	void Load();
+	void Save();
+	// The key without its LUID
+	static std::string_view GetAdapterName(std::string_view a_adapter);
+
+	std::mutex lock;
+	bool loaded = false;
+	Entries dlss;
+	// Adapter Streamline was skipped for
+	std::optional<std::string> skipped;
+};
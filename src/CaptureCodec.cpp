@@ -0,0 +1,35 @@
+#include "CaptureCodec.h"
+
+namespace CaptureCodec
+{
+	void Encode(Codec a_codec, std::span<const uint8_t> a_data, std::vector<uint8_t>& a_out, const PlaneCodec::Layout& a_layout, uint32_t a_threads)
+	{
+		switch (a_codec) {
+		case Codec::kPlane:
+			if (!PlaneCodec::Encode(a_data, a_layout, a_out, a_threads))
+				a_out.insert(a_out.end(), a_data.begin(), a_data.end());
+			break;
+		default:
+			a_out.insert(a_out.end(), a_data.begin(), a_data.end());
+			break;
+		}
+	}
+
+	bool Decode(Codec a_codec, std::span<const uint8_t> a_data, uint64_t a_rawSize, std::vector<uint8_t>& a_out, uint32_t a_threads)
+	{
+		a_out.clear();
+		a_out.reserve(a_rawSize);
+
+		switch (a_codec) {
+		case Codec::kNone:
+			if (a_data.size() != a_rawSize)
+				return false;
+			a_out.assign(a_data.begin(), a_data.end());
+			return true;
+		case Codec::kPlane:
+			return PlaneCodec::Decode(a_data, a_rawSize, a_out, a_threads);
+		default:
+			return false;
+		}
+	}
+}
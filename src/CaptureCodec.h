@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "PlaneCodec.h"
+
+// Lossless codecs for capture chunks. Portable, shared by the plugin and CaptureTool.
+namespace CaptureCodec
+{
+	enum class Codec : uint32_t
+	{
+		kNone,
+		// PlaneCodec, needs the chunk's layout and is stored raw without one. 1 was a byte run length codec no
+		// capture was written with.
+		kPlane = 2
+	};
+
+	// Appends the encoded a_data to a_out. a_threads is only used by kPlane, zero uses every hardware thread.
+	void Encode(Codec a_codec, std::span<const uint8_t> a_data, std::vector<uint8_t>& a_out, const PlaneCodec::Layout& a_layout = {}, uint32_t a_threads = 0);
+	// Replaces a_out with exactly a_rawSize decoded bytes, false when a_data is corrupt
+	bool Decode(Codec a_codec, std::span<const uint8_t> a_data, uint64_t a_rawSize, std::vector<uint8_t>& a_out, uint32_t a_threads = 0);
+}
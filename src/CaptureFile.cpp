@@ -0,0 +1,245 @@
+#include "CaptureFile.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace CaptureFile
+{
+	static uint64_t AlignUp(uint64_t a_value)
+	{
+		return (a_value + ChunkAlignment - 1) & ~(ChunkAlignment - 1);
+	}
+
+	bool Writer::Open(const std::filesystem::path& a_path)
+	{
+		Close();
+
+#ifdef _WIN32
+		if (_wfopen_s(&file, a_path.c_str(), L"wb") != 0)
+			file = nullptr;
+#else
+		file = std::fopen(a_path.c_str(), "wb");
+#endif
+		if (!file)
+			return false;
+
+		offset = 0;
+		index.clear();
+
+		FileHeader header{};
+		std::memcpy(header.magic, Magic, sizeof(Magic));
+		header.version = Version;
+		header.chunkAlignment = (uint32_t)ChunkAlignment;
+		return WritePadded(&header, sizeof(header));
+	}
+
+	bool Writer::WritePadded(const void* a_data, std::size_t a_size)
+	{
+		static constexpr uint8_t zeros[ChunkAlignment]{};
+
+		auto padding = AlignUp(a_size) - a_size;
+		if (std::fwrite(a_data, 1, a_size, file) != a_size || std::fwrite(zeros, 1, padding, file) != padding)
+			return false;
+		offset += a_size + padding;
+		return true;
+	}
+
+	bool Writer::Write(ChunkType a_type, uint64_t a_frame, std::span<const uint8_t> a_data, Codec a_codec, uint32_t a_width, uint32_t a_height, uint32_t a_format, uint32_t a_pixelSize)
+	{
+		if (!file)
+			return false;
+
+		if (a_codec != Codec::kNone) {
+			encoded.clear();
+			CaptureCodec::Encode(a_codec, a_data, encoded, { a_width, a_height, a_format, a_pixelSize }, threads);
+			if (encoded.size() >= a_data.size())
+				a_codec = Codec::kNone;
+		}
+		auto payload = a_codec == Codec::kNone ? a_data : std::span<const uint8_t>(encoded);
+
+		ChunkHeader header{};
+		header.type = (uint32_t)a_type;
+		header.codec = (uint32_t)a_codec;
+		header.frame = a_frame;
+		header.storedSize = payload.size();
+		header.rawSize = a_data.size();
+		header.width = a_width;
+		header.height = a_height;
+		header.format = a_format;
+		header.pixelSize = a_pixelSize;
+
+		auto chunkOffset = offset;
+		if (!WritePadded(&header, sizeof(header)) || !WritePadded(payload.data(), payload.size()))
+			return false;
+
+		index.push_back({ chunkOffset, a_frame, (uint32_t)a_type, 0 });
+		return true;
+	}
+
+	bool Writer::Close()
+	{
+		if (!file)
+			return false;
+
+		// Write appends to index, so it is moved out first
+		auto entries = std::move(index);
+		auto indexOffset = offset;
+		bool written = Write(ChunkType::kIndex, 0, { reinterpret_cast<const uint8_t*>(entries.data()), entries.size() * sizeof(IndexEntry) });
+
+		Footer footer{ indexOffset, entries.size(), {} };
+		std::memcpy(footer.magic, FooterMagic, sizeof(FooterMagic));
+		written = written && std::fwrite(&footer, 1, sizeof(footer), file) == sizeof(footer);
+
+		written = std::fclose(file) == 0 && written;
+		file = nullptr;
+		index.clear();
+		return written;
+	}
+
+	bool Reader::Open(const std::filesystem::path& a_path)
+	{
+		Close();
+
+#ifdef _WIN32
+		file = CreateFileW(a_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			file = nullptr;
+			return false;
+		}
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			Close();
+			return false;
+		}
+		size = (uint64_t)fileSize.QuadPart;
+
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		data = mapping ? static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+		int descriptor = open(a_path.c_str(), O_RDONLY);
+		if (descriptor < 0)
+			return false;
+
+		struct stat status{};
+		if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+			size = (uint64_t)status.st_size;
+			auto view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			data = view == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(view);
+		}
+		// The mapping keeps the file alive on its own
+		close(descriptor);
+#endif
+
+		if (!data) {
+			Close();
+			return false;
+		}
+
+		FileHeader header;
+		if (size < sizeof(header)) {
+			Close();
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+		if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version || header.chunkAlignment != ChunkAlignment) {
+			Close();
+			return false;
+		}
+
+		indexed = ReadIndex();
+		if (!indexed)
+			ScanChunks();
+		return true;
+	}
+
+	void Reader::Close()
+	{
+#ifdef _WIN32
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file)
+			CloseHandle(file);
+		mapping = nullptr;
+		file = nullptr;
+#else
+		if (data)
+			munmap(const_cast<uint8_t*>(data), size);
+#endif
+		data = nullptr;
+		size = 0;
+		chunks.clear();
+		indexed = false;
+	}
+
+	bool Reader::AddChunk(uint64_t a_offset)
+	{
+		if (a_offset % ChunkAlignment || a_offset > size || size - a_offset < sizeof(ChunkHeader))
+			return false;
+
+		auto header = reinterpret_cast<const ChunkHeader*>(data + a_offset);
+		auto payloadOffset = a_offset + sizeof(ChunkHeader);
+		if (header->storedSize > size - payloadOffset)
+			return false;
+
+		chunks.push_back({ header, { data + payloadOffset, (std::size_t)header->storedSize } });
+		return true;
+	}
+
+	bool Reader::ReadIndex()
+	{
+		Footer footer;
+		if (size < sizeof(FileHeader) + sizeof(footer))
+			return false;
+		std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+		if (std::memcmp(footer.magic, FooterMagic, sizeof(FooterMagic)) != 0)
+			return false;
+
+		if (!AddChunk(footer.indexOffset))
+			return false;
+		auto indexChunk = chunks.back();
+		chunks.clear();
+		// The count is checked against the payload before multiplying, a corrupt one could wrap around to match it
+		if (indexChunk.GetType() != ChunkType::kIndex || indexChunk.header->codec != (uint32_t)Codec::kNone ||
+			footer.chunkCount > indexChunk.data.size() / sizeof(IndexEntry) || indexChunk.data.size() != footer.chunkCount * sizeof(IndexEntry))
+			return false;
+
+		auto entries = reinterpret_cast<const IndexEntry*>(indexChunk.data.data());
+		for (uint64_t i = 0; i < footer.chunkCount; i++) {
+			if (!AddChunk(entries[i].offset) || chunks.back().header->type != entries[i].type) {
+				chunks.clear();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Reader::ScanChunks()
+	{
+		// Stops at the first chunk cut short, everything before it is intact
+		auto offset = AlignUp(sizeof(FileHeader));
+		while (AddChunk(offset)) {
+			auto& chunk = chunks.back();
+			if (chunk.GetType() == ChunkType::kIndex) {
+				chunks.pop_back();
+				break;
+			}
+			offset += sizeof(ChunkHeader) + AlignUp(chunk.header->storedSize);
+		}
+	}
+
+	bool Reader::Decode(const Chunk& a_chunk, std::vector<uint8_t>& a_out)
+	{
+		return CaptureCodec::Decode((Codec)a_chunk.header->codec, a_chunk.data, a_chunk.header->rawSize, a_out);
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "CaptureCodec.h"
+
+// Container for captured upscaler inputs. A file header is followed by chunks, each a fixed header and a payload, both
+// starting on ChunkAlignment so uncompressed planes can be used straight from a memory mapping. Closing the file
+// appends an index of every chunk and a footer pointing at it, a capture cut short has neither and is read by walking
+// the chunks instead. Chunks of one frame need not be adjacent, the frame number ties them together.
+// Portable, the reader and CaptureTool build on Linux.
+namespace CaptureFile
+{
+	using CaptureCodec::Codec;
+
+	inline constexpr char Magic[8] = { 'U', 'P', 'S', 'C', 'A', 'P', 'T', 'R' };
+	inline constexpr char FooterMagic[8] = { 'U', 'P', 'S', 'I', 'N', 'D', 'E', 'X' };
+	inline constexpr uint32_t Version = 1;
+	inline constexpr uint64_t ChunkAlignment = 64;
+
+	constexpr uint32_t FourCC(char a_a, char a_b, char a_c, char a_d)
+	{
+		return (uint32_t)(uint8_t)a_a | (uint32_t)(uint8_t)a_b << 8 | (uint32_t)(uint8_t)a_c << 16 | (uint32_t)(uint8_t)a_d << 24;
+	}
+
+	enum class ChunkType : uint32_t
+	{
+		// FrameInfo, one per eye
+		kFrame = FourCC('F', 'R', 'M', 'E'),
+		// Planes, rows tightly packed, format is the DXGI_FORMAT of the game's texture
+		kColor = FourCC('C', 'O', 'L', 'R'),
+		kDepth = FourCC('D', 'P', 'T', 'H'),
+		kMotionVectors = FourCC('M', 'V', 'E', 'C'),
+		kMask = FourCC('M', 'A', 'S', 'K'),
+		// IndexEntry array, written on close
+		kIndex = FourCC('I', 'N', 'D', 'X')
+	};
+
+	struct FileHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t chunkAlignment;
+	};
+
+	struct ChunkHeader
+	{
+		uint32_t type;
+		uint32_t codec;
+		uint64_t frame;
+		// Payload bytes in the file, and after decoding
+		uint64_t storedSize;
+		uint64_t rawSize;
+		// Planes only
+		uint32_t width;
+		uint32_t height;
+		uint32_t format;
+		uint32_t pixelSize;
+		uint32_t reserved[4];
+	};
+
+	struct IndexEntry
+	{
+		uint64_t offset;
+		uint64_t frame;
+		uint32_t type;
+		uint32_t reserved;
+	};
+
+	struct Footer
+	{
+		uint64_t indexOffset;
+		uint64_t chunkCount;
+		char magic[8];
+	};
+
+	// Camera state for one eye, the same inputs Streamline's constants are built from. Matrices are row major as the
+	// game keeps them.
+	struct FrameInfo
+	{
+		float viewToClip[16];
+		float viewProjUnjittered[16];
+		float previousViewProjUnjittered[16];
+		float position[3];
+		float forward[3];
+		float up[3];
+		float right[3];
+		float jitter[2];
+		float cameraNear;
+		float cameraFar;
+		float verticalFOV;
+		float aspectRatio;
+		// Seconds since the previous frame
+		float frameTime;
+		uint32_t eye;
+		uint32_t eyeCount;
+		// Eye rectangle within the planes
+		uint32_t left;
+		uint32_t top;
+		uint32_t width;
+		uint32_t height;
+		uint32_t reset;
+		// Upscaling::UpscaleMethod that ran
+		uint32_t method;
+		uint32_t reserved[5];
+	};
+
+	static_assert(sizeof(FileHeader) == 16 && sizeof(ChunkHeader) == ChunkAlignment && sizeof(IndexEntry) == 24 && sizeof(Footer) == 24);
+	static_assert(sizeof(FrameInfo) % 16 == 0);
+
+	class Writer
+	{
+	public:
+		~Writer() { Close(); }
+
+		bool Open(const std::filesystem::path& a_path);
+		// Appends one chunk, stored raw whenever a_codec does not make it smaller
+		bool Write(ChunkType a_type, uint64_t a_frame, std::span<const uint8_t> a_data, Codec a_codec = Codec::kNone,
+			uint32_t a_width = 0, uint32_t a_height = 0, uint32_t a_format = 0, uint32_t a_pixelSize = 0);
+		// Writes the index and footer, the file is complete once this returns true
+		bool Close();
+
+		bool IsOpen() const { return file != nullptr; }
+		uint64_t GetSize() const { return offset; }
+
+		// Threads a chunk is encoded with, zero for every hardware thread
+		uint32_t threads = 0;
+
+	private:
+		bool WritePadded(const void* a_data, std::size_t a_size);
+
+		std::FILE* file = nullptr;
+		uint64_t offset = 0;
+		std::vector<IndexEntry> index;
+		std::vector<uint8_t> encoded;
+	};
+
+	struct Chunk
+	{
+		const ChunkHeader* header;
+		std::span<const uint8_t> data;
+
+		ChunkType GetType() const { return (ChunkType)header->type; }
+	};
+
+	// Maps a capture read only, chunks point into the mapping and stay valid until Close
+	class Reader
+	{
+	public:
+		~Reader() { Close(); }
+
+		bool Open(const std::filesystem::path& a_path);
+		void Close();
+
+		// In file order
+		const std::vector<Chunk>& GetChunks() const { return chunks; }
+		// False when the index was missing and the chunks were found by walking the file
+		bool HasIndex() const { return indexed; }
+
+		// Decodes into a_out, false when the chunk is corrupt or uses an unknown codec
+		static bool Decode(const Chunk& a_chunk, std::vector<uint8_t>& a_out);
+
+	private:
+		bool ReadIndex();
+		void ScanChunks();
+		bool AddChunk(uint64_t a_offset);
+
+		const uint8_t* data = nullptr;
+		uint64_t size = 0;
+		std::vector<Chunk> chunks;
+		bool indexed = false;
+
+#ifdef _WIN32
+		void* file = nullptr;
+		void* mapping = nullptr;
+#endif
+	};
+}
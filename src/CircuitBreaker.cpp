@@ -0,0 +1,47 @@
+#include "CircuitBreaker.h"
+
+bool CircuitBreaker::Allow(uint64_t a_frame)
+{
+	switch (GetState()) {
+	case State::kTripped:
+		if (a_frame < GetRetryFrame())
+			return false;
+		state = State::kRetrying;
+		return true;
+	default:
+		return true;
+	}
+}
+
+void CircuitBreaker::Record(uint64_t a_frame, bool a_success)
+{
+	if (a_success) {
+		if (GetState() == State::kRetrying)
+			backoff = 0;
+		consecutiveFailures = 0;
+		state = State::kHealthy;
+		return;
+	}
+
+	// A single failed retry is enough, the backend already failed before
+	if (GetState() == State::kRetrying || ++consecutiveFailures >= thresholds.failures)
+		Trip(a_frame);
+}
+
+void CircuitBreaker::Reset()
+{
+	state = State::kHealthy;
+	trips = 0;
+	retryFrame = 0;
+	consecutiveFailures = 0;
+	backoff = 0;
+}
+
+void CircuitBreaker::Trip(uint64_t a_frame)
+{
+	backoff = backoff ? std::min(backoff * 2, thresholds.maxBackoff) : thresholds.initialBackoff;
+	retryFrame = a_frame + backoff;
+	trips++;
+	consecutiveFailures = 0;
+	state = State::kTripped;
+}
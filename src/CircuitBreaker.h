@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+
+// Tracks the health of an upscaling backend. After enough consecutive failures it trips and the game's TAA is used,
+// then the backend is retried once per backoff period, which doubles on every failed retry.
+class CircuitBreaker
+{
+public:
+	enum class State
+	{
+		kHealthy,
+		kTripped,
+		kRetrying
+	};
+
+	struct Thresholds
+	{
+		// Consecutive failed frames before tripping
+		uint failures = 3;
+		// Frames to wait before the first retry, and the most it grows to
+		uint64_t initialBackoff = 120;
+		uint64_t maxBackoff = 7680;
+	};
+
+	Thresholds thresholds;
+
+	// Whether the backend should run this frame, moves a tripped breaker to kRetrying once its backoff has elapsed
+	bool Allow(uint64_t a_frame);
+	void Record(uint64_t a_frame, bool a_success);
+	void Reset();
+
+	// Safe to call from any thread
+	State GetState() const { return state.load(std::memory_order_relaxed); }
+	uint GetTrips() const { return trips.load(std::memory_order_relaxed); }
+	uint64_t GetRetryFrame() const { return retryFrame.load(std::memory_order_relaxed); }
+
+private:
+	void Trip(uint64_t a_frame);
+
+	std::atomic<State> state = State::kHealthy;
+	std::atomic<uint> trips = 0;
+	std::atomic<uint64_t> retryFrame = 0;
+	uint consecutiveFailures = 0;
+	uint64_t backoff = 0;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+
+// Bounded single-producer/single-consumer ring. Push and Pop never block; Push fails when full.
+template <class T, std::size_t Capacity>
+class CommandQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	bool Push(const T& a_value)
+	{
+		auto tail = writeIndex.load(std::memory_order_relaxed);
+		if (tail - cachedReadIndex == Capacity) {
+			cachedReadIndex = readIndex.load(std::memory_order_acquire);
+			if (tail - cachedReadIndex == Capacity)
+				return false;
+		}
+		items[tail & (Capacity - 1)] = a_value;
+		writeIndex.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Pop(T& a_value)
+	{
+		auto head = readIndex.load(std::memory_order_relaxed);
+		if (head == cachedWriteIndex) {
+			cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+			if (head == cachedWriteIndex)
+				return false;
+		}
+		a_value = items[head & (Capacity - 1)];
+		readIndex.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	T items[Capacity];
+
+	// Producer and consumer indices are padded onto separate cache lines to avoid false sharing
+	std::atomic<std::size_t> writeIndex = 0;
+	std::size_t cachedReadIndex = 0;
+	char pad0[64 - 2 * sizeof(std::size_t)];
+
+	std::atomic<std::size_t> readIndex = 0;
+	std::size_t cachedWriteIndex = 0;
+	char pad1[64 - 2 * sizeof(std::size_t)];
+};
@@ -0,0 +1,193 @@
+#include "ConfigService.h"
+
+#include <fstream>
+#include <vector>
+
+uint32_t ConfigService::Register(const std::filesystem::path& a_path, LoadCallback a_onLoad, bool a_watch)
+{
+	std::lock_guard<std::mutex> lk(lock);
+	auto& file = files.emplace_back();
+	file.path = a_path;
+	file.onLoad = std::move(a_onLoad);
+	file.watch = a_watch;
+	// Only edits made after this count as changes
+	file.knownWriteTime = GetWriteTime(a_path);
+	return (uint32_t)files.size() - 1;
+}
+
+void ConfigService::Start()
+{
+	if (worker.joinable())
+		return;
+	worker = std::jthread([this](std::stop_token a_stop) { Run(a_stop); });
+}
+
+void ConfigService::Stop()
+{
+	if (!worker.joinable())
+		return;
+	worker.request_stop();
+	condition.notify_all();
+	worker.join();
+}
+
+void ConfigService::RequestLoad(uint32_t a_file)
+{
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		files[a_file].pendingLoad = true;
+	}
+	condition.notify_all();
+}
+
+void ConfigService::RequestSave(uint32_t a_file, std::string a_text)
+{
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		auto& file = files[a_file];
+		file.pendingSave = std::move(a_text);
+		file.saveDeadline = std::chrono::steady_clock::now() + saveDelay;
+	}
+	condition.notify_all();
+}
+
+void ConfigService::Run(std::stop_token a_stop)
+{
+	struct Work
+	{
+		File* file = nullptr;
+		bool load = false;
+		std::optional<std::string> save;
+	};
+
+	auto nextPoll = std::chrono::steady_clock::now();
+	std::vector<Work> work;
+
+	// The pass that sees the stop request still writes pending saves
+	for (bool stopping = false; !stopping;) {
+		{
+			std::unique_lock<std::mutex> lk(lock);
+			auto wakeTime = nextPoll;
+			for (auto& file : files) {
+				if (file.pendingSave)
+					wakeTime = std::min(wakeTime, file.saveDeadline);
+			}
+
+			condition.wait_until(lk, a_stop, wakeTime, [&] {
+				auto now = std::chrono::steady_clock::now();
+				return std::any_of(files.begin(), files.end(), [&](const File& a_file) {
+					return a_file.pendingLoad || (a_file.pendingSave && now >= a_file.saveDeadline);
+				});
+			});
+
+			stopping = a_stop.stop_requested();
+			auto now = std::chrono::steady_clock::now();
+			work.clear();
+			for (auto& file : files) {
+				auto& item = work.emplace_back();
+				item.file = &file;
+				if (file.pendingSave && (stopping || now >= file.saveDeadline))
+					item.save = std::exchange(file.pendingSave, std::nullopt);
+
+				// A save overwrites the file with what is in memory anyway, loading it first would only revert edits
+				if (std::exchange(file.pendingLoad, false)) {
+					if (file.pendingSave || item.save)
+						logger::info("[Config] Not loading {}, a save is pending", file.path.string());
+					else
+						item.load = true;
+				}
+			}
+		}
+
+		for (auto& item : work) {
+			if (item.save)
+				Save(*item.file, *item.save);
+			if (item.load && !stopping)
+				Load(*item.file);
+		}
+
+		if (stopping || std::chrono::steady_clock::now() < nextPoll)
+			continue;
+
+		// A single stat per file and interval, a file is only parsed when someone else touched it
+		for (auto& item : work) {
+			auto& file = *item.file;
+			if (!file.watch || item.load)
+				continue;
+
+			auto writeTime = GetWriteTime(file.path);
+			if (!writeTime || writeTime == file.knownWriteTime)
+				continue;
+
+			bool saving;
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				saving = file.pendingSave.has_value();
+			}
+			if (saving)
+				continue;
+
+			logger::info("[Config] {} changed on disk, reloading", file.path.string());
+			Load(file);
+		}
+		nextPoll = std::chrono::steady_clock::now() + pollInterval;
+	}
+}
+
+void ConfigService::Load(File& a_file)
+{
+	a_file.knownWriteTime = GetWriteTime(a_file.path);
+
+	// Owners waiting for their first load hear about missing files too
+	std::ifstream stream{ a_file.path, std::ios::binary };
+	if (!stream) {
+		a_file.onLoad({});
+		return;
+	}
+
+	stream.read(readBuffer.data(), (std::streamsize)readBuffer.size());
+	auto size = (std::size_t)stream.gcount();
+	// Parsing a truncated file would silently drop its last keys
+	if (stream.peek() != std::ifstream::traits_type::eof()) {
+		logger::error("[Config] {} is larger than {} bytes, ignoring it", a_file.path.string(), MaxFileSize);
+		a_file.onLoad({});
+		return;
+	}
+
+	a_file.onLoad({ readBuffer.data(), size });
+}
+
+void ConfigService::Save(File& a_file, const std::string& a_text)
+{
+	// Write next to the target and rename over it, readers never see a partial file
+	auto tempPath = a_file.path;
+	tempPath += L".tmp";
+
+	{
+		std::ofstream stream{ tempPath, std::ios::binary | std::ios::trunc };
+		stream.write(a_text.data(), (std::streamsize)a_text.size());
+		stream.close();
+		if (!stream) {
+			logger::error("[Config] Failed to write {}", tempPath.string());
+			return;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempPath, a_file.path, ec);
+	if (ec) {
+		logger::error("[Config] Failed to replace {}: {}", a_file.path.string(), ec.message());
+		return;
+	}
+
+	a_file.knownWriteTime = GetWriteTime(a_file.path);
+}
+
+std::optional<std::filesystem::file_time_type> ConfigService::GetWriteTime(const std::filesystem::path& a_path)
+{
+	std::error_code ec;
+	auto writeTime = std::filesystem::last_write_time(a_path, ec);
+	if (ec)
+		return std::nullopt;
+	return writeTime;
+}
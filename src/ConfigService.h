@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Owns the plugin's config files: loads and saves them on a background thread and picks up external edits
+class ConfigService
+{
+public:
+	static ConfigService* GetSingleton()
+	{
+		static ConfigService singleton;
+		return &singleton;
+	}
+
+	// Runs on the worker thread with the file's contents, empty when it does not exist or is larger than MaxFileSize
+	using LoadCallback = std::function<void(std::string_view)>;
+
+	static constexpr std::size_t MaxFileSize = 64 * 1024;
+
+	// Writes are delayed so bursts of UI edits end up as a single save
+	std::chrono::milliseconds saveDelay{ 500 };
+	std::chrono::milliseconds pollInterval{ 1000 };
+
+	// Returns the id used to request loads and saves. Watched files are reloaded when something else writes them.
+	uint32_t Register(const std::filesystem::path& a_path, LoadCallback a_onLoad, bool a_watch);
+
+	void Start();
+	// Writes saves still waiting out their delay before returning
+	void Stop();
+
+	void RequestLoad(uint32_t a_file);
+	void RequestSave(uint32_t a_file, std::string a_text);
+
+private:
+	struct File
+	{
+		std::filesystem::path path;
+		LoadCallback onLoad;
+		bool watch = false;
+
+		// Guarded by lock
+		bool pendingLoad = false;
+		std::optional<std::string> pendingSave;
+		std::chrono::steady_clock::time_point saveDeadline;
+
+		// Worker thread only once registered
+		std::optional<std::filesystem::file_time_type> knownWriteTime;
+	};
+
+	void Run(std::stop_token a_stop);
+	void Load(File& a_file);
+	void Save(File& a_file, const std::string& a_text);
+	static std::optional<std::filesystem::file_time_type> GetWriteTime(const std::filesystem::path& a_path);
+
+	std::mutex lock;
+	std::condition_variable_any condition;
+
+	// Worker thread only, files are read into it so loading never allocates
+	std::array<char, MaxFileSize> readBuffer;
+
+	// A deque keeps files the worker is using in place while others are registered
+	std::deque<File> files;
+
+	// Declared last so it is joined before the state it uses is destroyed
+	std::jthread worker;
+};
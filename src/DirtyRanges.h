@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Byte ranges of a buffer written since its last upload, sorted and non-overlapping. Ranges closer than a_gap are
+// merged, one larger copy is cheaper than several tiny ones. Free of D3D so upload patterns can be measured in tests.
+class DirtyRanges
+{
+public:
+	static constexpr uint32_t DefaultGap = 256;
+	// Only merges touching ranges, for buffers whose clean bytes hold data the writer has no copy of
+	static constexpr uint32_t ExactGap = 0;
+
+	struct Range
+	{
+		uint32_t begin;
+		uint32_t end;
+	};
+
+	explicit DirtyRanges(uint32_t a_gap = DefaultGap) :
+		gap(a_gap) {}
+
+	void Mark(uint32_t a_begin, uint32_t a_end)
+	{
+		if (a_begin >= a_end)
+			return;
+
+		auto it = std::lower_bound(ranges.begin(), ranges.end(), a_begin, [&](const Range& a_range, uint32_t a_value) {
+			return a_range.end + gap < a_value;
+		});
+
+		Range merged{ a_begin, a_end };
+		auto last = it;
+		while (last != ranges.end() && last->begin <= merged.end + gap) {
+			merged.begin = std::min(merged.begin, last->begin);
+			merged.end = std::max(merged.end, last->end);
+			++last;
+		}
+
+		it = ranges.erase(it, last);
+		ranges.insert(it, merged);
+	}
+
+	void Clear() { ranges.clear(); }
+	bool Empty() const { return ranges.empty(); }
+	const std::vector<Range>& Get() const { return ranges; }
+
+	// Bytes an upload of every range moves, including the clean gaps merged into them
+	uint64_t GetBytes() const
+	{
+		uint64_t bytes = 0;
+		for (auto& range : ranges)
+			bytes += range.end - range.begin;
+		return bytes;
+	}
+
+private:
+	uint32_t gap;
+	std::vector<Range> ranges;
+};
@@ -1,5 +1,7 @@
 #include "FidelityFX.h"
 
+#include "LogLimiter.h"
+#include "MemoryTracker.h"
 #include "Upscaling.h"
 #include "Util.h"
 
@@ -21,7 +23,7 @@ FfxResource ffxGetResource(ID3D11Resource* dx11Resource,
 	return resource;
 }
 
-void FidelityFX::CreateFSRResources()
+void FidelityFX::CreateFSRResources(bool a_frameGeneration)
 {
 	static auto renderer = RE::BSGraphics::Renderer::GetSingleton();
 	static auto& depthTexture = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPOST_ZPREPASS_COPY];
@@ -34,13 +36,16 @@ void FidelityFX::CreateFSRResources()
 
 	auto fsrDevice = ffxGetDeviceDX11(device);
 
-	size_t scratchBufferSize = ffxGetScratchMemorySizeDX11(FFX_FSR3UPSCALER_CONTEXT_COUNT);
-	void* scratchBuffer = calloc(scratchBufferSize, 1);
-	memset(scratchBuffer, 0, scratchBufferSize);
+	auto getInterface = [&](FfxInterface& a_interface, uint32_t a_contextCount) {
+		size_t scratchBufferSize = ffxGetScratchMemorySizeDX11(a_contextCount);
+		void* scratchBuffer = calloc(scratchBufferSize, 1);
+		scratchBuffers.push_back(scratchBuffer);
+		if (ffxGetInterfaceDX11(&a_interface, fsrDevice, scratchBuffer, scratchBufferSize, a_contextCount) != FFX_OK)
+			logger::critical("[FidelityFX] Failed to initialize FSR3 backend interface!");
+	};
 
 	FfxInterface fsrInterface;
-	if (ffxGetInterfaceDX11(&fsrInterface, fsrDevice, scratchBuffer, scratchBufferSize, FFX_FSR3UPSCALER_CONTEXT_COUNT) != FFX_OK)
-		logger::critical("[FidelityFX] Failed to initialize FSR3 backend interface!");
+	getInterface(fsrInterface, FFX_FSR3UPSCALER_CONTEXT_COUNT);
 
 	FfxFsr3ContextDescription contextDescription;
 	contextDescription.maxRenderSize.width = gameViewport->screenWidth;
@@ -49,21 +54,56 @@ void FidelityFX::CreateFSRResources()
 	contextDescription.maxUpscaleSize.height = gameViewport->screenHeight;
 	contextDescription.displaySize.width = gameViewport->screenWidth;
 	contextDescription.displaySize.height = gameViewport->screenHeight;
-	contextDescription.flags = FFX_FSR3_ENABLE_UPSCALING_ONLY;
+	contextDescription.flags = a_frameGeneration ? 0 : FFX_FSR3_ENABLE_UPSCALING_ONLY;
 	contextDescription.backBufferFormat = FFX_SURFACE_FORMAT_R8G8B8A8_UNORM;
 	contextDescription.backendInterfaceUpscaling = fsrInterface;
 
-	if (ffxFsr3ContextCreate(&fsrContext, &contextDescription) != FFX_OK)
+	// Optical flow and interpolation share resources with the upscaler, each needs its own interface
+	if (a_frameGeneration) {
+		getInterface(contextDescription.backendInterfaceSharedResources, FFX_FSR3_CONTEXT_COUNT);
+		getInterface(contextDescription.backendInterfaceFrameInterpolation, FFX_FRAMEINTERPOLATION_CONTEXT_COUNT);
+	}
+
+	frameGeneration = a_frameGeneration;
+	if (ffxFsr3ContextCreate(&fsrContext, &contextDescription) != FFX_OK) {
 		logger::critical("[FidelityFX] Failed to initialize FSR3 context!");
+		return;
+	}
+
+	// The scratch buffers are system memory and do not count against the video memory budget
+	FfxEffectMemoryUsage upscalerUsage{};
+	FfxEffectMemoryUsage opticalFlowUsage{};
+	FfxEffectMemoryUsage frameGenerationUsage{};
+	if (ffxFsr3ContextGetGpuMemoryUsage(&fsrContext, &upscalerUsage, &opticalFlowUsage, &frameGenerationUsage) != FFX_OK) {
+		logger::warn("[FidelityFX] Could not query FSR3 memory usage");
+		return;
+	}
+
+	auto memoryTracker = MemoryTracker::GetSingleton();
+	upscalerBytes = upscalerUsage.totalUsageInBytes;
+	frameGenerationBytes = a_frameGeneration ? opticalFlowUsage.totalUsageInBytes + frameGenerationUsage.totalUsageInBytes : 0;
+	memoryTracker->Add(MemoryTracker::Category::kFSR, upscalerBytes);
+	memoryTracker->Add(MemoryTracker::Category::kFrameGeneration, frameGenerationBytes);
+	logger::debug("[FidelityFX] FSR3 uses {} MB, frame generation {} MB", upscalerBytes >> 20, frameGenerationBytes >> 20);
 }
 
 void FidelityFX::DestroyFSRResources()
 {
 	if (ffxFsr3ContextDestroy(&fsrContext) != FFX_OK)
 		logger::critical("[FidelityFX] Failed to destroy FSR3 context!");
+
+	for (auto scratchBuffer : scratchBuffers)
+		free(scratchBuffer);
+	scratchBuffers.clear();
+
+	auto memoryTracker = MemoryTracker::GetSingleton();
+	memoryTracker->Remove(MemoryTracker::Category::kFSR, upscalerBytes);
+	memoryTracker->Remove(MemoryTracker::Category::kFrameGeneration, frameGenerationBytes);
+	upscalerBytes = 0;
+	frameGenerationBytes = 0;
 }
 
-void FidelityFX::Upscale(Texture2D* a_color, Texture2D* a_alphaMask, float2 a_jitter, bool a_reset, float a_sharpness)
+bool FidelityFX::Upscale(Texture2D* a_color, Texture2D* a_alphaMask, float2 a_jitter, bool a_reset, float a_sharpness)
 {
 	static auto renderer = RE::BSGraphics::Renderer::GetSingleton();
 	static auto& depthTexture = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPOST_ZPREPASS_COPY];
@@ -109,7 +149,58 @@ void FidelityFX::Upscale(Texture2D* a_color, Texture2D* a_alphaMask, float2 a_ji
 
 		dispatchParameters.flags = 0;
 
-		if (ffxFsr3ContextDispatchUpscale(&fsrContext, &dispatchParameters) != FFX_OK)
-			logger::critical("[FidelityFX] Failed to dispatch upscaling!");
+		frameID++;
+
+		if (ffxFsr3ContextDispatchUpscale(&fsrContext, &dispatchParameters) != FFX_OK) {
+			static LogLimiter limiter;
+			if (auto repeats = limiter.Check())
+				logger::critical("[FidelityFX] Failed to dispatch upscaling!{}", *repeats);
+			return false;
+		}
 	}
+
+	return true;
 }
+
+bool FidelityFX::GenerateFrame(ID3D11Resource* a_hudless, ID3D11Resource* a_presentColor, Texture2D* a_output, bool a_reset)
+{
+	static auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(renderer->GetRuntimeData().context);
+
+	// There is no interpolation swap chain on D3D11, frames are presented by FrameGeneration instead
+	FfxFrameGenerationConfig config{};
+	config.swapChain = nullptr;
+	config.frameGenerationEnabled = true;
+	config.allowAsyncWorkloads = false;
+	config.onlyPresentInterpolated = false;
+	config.HUDLessColor = ffxGetResource(a_hudless, L"FSR3_HUDLessColor", FFX_RESOURCE_STATE_PIXEL_COMPUTE_READ);
+	config.flags = 0;
+	config.frameID = frameID;
+
+	if (ffxFsr3ConfigureFrameGeneration(&fsrContext, &config) != FFX_OK) {
+		static LogLimiter limiter;
+		if (auto repeats = limiter.Check())
+			logger::critical("[FidelityFX] Failed to configure frame generation!{}", *repeats);
+		return false;
+	}
+
+	FfxFrameGenerationDispatchDescription dispatchParameters{};
+	dispatchParameters.commandList = ffxGetCommandListDX11(context);
+	dispatchParameters.presentColor = ffxGetResource(a_presentColor, L"FSR3_PresentColor", FFX_RESOURCE_STATE_PIXEL_COMPUTE_READ);
+	dispatchParameters.outputs[0] = ffxGetResource(a_output->resource.get(), L"FSR3_InterpolatedOutput", FFX_RESOURCE_STATE_UNORDERED_ACCESS);
+	dispatchParameters.numInterpolatedFrames = 1;
+	dispatchParameters.reset = a_reset;
+	dispatchParameters.backBufferTransferFunction = FFX_BACKBUFFER_TRANSFER_FUNCTION_SRGB;
+	dispatchParameters.minMaxLuminance[0] = 0.0f;
+	dispatchParameters.minMaxLuminance[1] = 1.0f;
+	dispatchParameters.frameID = frameID;
+
+	if (ffxFsr3DispatchFrameGeneration(&dispatchParameters) != FFX_OK) {
+		static LogLimiter limiter;
+		if (auto repeats = limiter.Check())
+			logger::critical("[FidelityFX] Failed to dispatch frame generation!{}", *repeats);
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -16,8 +16,18 @@ public:
 	}
 
 	FfxFsr3Context fsrContext;
+	// Whether fsrContext was created with frame interpolation, it cannot be toggled without recreating the context
+	bool frameGeneration = false;
+	uint64_t frameID = 0;
+	std::vector<void*> scratchBuffers;
+	// Video memory fsrContext reported for itself, added to MemoryTracker
+	uint64_t upscalerBytes = 0;
+	uint64_t frameGenerationBytes = 0;
 
-	void CreateFSRResources();
+	void CreateFSRResources(bool a_frameGeneration);
 	void DestroyFSRResources();
-	void Upscale(Texture2D* a_color, Texture2D* a_alphaMask, float2 a_jitter, bool a_reset, float a_sharpness);
+	bool Upscale(Texture2D* a_color, Texture2D* a_alphaMask, float2 a_jitter, bool a_reset, float a_sharpness);
+	// Interpolates between the previous and current presented frame into a_output. a_hudless is the current frame
+	// before the UI was drawn, the UI is taken from a_presentColor and composited over the interpolated scene.
+	bool GenerateFrame(ID3D11Resource* a_hudless, ID3D11Resource* a_presentColor, Texture2D* a_output, bool a_reset);
 };
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <string_view>
+
+// Text stored inline, so settings holding it can be copied and published without allocating
+template <std::size_t N>
+struct FixedString
+{
+	char data[N]{};
+	std::size_t size = 0;
+
+	constexpr FixedString() = default;
+
+	constexpr FixedString(std::string_view a_text) { Assign(a_text); }
+
+	// Joins a_items with a_separator, at compile time for defaults
+	constexpr FixedString(std::initializer_list<std::string_view> a_items, char a_separator)
+	{
+		for (auto item : a_items) {
+			if (size > 0)
+				Append({ &a_separator, 1 });
+			Append(item);
+		}
+	}
+
+	// Returns false and keeps the old text when a_text does not fit
+	constexpr bool Assign(std::string_view a_text)
+	{
+		if (a_text.size() > N)
+			return false;
+		size = 0;
+		Append(a_text);
+		return true;
+	}
+
+	constexpr std::string_view View() const { return { data, size }; }
+
+	constexpr bool operator==(const FixedString& a_other) const { return View() == a_other.View(); }
+
+private:
+	constexpr void Append(std::string_view a_text)
+	{
+		auto count = std::min(a_text.size(), N - size);
+		for (std::size_t i = 0; i < count; i++)
+			data[size + i] = a_text[i];
+		size += count;
+	}
+};
@@ -0,0 +1,237 @@
+#include "FrameCapture.h"
+
+#include "MemoryTracker.h"
+
+void FrameCapture::Update(uint64_t a_frame)
+{
+	// A stopped writer is only joined once it has flushed, so the render thread never waits on the disk
+	if (stopping) {
+		if (!writerDone.load(std::memory_order_acquire))
+			return;
+		worker.join();
+		stopping = false;
+	}
+
+	auto want = requested.load(std::memory_order_relaxed);
+	if (want && !recording)
+		Start();
+	else if (!want && recording)
+		Stop();
+
+	if (recording)
+		ReadPlanes(a_frame);
+}
+
+void FrameCapture::Start()
+{
+	// Every job is idle once the previous writer joined
+	Job* job;
+	while (pending.Pop(job)) {}
+	while (available.Pop(job)) {}
+	for (auto& idle : jobs)
+		available.Push(&idle);
+
+	framesCaptured = 0;
+	planesDropped = 0;
+	writerDone = false;
+	recording = true;
+
+	// The file is opened by the writer, the render thread never touches the disk
+	worker = std::jthread([this](std::stop_token a_stop) { Run(a_stop); });
+	logger::info("[FrameCapture] Recording to {}", directory.string());
+}
+
+void FrameCapture::Stop()
+{
+	// Copies still in flight are lost, the writer flushes what it already has
+	worker.request_stop();
+	condition.notify_all();
+	stopping = true;
+
+	DestroyPlanes();
+	recording = false;
+	logger::info("[FrameCapture] Stopped after {} frames, {} planes dropped", framesCaptured.load(), planesDropped.load());
+}
+
+bool FrameCapture::CheckPlane(Plane& a_plane, ID3D11Resource* a_source)
+{
+	winrt::com_ptr<ID3D11Texture2D> texture;
+	if (!a_source || FAILED(a_source->QueryInterface(IID_PPV_ARGS(texture.put()))))
+		return false;
+
+	D3D11_TEXTURE2D_DESC desc;
+	texture->GetDesc(&desc);
+	if (a_plane.readback && desc.Width == a_plane.desc.Width && desc.Height == a_plane.desc.Height && desc.Format == a_plane.desc.Format)
+		return true;
+
+	auto memoryTracker = MemoryTracker::GetSingleton();
+	if (a_plane.readback) {
+		planeBytes -= a_plane.readback->GetSize();
+		memoryTracker->Remove(MemoryTracker::Category::kCapture, a_plane.readback->GetSize());
+		delete a_plane.readback;
+	}
+
+	a_plane.desc = desc;
+	a_plane.pixelSize = MemoryTracker::GetBitsPerPixel(desc.Format) / 8;
+	a_plane.readback = new GpuReadback(desc, Latency);
+	planeBytes += a_plane.readback->GetSize();
+	memoryTracker->Add(MemoryTracker::Category::kCapture, a_plane.readback->GetSize());
+	return true;
+}
+
+void FrameCapture::DestroyPlanes()
+{
+	for (auto& plane : planes) {
+		delete plane.readback;
+		plane.readback = nullptr;
+	}
+	MemoryTracker::GetSingleton()->Remove(MemoryTracker::Category::kCapture, planeBytes);
+	planeBytes = 0;
+}
+
+void FrameCapture::Capture(uint64_t a_frame, ID3D11Resource* a_color, std::span<const CaptureFile::FrameInfo> a_infos)
+{
+	if (!recording)
+		return;
+
+	static auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+	static auto& depthTexture = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPOST_ZPREPASS_COPY];
+	static auto& motionVectorsTexture = renderer->GetRuntimeData().renderTargets[RE::RENDER_TARGETS::kMOTION_VECTOR];
+	static auto& temporalAAMask = renderer->GetRuntimeData().renderTargets[RE::RENDER_TARGETS::kTEMPORAL_AA_MASK];
+
+	ID3D11Resource* sources[4] = { a_color, depthTexture.texture, motionVectorsTexture.texture, temporalAAMask.texture };
+
+	// Frames are captured whole or not at all, one is skipped while any plane's ring is full
+	bool valid[4];
+	for (uint i = 0; i < 4; i++) {
+		valid[i] = CheckPlane(planes[i], sources[i]);
+		if (valid[i] && planes[i].readback->IsFull()) {
+			planesDropped += 4;
+			return;
+		}
+	}
+
+	bool complete = true;
+	for (uint i = 0; i < 4; i++) {
+		if (!valid[i] || !planes[i].readback->Copy(sources[i], a_frame)) {
+			planesDropped++;
+			complete = false;
+		}
+	}
+
+	for (auto& info : a_infos) {
+		auto job = AcquireJob();
+		if (!job) {
+			complete = false;
+			continue;
+		}
+		job->type = CaptureFile::ChunkType::kFrame;
+		job->frame = a_frame;
+		job->width = job->height = job->format = job->pixelSize = 0;
+		job->data.assign(reinterpret_cast<const uint8_t*>(&info), reinterpret_cast<const uint8_t*>(&info) + sizeof(info));
+		Submit(job);
+	}
+
+	if (complete)
+		framesCaptured++;
+}
+
+void FrameCapture::ReadPlanes(uint64_t a_frame)
+{
+	// One copy per plane and pass, so the planes of the oldest frame are read together
+	uint64_t packed = 0;
+	for (bool read = true; read && packed < ReadBudget;) {
+		read = false;
+		for (auto& plane : planes) {
+			if (!plane.readback || packed >= ReadBudget)
+				continue;
+			read |= ReadPlane(plane, a_frame, packed) > 0;
+		}
+	}
+}
+
+uint FrameCapture::ReadPlane(Plane& a_plane, uint64_t a_frame, uint64_t& a_packed)
+{
+	return a_plane.readback->Read(
+		a_frame, [&](const ReadbackRing::Slot& a_slot, const D3D11_MAPPED_SUBRESOURCE& a_mapped) {
+			auto job = AcquireJob();
+			if (!job) {
+				planesDropped++;
+				return;
+			}
+
+			// Staging rows are padded to the driver's pitch, the file stores them tightly packed
+			std::size_t rowSize = (std::size_t)a_plane.desc.Width * a_plane.pixelSize;
+			job->data.resize(rowSize * a_plane.desc.Height);
+			auto source = static_cast<const uint8_t*>(a_mapped.pData);
+			for (uint y = 0; y < a_plane.desc.Height; y++)
+				std::memcpy(job->data.data() + y * rowSize, source + (std::size_t)y * a_mapped.RowPitch, rowSize);
+			a_packed += job->data.size();
+
+			job->type = a_plane.type;
+			job->frame = a_slot.frame;
+			job->width = a_plane.desc.Width;
+			job->height = a_plane.desc.Height;
+			job->format = a_plane.desc.Format;
+			job->pixelSize = a_plane.pixelSize;
+			Submit(job);
+		},
+		1);
+}
+
+FrameCapture::Job* FrameCapture::AcquireJob()
+{
+	Job* job;
+	return available.Pop(job) ? job : nullptr;
+}
+
+void FrameCapture::Submit(Job* a_job)
+{
+	// Cannot fail, there are only as many jobs as the queue holds
+	pending.Push(a_job);
+	condition.notify_one();
+}
+
+void FrameCapture::Run(std::stop_token a_stop)
+{
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+	auto path = directory / std::format("{:%Y%m%d-%H%M%S}.upcap", now);
+	writer.threads = EncodeThreads;
+	failed = !writer.Open(path);
+	if (failed)
+		logger::error("[FrameCapture] Could not create {}", path.string());
+
+	while (true) {
+		Job* job;
+		if (pending.Pop(job)) {
+			if (!failed) {
+				auto codec = compress ? CaptureFile::Codec::kPlane : CaptureFile::Codec::kNone;
+				if (job->type == CaptureFile::ChunkType::kFrame)
+					codec = CaptureFile::Codec::kNone;
+				if (!writer.Write(job->type, job->frame, job->data, codec, job->width, job->height, job->format, job->pixelSize)) {
+					logger::error("[FrameCapture] Could not write to {}, is the disk full?", path.string());
+					failed = true;
+				}
+			}
+			available.Push(job);
+			continue;
+		}
+
+		// Only leaves once everything queued before the stop was written
+		if (a_stop.stop_requested())
+			break;
+
+		// Submit does not take the lock, so a wake up can be missed, the timeout bounds how late a job is picked up
+		std::unique_lock<std::mutex> lk(lock);
+		condition.wait_for(lk, a_stop, std::chrono::milliseconds(5), [] { return false; });
+	}
+
+	if (writer.IsOpen() && !writer.Close())
+		logger::error("[FrameCapture] Could not finish {}", path.string());
+	else if (!failed)
+		logger::info("[FrameCapture] Wrote {}", path.string());
+	writerDone.store(true, std::memory_order_release);
+}
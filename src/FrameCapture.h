@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+#include "CaptureFile.h"
+#include "CommandQueue.h"
+#include "GpuReadback.h"
+
+// Streams the inputs Upscaling::Upscale sees to a capture file for offline tuning. The render thread copies every
+// input into a readback ring and, once the GPU is done with it, packs its rows into a pooled buffer for the writer
+// thread, which compresses and writes it. The render thread never waits on the GPU or the writer: a frame is skipped
+// when a plane's copies are still in flight or unread, and a plane is dropped when the writer has no free buffer.
+class FrameCapture
+{
+public:
+	static FrameCapture* GetSingleton()
+	{
+		static FrameCapture singleton;
+		return &singleton;
+	}
+
+	std::filesystem::path directory = L"enbseries/captures";
+	// Compresses planes on the writer thread, costs throughput but captures far more frames per gigabyte
+	bool compress = true;
+
+	// Any thread, the render thread starts or stops recording on its next Update
+	std::atomic<bool> requested = false;
+
+	// For the UI, reset when recording starts
+	std::atomic<bool> recording = false;
+	std::atomic<uint64_t> framesCaptured = 0;
+	std::atomic<uint64_t> planesDropped = 0;
+
+	// Render thread, once per frame
+	void Update(uint64_t a_frame);
+	// Render thread, records a_color, the game's depth, motion vectors and mask, and a FrameInfo per eye
+	void Capture(uint64_t a_frame, ID3D11Resource* a_color, std::span<const CaptureFile::FrameInfo> a_infos);
+
+private:
+	static constexpr uint Latency = 3;
+	// Buffers shared by both threads, a power of two for CommandQueue. Each keeps the capacity of the largest plane it
+	// held, so the pool can grow to JobCount planes, about 1 GB for a 4K RGBA16F color target.
+	static constexpr uint JobCount = 16;
+	// Bytes the render thread packs per frame, finished copies past it wait in their ring for the next frame. Keeps the
+	// copy to a few milliseconds; at 4K one frame's planes take more than this, so frames are skipped.
+	static constexpr uint64_t ReadBudget = 64ull << 20;
+	// Threads PlaneCodec spreads a plane over, kept low so recording does not starve the game's own threads
+	static constexpr uint EncodeThreads = 2;
+
+	struct Plane
+	{
+		CaptureFile::ChunkType type;
+		GpuReadback* readback = nullptr;
+		D3D11_TEXTURE2D_DESC desc{};
+		uint pixelSize = 0;
+	};
+
+	struct Job
+	{
+		CaptureFile::ChunkType type;
+		uint64_t frame = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t format = 0;
+		uint32_t pixelSize = 0;
+		std::vector<uint8_t> data;
+	};
+
+	void Start();
+	void Stop();
+	bool CheckPlane(Plane& a_plane, ID3D11Resource* a_source);
+	void DestroyPlanes();
+	void ReadPlanes(uint64_t a_frame);
+	// Packs the oldest finished copy of a_plane, adding its size to a_packed
+	uint ReadPlane(Plane& a_plane, uint64_t a_frame, uint64_t& a_packed);
+	Job* AcquireJob();
+	void Submit(Job* a_job);
+	void Run(std::stop_token a_stop);
+
+	Plane planes[4] = {
+		{ CaptureFile::ChunkType::kColor },
+		{ CaptureFile::ChunkType::kDepth },
+		{ CaptureFile::ChunkType::kMotionVectors },
+		{ CaptureFile::ChunkType::kMask }
+	};
+	uint64_t planeBytes = 0;
+
+	Job jobs[JobCount];
+	// Render thread to writer thread, and the emptied jobs back
+	CommandQueue<Job*, JobCount> pending;
+	CommandQueue<Job*, JobCount> available;
+
+	std::jthread worker;
+	// Render thread only, set until the stopped writer is joined
+	bool stopping = false;
+	std::atomic<bool> writerDone = false;
+	std::mutex lock;
+	std::condition_variable_any condition;
+
+	// Writer thread only
+	CaptureFile::Writer writer;
+	bool failed = false;
+};
@@ -0,0 +1,218 @@
+#include "FrameGeneration.h"
+
+#include "FidelityFX.h"
+#include "Hooks.h"
+#include "MemoryTracker.h"
+
+double FrameGeneration::Now()
+{
+	static const double frequency = [] {
+		LARGE_INTEGER value;
+		QueryPerformanceFrequency(&value);
+		return (double)value.QuadPart / 1000.0;
+	}();
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / frequency;
+}
+
+static Texture2D* CreateMatchingTexture(ID3D11Texture2D* a_source, UINT a_bindFlags)
+{
+	D3D11_TEXTURE2D_DESC texDesc;
+	a_source->GetDesc(&texDesc);
+	texDesc.Usage = D3D11_USAGE_DEFAULT;
+	texDesc.BindFlags = a_bindFlags;
+	texDesc.CPUAccessFlags = 0;
+	texDesc.MiscFlags = 0;
+	texDesc.MipLevels = 1;
+	texDesc.ArraySize = 1;
+	texDesc.SampleDesc = { 1, 0 };
+
+	// Copies only need the same format family, and sRGB formats cannot be written through a UAV
+	if (texDesc.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+		texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+	return new Texture2D(texDesc);
+}
+
+static bool MatchesSize(Texture2D* a_texture, ID3D11Texture2D* a_source)
+{
+	D3D11_TEXTURE2D_DESC texDesc;
+	a_source->GetDesc(&texDesc);
+	return a_texture && a_texture->desc.Width == texDesc.Width && a_texture->desc.Height == texDesc.Height;
+}
+
+void FrameGeneration::CaptureHUDLess(ID3D11Resource* a_color)
+{
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+	winrt::com_ptr<ID3D11Texture2D> color;
+	if (FAILED(a_color->QueryInterface(IID_PPV_ARGS(color.put()))))
+		return;
+
+	if (!MatchesSize(hudlessTexture, color.get())) {
+		delete hudlessTexture;
+		hudlessTexture = CreateMatchingTexture(color.get(), D3D11_BIND_SHADER_RESOURCE);
+		reset = true;
+		UpdateMemoryUsage();
+	}
+
+	context->CopyResource(hudlessTexture->resource.get(), a_color);
+	hasHUDLess = true;
+}
+
+void FrameGeneration::CheckResources(ID3D11Texture2D* a_backBuffer)
+{
+	if (MatchesSize(heldTexture, a_backBuffer))
+		return;
+
+	DestroyResources();
+	heldTexture = CreateMatchingTexture(a_backBuffer, D3D11_BIND_SHADER_RESOURCE);
+	generatedTexture = CreateMatchingTexture(a_backBuffer, D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS);
+	reset = true;
+	UpdateMemoryUsage();
+}
+
+void FrameGeneration::DestroyResources()
+{
+	delete heldTexture;
+	heldTexture = nullptr;
+
+	delete generatedTexture;
+	generatedTexture = nullptr;
+
+	UpdateMemoryUsage();
+}
+
+void FrameGeneration::Release()
+{
+	if (holding)
+		PresentHeldFrame(0.0);
+
+	DestroyResources();
+
+	delete hudlessTexture;
+	hudlessTexture = nullptr;
+	hasHUDLess = false;
+	reset = true;
+
+	UpdateMemoryUsage();
+}
+
+void FrameGeneration::UpdateMemoryUsage()
+{
+	uint64_t bytes = 0;
+	for (auto texture : { hudlessTexture, heldTexture, generatedTexture }) {
+		if (texture)
+			bytes += MemoryTracker::GetSize(texture->desc);
+	}
+
+	auto memoryTracker = MemoryTracker::GetSingleton();
+	memoryTracker->Remove(MemoryTracker::Category::kFrameGeneration, textureBytes);
+	memoryTracker->Add(MemoryTracker::Category::kFrameGeneration, bytes);
+	textureBytes = bytes;
+}
+
+HRESULT FrameGeneration::Present(IDXGISwapChain* a_swapChain, UINT a_syncInterval, UINT a_flags)
+{
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+	// With renderStartPresent a frame that skipped render start still has to go out before the next one
+	if (holding)
+		PresentHeldFrame(0.0);
+
+	bool generate = active && hasHUDLess;
+	hasHUDLess = false;
+
+	if (!generate) {
+		if (wasActive) {
+			pacer.Reset();
+			reset = true;
+			pacingMean = -1.0f;
+			pacingDeviation = -1.0f;
+		}
+		wasActive = false;
+		return Hooks::Present(a_swapChain, a_syncInterval, a_flags);
+	}
+	wasActive = true;
+
+	winrt::com_ptr<ID3D11Texture2D> backBuffer;
+	if (FAILED(a_swapChain->GetBuffer(0, IID_PPV_ARGS(backBuffer.put()))))
+		return Hooks::Present(a_swapChain, a_syncInterval, a_flags);
+
+	CheckResources(backBuffer.get());
+	context->CopyResource(heldTexture->resource.get(), backBuffer.get());
+
+	bool generated = FidelityFX::GetSingleton()->GenerateFrame(hudlessTexture->resource.get(), heldTexture->resource.get(), generatedTexture, reset);
+	reset = false;
+	if (!generated)
+		return Hooks::Present(a_swapChain, a_syncInterval, a_flags);
+
+	context->CopyResource(backBuffer.get(), generatedTexture->resource.get());
+	auto hr = Hooks::Present(a_swapChain, a_syncInterval, a_flags);
+	pacer.OnGeneratedPresent(Now());
+
+	holding = true;
+	heldSwapChain = a_swapChain;
+	heldSyncInterval = a_syncInterval;
+	heldFlags = a_flags;
+	PresentHeld(Opportunity::kPresent);
+
+	return hr;
+}
+
+void FrameGeneration::PresentHeld(Opportunity a_opportunity)
+{
+	if (!wasActive || (a_opportunity == Opportunity::kRenderStart && !renderStartPresent))
+		return;
+
+	bool last = a_opportunity == Opportunity::kRenderStart || !renderStartPresent;
+	auto decision = pacer.Decide((uint)a_opportunity, Now(), last);
+	if (holding && decision.present)
+		PresentHeldFrame(decision.wait);
+}
+
+void FrameGeneration::PresentHeldFrame(double a_wait)
+{
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+	// FramePacer never asks for waits shorter than the timer can hit
+	if (a_wait > 0.0) {
+		if (!waitTimerCreated) {
+			waitTimer.attach(CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS));
+			waitTimerCreated = true;
+			if (!waitTimer)
+				logger::warn("[FrameGeneration] High resolution timers are not supported, real frames are not paced");
+		}
+
+		// Relative due times are negative, in 100 ns units
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -(LONGLONG)(a_wait * 10000.0);
+		if (waitTimer && SetWaitableTimer(waitTimer.get(), &dueTime, 0, nullptr, nullptr, FALSE))
+			WaitForSingleObject(waitTimer.get(), INFINITE);
+	}
+
+	winrt::com_ptr<ID3D11Texture2D> backBuffer;
+	if (SUCCEEDED(heldSwapChain->GetBuffer(0, IID_PPV_ARGS(backBuffer.put())))) {
+		context->CopyResource(backBuffer.get(), heldTexture->resource.get());
+		Hooks::Present(heldSwapChain, heldSyncInterval, heldFlags);
+		pacer.OnRealPresent(Now());
+	}
+	holding = false;
+
+	UpdateStatistics();
+}
+
+void FrameGeneration::UpdateStatistics()
+{
+	auto& statistics = pacer.GetStatistics();
+	if (statistics.count < StatisticsWindow)
+		return;
+
+	auto deviation = std::sqrt(statistics.variance);
+	pacingMean = (float)statistics.mean;
+	pacingDeviation = (float)deviation;
+	logger::debug("[FrameGeneration] Frame time {:.2f} ms, variance {:.3f}, interval {:.2f} ms", statistics.mean, statistics.variance, pacer.GetInterval());
+	pacer.ResetStatistics();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+
+#include "Buffer.h"
+#include "FramePacer.h"
+
+// Presents an FSR 3 interpolated frame ahead of every real frame. D3D11 has no interpolation swap chain, so the real
+// frame is copied aside at present, the generated one is presented in its place, and the real one follows from the
+// same present call after FramePacer's wait. All presents stay on the render thread, which also owns the immediate
+// context.
+class FrameGeneration
+{
+public:
+	static FrameGeneration* GetSingleton()
+	{
+		static FrameGeneration singleton;
+		return &singleton;
+	}
+
+	// Points in a frame where the held real frame can be presented, in the order they occur
+	enum class Opportunity
+	{
+		kPresent,
+		kRenderStart
+	};
+
+	// Render thread only, decided once per frame before the game presents
+	bool active = false;
+	// Lets FramePacer defer the real frame to render start, which presents again in the middle of the game's frame
+	bool renderStartPresent = false;
+
+	// Mean and standard deviation of displayed frame times over the last window, negative while inactive
+	std::atomic<float> pacingMean = -1.0f;
+	std::atomic<float> pacingDeviation = -1.0f;
+
+	// Copies this frame's scene before the UI is drawn, FSR uses it to keep the UI out of the interpolated scene
+	void CaptureHUDLess(ID3D11Resource* a_color);
+	// Replaces the game's present, passing it through unchanged while inactive
+	HRESULT Present(IDXGISwapChain* a_swapChain, UINT a_syncInterval, UINT a_flags);
+	// Presents the held real frame if a_opportunity is the best point for it, render start only with renderStartPresent
+	void PresentHeld(Opportunity a_opportunity);
+	// Frees every copy, they are recreated by the next frame that generates
+	void Release();
+
+private:
+	static constexpr uint StatisticsWindow = 240;
+
+	FramePacer pacer;
+
+	Texture2D* hudlessTexture = nullptr;
+	Texture2D* heldTexture = nullptr;
+	Texture2D* generatedTexture = nullptr;
+	// Size of the textures above, added to MemoryTracker
+	uint64_t textureBytes = 0;
+
+	bool hasHUDLess = false;
+	bool wasActive = false;
+	bool reset = true;
+
+	bool holding = false;
+	IDXGISwapChain* heldSwapChain = nullptr;
+	UINT heldSyncInterval = 0;
+	UINT heldFlags = 0;
+
+	// High resolution timer the held frame waits on, unset where Windows does not support one
+	winrt::handle waitTimer;
+	bool waitTimerCreated = false;
+
+	static double Now();
+	void PresentHeldFrame(double a_wait);
+	void CheckResources(ID3D11Texture2D* a_backBuffer);
+	void DestroyResources();
+	void UpdateMemoryUsage();
+	void UpdateStatistics();
+};
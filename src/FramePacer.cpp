@@ -0,0 +1,74 @@
+#include "FramePacer.h"
+
+void FramePacer::OnGeneratedPresent(double a_time)
+{
+	if (lastGenerated >= 0.0) {
+		auto cycle = a_time - lastGenerated;
+		if (cycle <= 0.0 || cycle > thresholds.maxInterval) {
+			Reset();
+		} else {
+			interval = interval > 0.0 ? interval + (cycle - interval) * thresholds.smoothing : cycle;
+		}
+	}
+
+	lastGenerated = a_time;
+	RecordDisplayed(a_time);
+}
+
+FramePacer::Decision FramePacer::Decide(uint a_opportunity, double a_time, bool a_last)
+{
+	if (lastGenerated < 0.0 || a_opportunity >= MaxOpportunities)
+		return {};
+
+	auto offset = a_time - lastGenerated;
+	auto& smoothed = offsets[a_opportunity];
+	smoothed = smoothed >= 0.0 ? smoothed + (offset - smoothed) * thresholds.smoothing : offset;
+
+	if (interval <= 0.0)
+		return {};
+
+	auto target = lastGenerated + interval * 0.5;
+	auto wait = std::clamp(target - a_time, 0.0, thresholds.maxWait);
+	if (wait < thresholds.minWait)
+		wait = 0.0;
+	if (a_last)
+		return { true, wait };
+
+	// A later opportunity only wins if it is expected to land clearly closer, earlier presents keep latency down
+	auto error = std::abs(a_time + wait - target);
+	for (auto i = a_opportunity + 1; i < MaxOpportunities; i++) {
+		if (offsets[i] < 0.0)
+			continue;
+		auto predicted = lastGenerated + offsets[i];
+		auto predictedError = std::abs(predicted + std::clamp(target - predicted, 0.0, thresholds.maxWait) - target);
+		if (predictedError + thresholds.maxWait * 0.5 < error)
+			return { false, 0.0 };
+	}
+	return { true, wait };
+}
+
+void FramePacer::OnRealPresent(double a_time)
+{
+	RecordDisplayed(a_time);
+}
+
+void FramePacer::Reset()
+{
+	interval = 0.0;
+	lastGenerated = -1.0;
+	lastDisplayed = -1.0;
+	offsets.fill(-1.0);
+}
+
+void FramePacer::RecordDisplayed(double a_time)
+{
+	if (lastDisplayed >= 0.0) {
+		auto frameTime = a_time - lastDisplayed;
+		statistics.count++;
+		auto delta = frameTime - statistics.mean;
+		statistics.mean += delta / statistics.count;
+		m2 += delta * (frameTime - statistics.mean);
+		statistics.variance = statistics.count > 1 ? m2 / (statistics.count - 1) : 0.0;
+	}
+	lastDisplayed = a_time;
+}
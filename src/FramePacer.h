@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+
+// Spaces generated and real frames evenly. The generated frame is presented as soon as its real frame is ready, and
+// the real frame is held for the point in the frame closest to halfway to the next generated frame. Presents can only
+// happen where the plugin has control of the render thread, so each of those opportunities is tracked by its usual
+// offset from the generated present, and the real frame is deferred to a later one when that lands nearer the middle.
+// Waiting delays the game thread, so it is bounded by maxWait.
+// Only sees times in milliseconds, so it can be driven by recorded present traces.
+class FramePacer
+{
+public:
+	static constexpr uint MaxOpportunities = 4;
+
+	struct Thresholds
+	{
+		// Weight of the newest sample in the smoothed interval and opportunity offsets
+		double smoothing = 0.1;
+		// Longest the real frame is held past the moment it could be presented
+		double maxWait = 2.0;
+		// Shorter waits are skipped, a timer cannot reliably hit them
+		double minWait = 0.5;
+		// Cycles longer than this, e.g. loading screens, restart pacing instead of skewing the estimate
+		double maxInterval = 100.0;
+	};
+
+	struct Decision
+	{
+		bool present = true;
+		// Milliseconds to hold the real frame before presenting it
+		double wait = 0.0;
+	};
+
+	// Intervals between consecutive displayed frames
+	struct Statistics
+	{
+		uint count = 0;
+		double mean = 0.0;
+		double variance = 0.0;
+	};
+
+	Thresholds thresholds;
+
+	void OnGeneratedPresent(double a_time);
+	// Called at every opportunity in the order they occur in a frame, also when no real frame is held so their offsets
+	// stay known. a_last forces a present since no later opportunity comes before the next generated frame.
+	Decision Decide(uint a_opportunity, double a_time, bool a_last);
+	void OnRealPresent(double a_time);
+	void Reset();
+
+	// Smoothed generated to generated interval, zero until two cycles were seen
+	double GetInterval() const { return interval; }
+	const Statistics& GetStatistics() const { return statistics; }
+	void ResetStatistics()
+	{
+		statistics = {};
+		m2 = 0.0;
+	}
+
+private:
+	void RecordDisplayed(double a_time);
+
+	double interval = 0.0;
+	double lastGenerated = -1.0;
+	double lastDisplayed = -1.0;
+	// Smoothed offset of each opportunity from the generated present, negative while unseen
+	std::array<double, MaxOpportunities> offsets = { -1.0, -1.0, -1.0, -1.0 };
+	Statistics statistics;
+	// Running sum of squared differences for Welford's algorithm
+	double m2 = 0.0;
+};
@@ -0,0 +1,92 @@
+#include "GpuReadback.h"
+
+#include "MemoryTracker.h"
+
+GpuReadback::GpuReadback(const D3D11_BUFFER_DESC& a_desc, uint a_slots) :
+	ring(a_slots)
+{
+	auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+
+	D3D11_BUFFER_DESC desc{};
+	desc.ByteWidth = a_desc.ByteWidth;
+	desc.Usage = D3D11_USAGE_STAGING;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+	for (uint i = 0; i < ring.GetSlotCount(); i++) {
+		winrt::com_ptr<ID3D11Buffer> buffer;
+		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, buffer.put()));
+		slots[i].staging = buffer.as<ID3D11Resource>();
+	}
+
+	slotSize = MemoryTracker::GetSize(desc);
+	CreateFences();
+}
+
+GpuReadback::GpuReadback(const D3D11_TEXTURE2D_DESC& a_desc, uint a_slots) :
+	ring(a_slots)
+{
+	auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+
+	D3D11_TEXTURE2D_DESC desc = a_desc;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.SampleDesc = { 1, 0 };
+	desc.Usage = D3D11_USAGE_STAGING;
+	desc.BindFlags = 0;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	desc.MiscFlags = 0;
+
+	for (uint i = 0; i < ring.GetSlotCount(); i++) {
+		winrt::com_ptr<ID3D11Texture2D> texture;
+		DX::ThrowIfFailed(device->CreateTexture2D(&desc, nullptr, texture.put()));
+		slots[i].staging = texture.as<ID3D11Resource>();
+	}
+
+	slotSize = MemoryTracker::GetSize(desc);
+	CreateFences();
+}
+
+void GpuReadback::CreateFences()
+{
+	auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+
+	D3D11_QUERY_DESC queryDesc{ D3D11_QUERY_EVENT, 0 };
+	for (uint i = 0; i < ring.GetSlotCount(); i++)
+		DX::ThrowIfFailed(device->CreateQuery(&queryDesc, slots[i].fence.put()));
+}
+
+bool GpuReadback::Copy(ID3D11Resource* a_source, uint64_t a_frame, uint a_tag, UINT a_subresource, const D3D11_BOX* a_box)
+{
+	auto index = ring.Claim(a_frame, a_tag);
+	if (!index)
+		return false;
+
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+	auto& slot = slots[*index];
+	if (a_box || a_subresource)
+		context->CopySubresourceRegion(slot.staging.get(), 0, 0, 0, 0, a_source, a_subresource, a_box);
+	else
+		context->CopyResource(slot.staging.get(), a_source);
+	context->End(slot.fence.get());
+	return true;
+}
+
+bool GpuReadback::Map(uint a_index, D3D11_MAPPED_SUBRESOURCE& a_mapped)
+{
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+	auto& slot = slots[a_index];
+	BOOL done = FALSE;
+	if (context->GetData(slot.fence.get(), &done, sizeof(done), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK || !done)
+		return false;
+
+	return context->Map(slot.staging.get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &a_mapped) == S_OK;
+}
+
+void GpuReadback::Unmap(uint a_index)
+{
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+	context->Unmap(slots[a_index].staging.get(), 0);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ReadbackRing.h"
+
+// Copies GPU resources into a ring of staging resources and hands them to the CPU once the GPU is done, without ever
+// stalling the immediate context. Each slot has an event query as its fence, and is only mapped with DO_NOT_WAIT once
+// that has passed, so a map never makes the driver flush or wait.
+class GpuReadback
+{
+public:
+	// Every copy must fit a_desc, which is turned into its staging counterpart
+	GpuReadback(const D3D11_BUFFER_DESC& a_desc, uint a_slots);
+	GpuReadback(const D3D11_TEXTURE2D_DESC& a_desc, uint a_slots);
+
+	// Copies a_source, or the a_box region of its a_subresource, false when every slot is still in flight
+	bool Copy(ID3D11Resource* a_source, uint64_t a_frame, uint a_tag = 0, UINT a_subresource = 0, const D3D11_BOX* a_box = nullptr);
+
+	// Calls a_func(slot, mapped) for up to a_max finished copies, oldest first, mapped is only valid during the call.
+	// Copies past a_max stay in the ring for the next Read.
+	template <class F>
+	uint Read(uint64_t a_frame, F&& a_func, uint a_max = ReadbackRing::MaxSlots)
+	{
+		uint read = 0;
+		return ring.Poll(a_frame, [&](uint a_index, const ReadbackRing::Slot& a_slot) {
+			if (read == a_max)
+				return false;
+			read++;
+			D3D11_MAPPED_SUBRESOURCE mapped;
+			if (!Map(a_index, mapped))
+				return false;
+			a_func(a_slot, static_cast<const D3D11_MAPPED_SUBRESOURCE&>(mapped));
+			Unmap(a_index);
+			return true;
+		});
+	}
+
+	// Forgets every copy in flight, their results are never read
+	void Reset() { ring.Reset(); }
+	bool IsFull() const { return ring.IsFull(); }
+
+	const ReadbackRing::Statistics& GetStatistics() const { return ring.GetStatistics(); }
+	// Staging memory held by every slot
+	uint64_t GetSize() const { return slotSize * ring.GetSlotCount(); }
+
+private:
+	struct Slot
+	{
+		winrt::com_ptr<ID3D11Resource> staging;
+		winrt::com_ptr<ID3D11Query> fence;
+	};
+
+	void CreateFences();
+	bool Map(uint a_index, D3D11_MAPPED_SUBRESOURCE& a_mapped);
+	void Unmap(uint a_index);
+
+	ReadbackRing ring;
+	Slot slots[ReadbackRing::MaxSlots];
+	uint64_t slotSize = 0;
+};
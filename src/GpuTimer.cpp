@@ -0,0 +1,77 @@
+#include "GpuTimer.h"
+
+bool GpuTimer::Begin(uint a_tag)
+{
+	if (!initialized)
+		supported = Initialize();
+	if (!supported)
+		return false;
+
+	auto index = ring.Claim(GetFrame(), a_tag);
+	if (!index)
+		return false;
+
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+	auto& query = queries[*index];
+	context->Begin(query.disjoint.get());
+	context->End(query.begin.get());
+	active = &query;
+	return true;
+}
+
+void GpuTimer::End()
+{
+	if (!active)
+		return;
+
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+	context->End(active->end.get());
+	context->End(active->disjoint.get());
+	active = nullptr;
+}
+
+bool GpuTimer::Initialize()
+{
+	initialized = true;
+
+	auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+
+	D3D11_QUERY_DESC disjointDesc{ D3D11_QUERY_TIMESTAMP_DISJOINT, 0 };
+	D3D11_QUERY_DESC timestampDesc{ D3D11_QUERY_TIMESTAMP, 0 };
+
+	for (auto& query : queries) {
+		if (FAILED(device->CreateQuery(&disjointDesc, query.disjoint.put())) ||
+			FAILED(device->CreateQuery(&timestampDesc, query.begin.put())) ||
+			FAILED(device->CreateQuery(&timestampDesc, query.end.put()))) {
+			logger::warn("Timestamp queries are unavailable, GPU timings are disabled");
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t GpuTimer::GetFrame()
+{
+	static auto gameViewport = RE::BSGraphics::State::GetSingleton();
+	return gameViewport->frameCount;
+}
+
+bool GpuTimer::Resolve(Query& a_query, std::optional<float>& a_milliseconds)
+{
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context);
+
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+	if (context->GetData(a_query.disjoint.get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return false;
+
+	UINT64 begin, end;
+	if (context->GetData(a_query.begin.get(), &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+		context->GetData(a_query.end.get(), &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return false;
+
+	if (!disjoint.Disjoint && end >= begin)
+		a_milliseconds = (float)((double)(end - begin) * 1000.0 / (double)disjoint.Frequency);
+	return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+
+#include "ReadbackRing.h"
+
+// Measures GPU time between Begin and End with timestamp queries. Results arrive a few frames later through Collect,
+// which never stalls. Each measurement carries a caller chosen tag.
+class GpuTimer
+{
+public:
+	static constexpr uint Latency = 4;
+
+	// False when timestamps are unsupported or every query is still in flight, End must then not be called
+	bool Begin(uint a_tag);
+	void End();
+
+	// Calls a_func(tag, milliseconds) for every finished measurement, disjoint ones are dropped
+	template <class F>
+	void Collect(F&& a_func)
+	{
+		if (!supported)
+			return;
+
+		ring.Poll(GetFrame(), [&](uint a_index, const ReadbackRing::Slot& a_slot) {
+			std::optional<float> milliseconds;
+			if (!Resolve(queries[a_index], milliseconds))
+				return false;
+			if (milliseconds)
+				a_func(a_slot.tag, *milliseconds);
+			return true;
+		});
+	}
+
+private:
+	struct Query
+	{
+		winrt::com_ptr<ID3D11Query> disjoint;
+		winrt::com_ptr<ID3D11Query> begin;
+		winrt::com_ptr<ID3D11Query> end;
+	};
+
+	bool Initialize();
+	static uint64_t GetFrame();
+	// False until the query has finished, a_milliseconds is then left empty when the timestamps were disjoint
+	bool Resolve(Query& a_query, std::optional<float>& a_milliseconds);
+
+	bool initialized = false;
+	bool supported = false;
+	ReadbackRing ring{ Latency };
+	std::array<Query, Latency> queries;
+	Query* active = nullptr;
+};
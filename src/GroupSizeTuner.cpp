@@ -0,0 +1,89 @@
+#include "GroupSizeTuner.h"
+
+#include "ConfigService.h"
+#include "Util.h"
+
+void GroupSizeTuner::RegisterINI()
+{
+	auto configService = ConfigService::GetSingleton();
+	iniFile = configService->Register(path, [this](std::string_view a_text) { ApplyINI(a_text); }, false);
+	configService->RequestLoad(iniFile);
+}
+
+void GroupSizeTuner::ApplyINI(std::string_view a_text)
+{
+	std::lock_guard<std::mutex> lk(lock);
+	loadedText = std::string(a_text);
+}
+
+uint GroupSizeTuner::Begin(Kernel a_kernel)
+{
+	if (!initialized && !Initialize())
+		return 0;
+
+	auto index = (uint)a_kernel;
+	if (results[index])
+		return *results[index];
+
+	// Untimed dispatches use the default shape
+	auto& kernel = kernels[index];
+	auto candidate = kernel.search.Next();
+	return kernel.timer.Begin(candidate) ? candidate : 0;
+}
+
+void GroupSizeTuner::End(Kernel a_kernel)
+{
+	kernels[(uint)a_kernel].timer.End();
+}
+
+void GroupSizeTuner::Update()
+{
+	if (!initialized)
+		return;
+
+	bool finished = false;
+	for (uint i = 0; i < kernels.size(); i++) {
+		if (results[i])
+			continue;
+
+		auto& kernel = kernels[i];
+		kernel.timer.Collect([&](uint a_candidate, float a_milliseconds) { kernel.search.Record(a_candidate, a_milliseconds); });
+
+		if (kernel.search.Done()) {
+			auto best = kernel.search.Best();
+			results[i] = best;
+			finished = true;
+			logger::info("[GroupSizeTuner] {} uses {}x{} thread groups", KernelNames[i], Candidates[best].x, Candidates[best].y);
+		}
+	}
+
+	if (finished)
+		Save();
+}
+
+bool GroupSizeTuner::Initialize()
+{
+	{
+		std::lock_guard<std::mutex> lk(lock);
+		if (!loadedText)
+			return false;
+		text = std::move(*loadedText);
+		loadedText.reset();
+	}
+
+	initialized = true;
+	adapter = Util::GetAdapterKey();
+	GroupSizes::ParseResults(text, adapter, results);
+
+	for (uint i = 0; i < kernels.size(); i++) {
+		if (results[i])
+			logger::info("[GroupSizeTuner] {} uses stored {}x{} thread groups", KernelNames[i], Candidates[*results[i]].x, Candidates[*results[i]].y);
+	}
+	return true;
+}
+
+void GroupSizeTuner::Save()
+{
+	text = GroupSizes::SerializeResults(text, adapter, results);
+	ConfigService::GetSingleton()->RequestSave(iniFile, text);
+}
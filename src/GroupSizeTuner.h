@@ -0,0 +1,70 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+
+#include "GpuTimer.h"
+#include "GroupSizes.h"
+
+// Picks the fastest [numthreads] shape for each full screen kernel by timing every candidate with GPU timestamps
+// during the first frames. Winners are stored per adapter and driver, so the search only runs once per setup.
+class GroupSizeTuner
+{
+public:
+	static GroupSizeTuner* GetSingleton()
+	{
+		static GroupSizeTuner singleton;
+		return &singleton;
+	}
+
+	using GroupSize = GroupSizes::GroupSize;
+	using Kernel = GroupSizes::Kernel;
+	using Results = GroupSizes::Results;
+	using Search = GroupSizes::Search;
+
+	static constexpr auto& Candidates = GroupSizes::Candidates;
+	static constexpr auto& KernelNames = GroupSizes::KernelNames;
+
+	std::filesystem::path path = L"Data/SKSE/Plugins/ENBAntiAliasing/GroupSizes.ini";
+
+	// Hands the results file to ConfigService, which reads it on its worker once started, before the first frame.
+	// Until then dispatches use the default shape and nothing is timed.
+	void RegisterINI();
+
+	// Starts timing a_kernel if it is still being tuned and returns the candidate index to dispatch with.
+	// Every Begin must be followed by End once the dispatch has been recorded.
+	uint Begin(Kernel a_kernel);
+	void End(Kernel a_kernel);
+
+	// Collects finished timings without stalling, once per frame
+	void Update();
+
+private:
+	// Timings are tagged with the candidate index
+	struct KernelState
+	{
+		Search search;
+		GpuTimer timer;
+	};
+
+	// Worker thread
+	void ApplyINI(std::string_view a_text);
+
+	// False until ConfigService has read the file
+	bool Initialize();
+	void Save();
+
+	uint32_t iniFile = 0;
+	std::mutex lock;
+	// Set by the worker, taken by the render thread
+	std::optional<std::string> loadedText;
+
+	// Render thread only from here on
+	bool initialized = false;
+	// Contents of the file as loaded or last saved, so results of other adapters are kept
+	std::string text;
+	std::string adapter;
+	Results results;
+	std::array<KernelState, KernelNames.size()> kernels;
+};
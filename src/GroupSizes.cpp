@@ -0,0 +1,120 @@
+#include "GroupSizes.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+#include "INITokenizer.h"
+
+namespace GroupSizes
+{
+	uint Search::Next()
+	{
+		for (uint i = 0; i < Candidates.size(); i++) {
+			auto candidate = (cursor + i) % Candidates.size();
+			if (recorded[candidate] < SamplesPerCandidate) {
+				cursor = (uint)candidate + 1;
+				return (uint)candidate;
+			}
+		}
+		return Best();
+	}
+
+	void Search::Record(uint a_candidate, float a_milliseconds)
+	{
+		if (skipped[a_candidate] < WarmupSamples)
+			skipped[a_candidate]++;
+		else if (recorded[a_candidate] < SamplesPerCandidate)
+			samples[a_candidate][recorded[a_candidate]++] = a_milliseconds;
+	}
+
+	bool Search::Done() const
+	{
+		return std::ranges::all_of(recorded, [](uint a_count) { return a_count == SamplesPerCandidate; });
+	}
+
+	uint Search::Best() const
+	{
+		uint best = 0;
+		float bestMedian = std::numeric_limits<float>::max();
+		for (uint i = 0; i < Candidates.size(); i++) {
+			if (!recorded[i])
+				continue;
+			auto sorted = samples[i];
+			auto middle = sorted.begin() + recorded[i] / 2;
+			std::nth_element(sorted.begin(), middle, sorted.begin() + recorded[i]);
+			// Ties keep the earlier, default shape
+			if (*middle < bestMedian) {
+				bestMedian = *middle;
+				best = i;
+			}
+		}
+		return best;
+	}
+
+	std::optional<GroupSize> ParseGroupSize(std::string_view a_text)
+	{
+		auto separator = a_text.find('x');
+		if (separator == std::string_view::npos)
+			return std::nullopt;
+
+		GroupSize size;
+		auto x = a_text.substr(0, separator);
+		auto y = a_text.substr(separator + 1);
+		if (std::from_chars(x.data(), x.data() + x.size(), size.x).ec != std::errc() ||
+			std::from_chars(y.data(), y.data() + y.size(), size.y).ec != std::errc())
+			return std::nullopt;
+		return size;
+	}
+
+	void ParseResults(std::string_view a_text, std::string_view a_adapter, Results& a_results)
+	{
+		Util::ForEachINIValue(a_text, [&](std::string_view a_section, std::string_view a_key, std::string_view a_value) {
+			if (a_section != a_adapter)
+				return;
+
+			auto size = ParseGroupSize(a_value);
+			auto kernel = std::ranges::find(KernelNames, a_key);
+			auto candidate = std::ranges::find_if(Candidates, [&](const GroupSize& a_candidate) {
+				return size && a_candidate.x == size->x && a_candidate.y == size->y;
+			});
+			// Sizes that are no longer candidates are dropped and tuned again
+			if (kernel != KernelNames.end() && candidate != Candidates.end())
+				a_results[kernel - KernelNames.begin()] = (uint)(candidate - Candidates.begin());
+		});
+	}
+
+	std::string SerializeResults(std::string_view a_text, std::string_view a_adapter, const Results& a_results)
+	{
+		std::string output;
+
+		bool inSection = false;
+		while (!a_text.empty()) {
+			auto lineEnd = a_text.find('\n');
+			auto rawLine = a_text.substr(0, lineEnd == std::string_view::npos ? a_text.size() : lineEnd + 1);
+			auto line = Util::Trim(rawLine);
+			a_text.remove_prefix(rawLine.size());
+
+			if (!line.empty() && line.front() == '[')
+				inSection = Util::GetINISection(line) == a_adapter;
+
+			if (!inSection) {
+				output += rawLine;
+				if (rawLine.back() != '\n')
+					output += '\n';
+			}
+		}
+
+		if (!output.empty() && !output.ends_with("\n\n"))
+			output += '\n';
+
+		output.append("[").append(a_adapter).append("]\n");
+		for (uint i = 0; i < a_results.size(); i++) {
+			if (!a_results[i])
+				continue;
+			auto& size = Candidates[*a_results[i]];
+			output.append(KernelNames[i]).append(" = ").append(std::to_string(size.x)).append("x").append(std::to_string(size.y)).append("\n");
+		}
+		return output;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Thread group shapes the full screen kernels are compiled with, how GroupSizeTuner picks one from timings and how
+// the picks are stored. Free of D3D, so the search runs against simulated timings and the file format is testable.
+namespace GroupSizes
+{
+	struct GroupSize
+	{
+		uint x;
+		uint y;
+
+		uint CountX(uint a_width) const { return (a_width + x - 1) / x; }
+		uint CountY(uint a_height) const { return (a_height + y - 1) / y; }
+	};
+
+	// Index 0 is the shape the shaders were written for and the fallback until tuning finishes
+	inline constexpr std::array<GroupSize, 4> Candidates = { { { 8, 8 }, { 16, 8 }, { 16, 16 }, { 32, 4 } } };
+
+	enum class Kernel
+	{
+		kEncodeTextures,
+		kRCASDirect,
+		kRCASGroupshared
+	};
+
+	inline constexpr std::array<std::string_view, 3> KernelNames = { "EncodeTextures", "RCASDirect", "RCASGroupshared" };
+
+	// Chosen candidate per kernel, unset until tuned or loaded
+	using Results = std::array<std::optional<uint>, KernelNames.size()>;
+
+	// Round-robins the candidates so drift in clocks affects them all equally, then picks the lowest median.
+	// Only sees timings, so it runs the same against GPU queries or a simulated source.
+	class Search
+	{
+	public:
+		// Samples thrown away per candidate while shaders and caches warm up
+		static constexpr uint WarmupSamples = 4;
+		static constexpr uint SamplesPerCandidate = 16;
+
+		uint Next();
+		void Record(uint a_candidate, float a_milliseconds);
+		bool Done() const;
+		uint Best() const;
+
+	private:
+		std::array<std::array<float, SamplesPerCandidate>, Candidates.size()> samples{};
+		std::array<uint, Candidates.size()> recorded{};
+		std::array<uint, Candidates.size()> skipped{};
+		uint cursor = 0;
+	};
+
+	std::optional<GroupSize> ParseGroupSize(std::string_view a_text);
+	// Reads the results stored under a_adapter, other adapters are ignored
+	void ParseResults(std::string_view a_text, std::string_view a_adapter, Results& a_results);
+	// Rewrites a_text with the a_adapter section replaced by a_results, other adapters are kept as they are
+	std::string SerializeResults(std::string_view a_text, std::string_view a_adapter, const Results& a_results);
+}
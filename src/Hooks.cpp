@@ -2,11 +2,38 @@
 
 #include <d3d11.h>
 
+#include "CapabilityCache.h"
+#include "FrameGeneration.h"
 #include "Streamline.h"
+#include "Util.h"
 
 decltype(&D3D11CreateDeviceAndSwapChain) ptrD3D11CreateDeviceAndSwapChain;
 
-HRESULT WINAPI hk_D3D11CreateDeviceAndSwapChainNoStreamline(
+struct IDXGISwapChain_Present
+{
+	static HRESULT WINAPI thunk(IDXGISwapChain* a_swapChain, UINT a_syncInterval, UINT a_flags)
+	{
+		return FrameGeneration::GetSingleton()->Present(a_swapChain, a_syncInterval, a_flags);
+	}
+	static inline REL::Relocation<decltype(thunk)> func;
+};
+
+static void InstallPresentHook(HRESULT a_result, IDXGISwapChain** a_swapChain)
+{
+	if (FAILED(a_result) || !a_swapChain || !*a_swapChain)
+		return;
+
+	// Swap chains share their vtable, hooking it again would make the original the hook itself
+	auto vtable = *reinterpret_cast<std::uintptr_t**>(*a_swapChain);
+	if (vtable[8] == reinterpret_cast<std::uintptr_t>(&IDXGISwapChain_Present::thunk))
+		return;
+
+	IDXGISwapChain_Present::func = vtable[8];
+	REL::safe_write(reinterpret_cast<std::uintptr_t>(&vtable[8]), reinterpret_cast<std::uintptr_t>(&IDXGISwapChain_Present::thunk));
+	logger::info("Hooked IDXGISwapChain::Present");
+}
+
+HRESULT WINAPI hk_D3D11CreateDeviceAndSwapChain(
 	IDXGIAdapter* pAdapter,
 	D3D_DRIVER_TYPE DriverType,
 	HMODULE Software,
@@ -21,7 +48,25 @@ HRESULT WINAPI hk_D3D11CreateDeviceAndSwapChainNoStreamline(
 	ID3D11DeviceContext** ppImmediateContext)
 {
 	const D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;  // Create a device with only the latest feature level
-	return ptrD3D11CreateDeviceAndSwapChain(pAdapter,
+
+	auto result = Streamline::GetSingleton()->CreateDeviceAndSwapChain(
+		pAdapter,
+		DriverType,
+		Software,
+		Flags,
+		&featureLevel,
+		1,
+		SDKVersion,
+		pSwapChainDesc,
+		ppSwapChain,
+		ppDevice,
+		pFeatureLevel,
+		ppImmediateContext);
+	if (SUCCEEDED(result)) {
+		InstallPresentHook(result, ppSwapChain);
+		return result;
+	}
+	result = ptrD3D11CreateDeviceAndSwapChain(pAdapter,
 		DriverType,
 		Software,
 		Flags,
@@ -33,15 +78,17 @@ HRESULT WINAPI hk_D3D11CreateDeviceAndSwapChainNoStreamline(
 		ppDevice,
 		pFeatureLevel,
 		ppImmediateContext);
+	InstallPresentHook(result, ppSwapChain);
+	return result;
 }
 
-HRESULT WINAPI hk_D3D11CreateDeviceAndSwapChain(
+HRESULT WINAPI hk_D3D11CreateDeviceAndSwapChainNoStreamline(
 	IDXGIAdapter* pAdapter,
 	D3D_DRIVER_TYPE DriverType,
 	HMODULE Software,
 	UINT Flags,
-	[[maybe_unused]] const D3D_FEATURE_LEVEL* pFeatureLevels,
-	[[maybe_unused]] UINT FeatureLevels,
+	const D3D_FEATURE_LEVEL* pFeatureLevels,
+	UINT FeatureLevels,
 	UINT SDKVersion,
 	const DXGI_SWAP_CHAIN_DESC* pSwapChainDesc,
 	IDXGISwapChain** ppSwapChain,
@@ -49,25 +96,14 @@ HRESULT WINAPI hk_D3D11CreateDeviceAndSwapChain(
 	D3D_FEATURE_LEVEL* pFeatureLevel,
 	ID3D11DeviceContext** ppImmediateContext)
 {
-	const D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;  // Create a device with only the latest feature level
-
-	auto result = Streamline::GetSingleton()->CreateDeviceAndSwapChain(
-		pAdapter,
-		DriverType,
-		Software,
-		Flags,
-		&featureLevel,
-		1,
-		SDKVersion,
-		pSwapChainDesc,
-		ppSwapChain,
-		ppDevice,
-		pFeatureLevel,
-		ppImmediateContext);
-	if (SUCCEEDED(result)) {
-		return result;
+	// Streamline was skipped for the default adapter, the game may have picked another one
+	if (pAdapter && CapabilityCache::GetSingleton()->CheckDeviceAdapter(Util::GetAdapterKey(pAdapter, true))) {
+		Streamline::GetSingleton()->StartInterposer();
+		return hk_D3D11CreateDeviceAndSwapChain(pAdapter, DriverType, Software, Flags, pFeatureLevels, FeatureLevels, SDKVersion, pSwapChainDesc, ppSwapChain, ppDevice, pFeatureLevel, ppImmediateContext);
 	}
-	return ptrD3D11CreateDeviceAndSwapChain(pAdapter,
+
+	const D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;  // Create a device with only the latest feature level
+	auto result = ptrD3D11CreateDeviceAndSwapChain(pAdapter,
 		DriverType,
 		Software,
 		Flags,
@@ -79,23 +115,32 @@ HRESULT WINAPI hk_D3D11CreateDeviceAndSwapChain(
 		ppDevice,
 		pFeatureLevel,
 		ppImmediateContext);
+	InstallPresentHook(result, ppSwapChain);
+	return result;
 }
 
 namespace Hooks
 {
+	HRESULT Present(IDXGISwapChain* a_swapChain, UINT a_syncInterval, UINT a_flags)
+	{
+		return IDXGISwapChain_Present::func(a_swapChain, a_syncInterval, a_flags);
+	}
+
 	void InstallD3DHooks()
 	{
-		if (!REL::Module::IsVR()) {
-			auto streamline = Streamline::GetSingleton();
+		auto adapter = Util::GetDefaultAdapterKey(true);
+		bool skipStreamline = !CapabilityCache::GetSingleton()->ShouldLoadStreamline(adapter);
 
-			streamline->LoadInterposer();
+		if (skipStreamline)
+			logger::info("[Streamline] DLSS is known to be unavailable on {}, not loading Streamline", adapter);
+		else
+			Streamline::GetSingleton()->StartInterposer();
 
-			logger::info("Hooking D3D11CreateDeviceAndSwapChain");
+		logger::info("Hooking D3D11CreateDeviceAndSwapChain");
 
-			if (streamline->interposer)
-				*(uintptr_t*)&ptrD3D11CreateDeviceAndSwapChain = SKSE::PatchIAT(hk_D3D11CreateDeviceAndSwapChain, "d3d11.dll", "D3D11CreateDeviceAndSwapChain");
-			else 
-				*(uintptr_t*)&ptrD3D11CreateDeviceAndSwapChain = SKSE::PatchIAT(hk_D3D11CreateDeviceAndSwapChainNoStreamline, "d3d11.dll", "D3D11CreateDeviceAndSwapChain");
-		}
+		if (!skipStreamline)
+			*(uintptr_t*)&ptrD3D11CreateDeviceAndSwapChain = SKSE::PatchIAT(hk_D3D11CreateDeviceAndSwapChain, "d3d11.dll", "D3D11CreateDeviceAndSwapChain");
+		else 
+			*(uintptr_t*)&ptrD3D11CreateDeviceAndSwapChain = SKSE::PatchIAT(hk_D3D11CreateDeviceAndSwapChainNoStreamline, "d3d11.dll", "D3D11CreateDeviceAndSwapChain");
 	}
 }
\ No newline at end of file
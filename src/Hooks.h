@@ -3,4 +3,6 @@
 namespace Hooks
 {
 	void InstallD3DHooks();
+	// Calls the swap chain's original Present, skipping the plugin's hook
+	HRESULT Present(IDXGISwapChain* a_swapChain, UINT a_syncInterval, UINT a_flags);
 }
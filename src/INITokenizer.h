@@ -0,0 +1,55 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+// The one INI reader shared by the settings, tuning results and capability cache files. Free of the plugin's
+// dependencies so the file formats can be tested on their own.
+namespace Util
+{
+	inline std::string_view Trim(std::string_view a_text)
+	{
+		auto begin = a_text.find_first_not_of(" \t\r\n");
+		if (begin == std::string_view::npos)
+			return {};
+		auto end = a_text.find_last_not_of(" \t\r\n");
+		return a_text.substr(begin, end - begin + 1);
+	}
+
+	// Name of the section a trimmed line opens, unset for any other line
+	inline std::optional<std::string_view> GetINISection(std::string_view a_line)
+	{
+		if (a_line.empty() || a_line.front() != '[')
+			return std::nullopt;
+		auto close = a_line.find(']');
+		if (close == std::string_view::npos)
+			return std::nullopt;
+		return Trim(a_line.substr(1, close - 1));
+	}
+
+	// Calls a_func(section, key, value) for each key, all trimmed. Comments starting with # or ; and lines without an
+	// = are skipped, keys before the first section get an empty section.
+	template <class F>
+	void ForEachINIValue(std::string_view a_text, F&& a_func)
+	{
+		std::string_view section;
+		while (!a_text.empty()) {
+			auto lineEnd = a_text.find('\n');
+			auto line = Trim(a_text.substr(0, lineEnd));
+			a_text = lineEnd == std::string_view::npos ? std::string_view{} : a_text.substr(lineEnd + 1);
+
+			if (line.empty() || line.front() == '#' || line.front() == ';')
+				continue;
+
+			if (line.front() == '[') {
+				// A header without its ] keeps the [, so it ends the previous section and matches no name
+				section = GetINISection(line).value_or(line);
+				continue;
+			}
+
+			auto equals = line.find('=');
+			if (equals != std::string_view::npos)
+				a_func(section, Trim(line.substr(0, equals)), Trim(line.substr(equals + 1)));
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+
+// Per call site limiter for messages that can fire every frame. At most one message passes per interval, and the
+// next one that passes reports how many were dropped in between.
+//
+//	static LogLimiter limiter;
+//	if (auto repeats = limiter.Check())
+//		logger::error("Something failed{}", *repeats);
+class LogLimiter
+{
+public:
+	explicit LogLimiter(std::chrono::milliseconds a_interval = std::chrono::seconds(5)) :
+		interval(a_interval.count()) {}
+
+	// Set when the message should be logged, holding a " (suppressed N repeats)" suffix or an empty string
+	std::optional<std::string> Check() { return Check(std::chrono::steady_clock::now()); }
+
+	std::optional<std::string> Check(std::chrono::steady_clock::time_point a_now)
+	{
+		auto now = std::chrono::duration_cast<std::chrono::milliseconds>(a_now.time_since_epoch()).count();
+		auto allowed = next.load(std::memory_order_relaxed);
+		if (now < allowed || !next.compare_exchange_strong(allowed, now + interval, std::memory_order_relaxed)) {
+			suppressed.fetch_add(1, std::memory_order_relaxed);
+			return std::nullopt;
+		}
+
+		auto repeats = suppressed.exchange(0, std::memory_order_relaxed);
+		if (!repeats)
+			return std::string{};
+		return " (suppressed " + std::to_string(repeats) + " repeats)";
+	}
+
+private:
+	int64_t interval;
+	std::atomic<int64_t> next = 0;
+	std::atomic<uint32_t> suppressed = 0;
+};
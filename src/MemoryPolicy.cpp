@@ -0,0 +1,58 @@
+#include "MemoryPolicy.h"
+
+uint64_t MemoryPolicy::EnterThreshold(Level a_level) const
+{
+	switch (a_level) {
+	case Level::kNoFrameGeneration:
+		return thresholds.noFrameGeneration;
+	case Level::kTAAOnly:
+		return thresholds.taaOnly;
+	default:
+		return 0;
+	}
+}
+
+MemoryPolicy::Level MemoryPolicy::Update(uint64_t a_frame, const Sample& a_sample)
+{
+	// An adapter that reports no budget cannot be degraded for
+	if (!a_sample.budget)
+		return level;
+
+	if (changed && a_frame - lastChange < thresholds.minDwell)
+		return level;
+
+	auto headroom = GetHeadroom(a_sample);
+
+	// Goes as deep as the levels entered so far could not free enough for, a sudden drop or a level holding nothing
+	// does not wait minDwell at every level on the way
+	auto next = level;
+	uint64_t moved = 0;
+	while ((uint)next + 1 < LevelCount && headroom + (int64_t)moved < (int64_t)EnterThreshold((Level)((uint)next + 1))) {
+		next = (Level)((uint)next + 1);
+		freed[(uint)next] = next == Level::kNoFrameGeneration ? a_sample.frameGenerationBytes : a_sample.upscalingBytes;
+		moved += freed[(uint)next];
+	}
+	if (next == level && level != Level::kNormal && headroom >= (int64_t)(EnterThreshold(level) + freed[(uint)level] + thresholds.hysteresis)) {
+		moved = freed[(uint)level];
+		next = (Level)((uint)level - 1);
+	}
+
+	if (next != level) {
+		level = next;
+		// A level that freed nothing, e.g. frame generation that was off, leaves no allocation to settle
+		if (moved) {
+			lastChange = a_frame;
+			changed = true;
+		}
+	}
+	return level;
+}
+
+void MemoryPolicy::Reset()
+{
+	level = Level::kNormal;
+	lastChange = 0;
+	changed = false;
+	for (auto& bytes : freed)
+		bytes = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// Degrades the plugin as DXGI's video memory budget runs out. Each level drops more of what the plugin holds, and a
+// level is only left again once the headroom could take back what it freed with room to spare, so the plugin does not
+// oscillate between allocating and freeing the same resources.
+// Only sees byte counts and frame numbers, so it can be driven by a simulated budget.
+class MemoryPolicy
+{
+public:
+	// Ordered from no degradation to the most
+	enum class Level
+	{
+		kNormal,
+		kNoFrameGeneration,
+		kTAAOnly
+	};
+
+	static constexpr uint LevelCount = 3;
+
+	struct Thresholds
+	{
+		// Headroom below which each level past kNormal is entered
+		uint64_t noFrameGeneration = 256ull << 20;
+		uint64_t taaOnly = 64ull << 20;
+		// Extra headroom needed on top of the restored resources before leaving a level
+		uint64_t hysteresis = 128ull << 20;
+		// Frames that must pass between changes, a budget sample often lags the allocation that changed it
+		uint64_t minDwell = 600;
+	};
+
+	struct Sample
+	{
+		uint64_t budget = 0;
+		uint64_t usage = 0;
+		// Bytes the plugin currently holds for what each level drops
+		uint64_t frameGenerationBytes = 0;
+		uint64_t upscalingBytes = 0;
+	};
+
+	Thresholds thresholds;
+
+	Level Update(uint64_t a_frame, const Sample& a_sample);
+	void Reset();
+
+	Level GetLevel() const { return level; }
+	// Negative when usage is already over budget
+	static int64_t GetHeadroom(const Sample& a_sample) { return (int64_t)a_sample.budget - (int64_t)a_sample.usage; }
+
+private:
+	uint64_t EnterThreshold(Level a_level) const;
+
+	Level level = Level::kNormal;
+	uint64_t lastChange = 0;
+	bool changed = false;
+	// Bytes freed on entering each level, taken back when leaving it
+	uint64_t freed[LevelCount]{};
+};
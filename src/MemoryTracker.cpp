@@ -0,0 +1,92 @@
+#include "MemoryTracker.h"
+
+void MemoryTracker::Add(Category a_category, uint64_t a_bytes)
+{
+	bytes[(uint)a_category].fetch_add(a_bytes, std::memory_order_relaxed);
+}
+
+void MemoryTracker::Remove(Category a_category, uint64_t a_bytes)
+{
+	auto& value = bytes[(uint)a_category];
+	auto current = value.load(std::memory_order_relaxed);
+	// Only the render thread writes, so no write can be lost between the load and store
+	value.store(current > a_bytes ? current - a_bytes : 0, std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::GetTotal() const
+{
+	uint64_t total = 0;
+	for (auto& value : bytes)
+		total += value.load(std::memory_order_relaxed);
+	return total;
+}
+
+uint MemoryTracker::GetBitsPerPixel(DXGI_FORMAT a_format)
+{
+	switch (a_format) {
+	case DXGI_FORMAT_R8_UNORM:
+	case DXGI_FORMAT_R8_UINT:
+	case DXGI_FORMAT_R8_TYPELESS:
+		return 8;
+	case DXGI_FORMAT_R8G8_UNORM:
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_R16_UNORM:
+	case DXGI_FORMAT_R16_TYPELESS:
+		return 16;
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+	case DXGI_FORMAT_R32G32_FLOAT:
+		return 64;
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+		return 128;
+	default:
+		return 32;
+	}
+}
+
+uint64_t MemoryTracker::GetSize(const D3D11_TEXTURE2D_DESC& a_desc)
+{
+	uint64_t size = 0;
+	uint64_t width = a_desc.Width;
+	uint64_t height = a_desc.Height;
+	for (uint mip = 0; mip < std::max(a_desc.MipLevels, 1u); mip++) {
+		size += width * height;
+		width = std::max(width / 2, 1ull);
+		height = std::max(height / 2, 1ull);
+	}
+	return size * GetBitsPerPixel(a_desc.Format) / 8 * std::max(a_desc.ArraySize, 1u) * std::max(a_desc.SampleDesc.Count, 1u);
+}
+
+uint64_t MemoryTracker::GetSize(const D3D11_BUFFER_DESC& a_desc)
+{
+	return a_desc.ByteWidth;
+}
+
+bool MemoryTracker::QueryBudget()
+{
+	if (!adapterQueried) {
+		adapterQueried = true;
+		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+
+		winrt::com_ptr<IDXGIDevice> dxgiDevice;
+		winrt::com_ptr<IDXGIAdapter> dxgiAdapter;
+		if (FAILED(device->QueryInterface(IID_PPV_ARGS(dxgiDevice.put()))) || FAILED(dxgiDevice->GetAdapter(dxgiAdapter.put())) ||
+			FAILED(dxgiAdapter->QueryInterface(IID_PPV_ARGS(adapter.put())))) {
+			logger::warn("[MemoryTracker] DXGI 1.4 is unavailable, video memory budget is unknown");
+			adapter = nullptr;
+		}
+	}
+
+	if (!adapter)
+		return false;
+
+	DXGI_QUERY_VIDEO_MEMORY_INFO info{};
+	if (FAILED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+		return false;
+
+	budget.store(info.Budget, std::memory_order_relaxed);
+	usage.store(info.CurrentUsage, std::memory_order_relaxed);
+	return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+
+#include <dxgi1_4.h>
+
+// Video memory the plugin holds, split by what holds it, next to DXGI's budget for the process. Owners add what they
+// allocate and remove it again when freeing, upscaler internals are added as the upscaler reports them. Written by the
+// render thread, read by the UI.
+class MemoryTracker
+{
+public:
+	static MemoryTracker* GetSingleton()
+	{
+		static MemoryTracker singleton;
+		return &singleton;
+	}
+
+	enum class Category
+	{
+		// Textures and buffers every upscaler uses
+		kShared,
+		kFSR,
+		kDLSS,
+		// FSR optical flow and interpolation, plus the copies FrameGeneration presents from
+		kFrameGeneration,
+		// Staging copies FrameCapture reads back, never degraded since capturing is explicitly requested
+		kCapture
+	};
+
+	static constexpr uint CategoryCount = 5;
+
+	void Add(Category a_category, uint64_t a_bytes);
+	void Remove(Category a_category, uint64_t a_bytes);
+	uint64_t Get(Category a_category) const { return bytes[(uint)a_category].load(std::memory_order_relaxed); }
+	uint64_t GetTotal() const;
+
+	// Every other format the game's targets use is 32 bits
+	static uint GetBitsPerPixel(DXGI_FORMAT a_format);
+	// Allocation sizes ignore padding and alignment, which the driver does not report
+	static uint64_t GetSize(const D3D11_TEXTURE2D_DESC& a_desc);
+	static uint64_t GetSize(const D3D11_BUFFER_DESC& a_desc);
+
+	// Local segment of the adapter the game renders with, zero until queried or when it reports no budget
+	std::atomic<uint64_t> budget = 0;
+	std::atomic<uint64_t> usage = 0;
+
+	// Refreshes budget and usage, false when DXGI 1.4 is unavailable
+	bool QueryBudget();
+
+private:
+	std::atomic<uint64_t> bytes[CategoryCount]{};
+
+	winrt::com_ptr<IDXGIAdapter3> adapter;
+	bool adapterQueried = false;
+};
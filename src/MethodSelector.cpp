@@ -0,0 +1,117 @@
+#include "MethodSelector.h"
+
+MethodSelector::Method MethodSelector::Update(uint64_t a_frame, uint a_available, Method a_ceiling)
+{
+	frame = a_frame;
+	available = (a_available & ((Bit(a_ceiling) << 1) - 1)) | Bit(Method::kTAA);
+
+	if (!(available & Bit(choice))) {
+		measuring = false;
+		choice = Method::kTAA;
+		decided = false;
+	}
+
+	if (measuring) {
+		// Timings can stop arriving, for example when a backend fails, which counts as too expensive
+		if (a_frame - measureStart > 4 * (thresholds.discardSamples + thresholds.samples)) {
+			estimates[(uint)measured] = { std::numeric_limits<float>::max(), a_frame, true };
+			measuring = false;
+		} else {
+			return measured;
+		}
+	}
+
+	bool headroom = estimates[(uint)choice].valid && estimates[(uint)choice].cost < thresholds.budget * (1.0f - thresholds.hysteresis);
+
+	for (int i = MethodCount - 1; i >= 0; i--) {
+		auto method = (Method)i;
+		auto& estimate = estimates[i];
+		if (!(available & Bit(method)))
+			continue;
+
+		bool stale = method > choice && headroom && a_frame - estimate.frame >= thresholds.resampleInterval;
+		if (!estimate.valid || stale) {
+			StartMeasuring(a_frame, method);
+			return method;
+		}
+	}
+
+	Decide(a_frame);
+	return choice;
+}
+
+void MethodSelector::Record(Method a_method, float a_milliseconds)
+{
+	if (measuring && a_method == measured) {
+		if (discarded < thresholds.discardSamples) {
+			discarded++;
+			return;
+		}
+
+		measuredTotal += a_milliseconds;
+		if (++measuredSamples >= thresholds.samples) {
+			estimates[(uint)measured] = { measuredTotal / (float)measuredSamples, frame, true };
+			measuring = false;
+		}
+	} else if (!measuring && a_method == choice) {
+		// Slow moving average, a single spike must not cause a switch
+		auto& estimate = estimates[(uint)choice];
+		estimate.cost = estimate.valid ? estimate.cost + (a_milliseconds - estimate.cost) * 0.05f : a_milliseconds;
+		estimate.frame = frame;
+		estimate.valid = true;
+	}
+}
+
+void MethodSelector::Reset()
+{
+	auto saved = thresholds;
+	*this = MethodSelector();
+	thresholds = saved;
+}
+
+float MethodSelector::GetEstimate(Method a_method) const
+{
+	auto& estimate = estimates[(uint)a_method];
+	return estimate.valid ? estimate.cost : -1.0f;
+}
+
+void MethodSelector::StartMeasuring(uint64_t a_frame, Method a_method)
+{
+	measuring = true;
+	measured = a_method;
+	measureStart = a_frame;
+	discarded = 0;
+	measuredSamples = 0;
+	measuredTotal = 0.0f;
+}
+
+void MethodSelector::Decide(uint64_t a_frame)
+{
+	if (decided && a_frame - lastSwitch < thresholds.minDwell)
+		return;
+
+	auto best = Method::kTAA;
+	for (int i = MethodCount - 1; i >= 0; i--) {
+		auto method = (Method)i;
+		auto& estimate = estimates[i];
+		if (!(available & Bit(method)) || !estimate.valid)
+			continue;
+
+		auto limit = thresholds.budget;
+		if (decided && method > choice)
+			limit *= 1.0f - thresholds.hysteresis;
+		else if (decided && method == choice)
+			limit *= 1.0f + thresholds.hysteresis;
+
+		if (estimate.cost <= limit) {
+			best = method;
+			break;
+		}
+	}
+
+	if (!decided || best != choice) {
+		choice = best;
+		lastSwitch = a_frame;
+		decided = true;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+
+// Picks the best looking upscaling method whose measured GPU cost fits a budget. Every allowed method is measured once
+// during warm-up, the active one continuously, and better looking ones again after resampleInterval if there is
+// headroom. Switching needs the cost to clear the budget by the hysteresis margin and a minimum dwell in between.
+// Only sees frame numbers and timings, so it can be driven by recorded traces.
+class MethodSelector
+{
+public:
+	// Ordered from lowest to highest quality, matches Upscaling::UpscaleMethod
+	enum class Method
+	{
+		kTAA,
+		kFSR,
+		kDLSS
+	};
+
+	static constexpr uint MethodCount = 3;
+
+	struct Thresholds
+	{
+		// GPU milliseconds the anti-aliasing pass may take
+		float budget = 2.0f;
+		// Fraction of the budget a better method must stay under to switch up, or the active one may exceed before
+		// switching down
+		float hysteresis = 0.15f;
+		// Timings thrown away at the start of a measurement while the method warms up
+		uint discardSamples = 4;
+		uint samples = 16;
+		// Frames that must pass between switches
+		uint64_t minDwell = 300;
+		// Frames after which an estimate for a better method is considered stale
+		uint64_t resampleInterval = 18000;
+	};
+
+	Thresholds thresholds;
+
+	// Returns the method to run this frame. a_available has a bit per Method, a_ceiling is the best method allowed.
+	Method Update(uint64_t a_frame, uint a_available, Method a_ceiling);
+	// Timing of a frame that ran a_method, may arrive a few frames late
+	void Record(Method a_method, float a_milliseconds);
+	void Reset();
+
+	Method GetChoice() const { return choice; }
+	bool IsMeasuring() const { return measuring; }
+	// Negative when a_method has not been measured
+	float GetEstimate(Method a_method) const;
+
+private:
+	struct Estimate
+	{
+		float cost = 0.0f;
+		uint64_t frame = 0;
+		bool valid = false;
+	};
+
+	static constexpr uint Bit(Method a_method) { return 1u << (uint)a_method; }
+
+	void StartMeasuring(uint64_t a_frame, Method a_method);
+	void Decide(uint64_t a_frame);
+
+	std::array<Estimate, MethodCount> estimates;
+	uint available = Bit(Method::kTAA);
+	uint64_t frame = 0;
+
+	Method choice = Method::kTAA;
+	uint64_t lastSwitch = 0;
+	bool decided = false;
+
+	// Measurement of a method other than the active one
+	bool measuring = false;
+	Method measured = Method::kTAA;
+	uint64_t measureStart = 0;
+	uint discarded = 0;
+	uint measuredSamples = 0;
+	float measuredTotal = 0.0f;
+};
@@ -0,0 +1,686 @@
+#include "PlaneCodec.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#	include <emmintrin.h>
+#	define PLANE_CODEC_SSE2
+#endif
+
+namespace PlaneCodec
+{
+	// Followed by the stored size of every band as uint64_t, then the bands in order
+	struct StreamHeader
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t pixelSize;
+		// Bytes per predicted channel, 1, 2 or 4
+		uint32_t laneSize;
+		uint32_t flags;
+		uint32_t bandRows;
+		uint32_t bandCount;
+		uint32_t reserved;
+	};
+
+	static_assert(sizeof(StreamHeader) == 32);
+
+	// Channels are sign and magnitude floats
+	static constexpr uint32_t FloatLanes = 1;
+
+	// Bytes bit packed together, each block stores its width in a nibble
+	static constexpr std::size_t BlockSize = 32;
+	static constexpr uint32_t MaxPixelSize = 16;
+
+	struct LaneLayout
+	{
+		uint32_t laneSize = 1;
+		bool floatLanes = false;
+	};
+
+	// DXGI_FORMAT values, spelled out so this compiles without the Windows headers
+	static LaneLayout GetLaneLayout(uint32_t a_format, uint32_t a_pixelSize)
+	{
+		LaneLayout layout;
+		switch (a_format) {
+		case 1:   // R32G32B32A32_TYPELESS
+		case 2:   // R32G32B32A32_FLOAT
+		case 6:   // R32G32B32_FLOAT
+		case 15:  // R32G32_TYPELESS
+		case 16:  // R32G32_FLOAT
+		case 19:  // R32G8X24_TYPELESS
+		case 20:  // D32_FLOAT_S8X24_UINT
+		case 21:  // R32_FLOAT_X8X24_TYPELESS
+		case 39:  // R32_TYPELESS
+		case 40:  // D32_FLOAT
+		case 41:  // R32_FLOAT
+			layout = { 4, true };
+			break;
+		case 3:   // R32G32B32A32_UINT
+		case 4:   // R32G32B32A32_SINT
+		case 17:  // R32G32_UINT
+		case 18:  // R32G32_SINT
+		case 42:  // R32_UINT
+		case 43:  // R32_SINT
+		case 44:  // R24G8_TYPELESS
+		case 45:  // D24_UNORM_S8_UINT
+		case 46:  // R24_UNORM_X8_TYPELESS
+		case 47:  // X24_TYPELESS_G8_UINT
+			layout = { 4, false };
+			break;
+		case 9:   // R16G16B16A16_TYPELESS
+		case 10:  // R16G16B16A16_FLOAT
+		case 33:  // R16G16_TYPELESS
+		case 34:  // R16G16_FLOAT
+		case 53:  // R16_TYPELESS
+		case 54:  // R16_FLOAT
+			layout = { 2, true };
+			break;
+		case 11:  // R16G16B16A16_UNORM
+		case 12:  // R16G16B16A16_UINT
+		case 13:  // R16G16B16A16_SNORM
+		case 14:  // R16G16B16A16_SINT
+		case 35:  // R16G16_UNORM
+		case 36:  // R16G16_UINT
+		case 37:  // R16G16_SNORM
+		case 38:  // R16G16_SINT
+		case 55:  // D16_UNORM
+		case 56:  // R16_UNORM
+		case 57:  // R16_UINT
+		case 58:  // R16_SNORM
+		case 59:  // R16_SINT
+			layout = { 2, false };
+			break;
+		default:
+			break;
+		}
+
+		if (a_pixelSize % layout.laneSize)
+			layout = {};
+		return layout;
+	}
+
+	// Maps floats to integers that order like the floats, so nearby values have small differences. Its own inverse.
+	template <class T>
+	static T Order(T a_value)
+	{
+		auto sign = (T)((std::make_signed_t<T>)a_value >> (sizeof(T) * 8 - 1));
+		return (T)(a_value ^ (T)(sign >> 1));
+	}
+
+	// Interleaves negative and positive residuals so small magnitudes only use low bits
+	template <class T>
+	static T ZigZag(T a_value)
+	{
+		return (T)((T)(a_value << 1) ^ (T)((std::make_signed_t<T>)a_value >> (sizeof(T) * 8 - 1)));
+	}
+
+	template <class T>
+	static T UnZigZag(T a_value)
+	{
+		return (T)((T)(a_value >> 1) ^ (T)(0u - (a_value & 1u)));
+	}
+
+	template <class T>
+	static T Load(const uint8_t* a_row, std::size_t a_lane)
+	{
+		T value;
+		std::memcpy(&value, a_row + a_lane * sizeof(T), sizeof(T));
+		return value;
+	}
+
+	template <class T>
+	static void Store(uint8_t* a_row, std::size_t a_lane, T a_value)
+	{
+		std::memcpy(a_row + a_lane * sizeof(T), &a_value, sizeof(T));
+	}
+
+#ifdef PLANE_CODEC_SSE2
+	template <class T>
+	static __m128i Add(__m128i a_left, __m128i a_right)
+	{
+		if constexpr (sizeof(T) == 1)
+			return _mm_add_epi8(a_left, a_right);
+		else if constexpr (sizeof(T) == 2)
+			return _mm_add_epi16(a_left, a_right);
+		else
+			return _mm_add_epi32(a_left, a_right);
+	}
+
+	template <class T>
+	static __m128i Sub(__m128i a_left, __m128i a_right)
+	{
+		if constexpr (sizeof(T) == 1)
+			return _mm_sub_epi8(a_left, a_right);
+		else if constexpr (sizeof(T) == 2)
+			return _mm_sub_epi16(a_left, a_right);
+		else
+			return _mm_sub_epi32(a_left, a_right);
+	}
+
+	template <class T>
+	static __m128i Order(__m128i a_value)
+	{
+		if constexpr (sizeof(T) == 1)
+			return a_value;
+		else if constexpr (sizeof(T) == 2)
+			return _mm_xor_si128(a_value, _mm_srli_epi16(_mm_srai_epi16(a_value, 15), 1));
+		else
+			return _mm_xor_si128(a_value, _mm_srli_epi32(_mm_srai_epi32(a_value, 31), 1));
+	}
+
+	template <class T>
+	static __m128i ZigZag(__m128i a_value)
+	{
+		if constexpr (sizeof(T) == 1)
+			return _mm_xor_si128(_mm_add_epi8(a_value, a_value), _mm_cmpgt_epi8(_mm_setzero_si128(), a_value));
+		else if constexpr (sizeof(T) == 2)
+			return _mm_xor_si128(_mm_slli_epi16(a_value, 1), _mm_srai_epi16(a_value, 15));
+		else
+			return _mm_xor_si128(_mm_slli_epi32(a_value, 1), _mm_srai_epi32(a_value, 31));
+	}
+
+	template <class T>
+	static __m128i UnZigZag(__m128i a_value)
+	{
+		if constexpr (sizeof(T) == 1) {
+			auto half = _mm_and_si128(_mm_srli_epi16(a_value, 1), _mm_set1_epi8(0x7F));
+			return _mm_xor_si128(half, _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(a_value, _mm_set1_epi8(1))));
+		} else if constexpr (sizeof(T) == 2) {
+			return _mm_xor_si128(_mm_srli_epi16(a_value, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(a_value, _mm_set1_epi16(1))));
+		} else {
+			return _mm_xor_si128(_mm_srli_epi32(a_value, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(a_value, _mm_set1_epi32(1))));
+		}
+	}
+
+	static __m128i LoadVector(const uint8_t* a_data)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_data));
+	}
+
+	static void StoreVector(uint8_t* a_data, __m128i a_value)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(a_data), a_value);
+	}
+#endif
+
+	// Residual of each channel against the gradient predictor left + up - up left, a_up is zeros on a band's first row
+	template <class T>
+	static void EncodeRow(const uint8_t* a_row, const uint8_t* a_up, uint8_t* a_out, std::size_t a_lanes, std::size_t a_channels, bool a_float)
+	{
+		auto value = [&](const uint8_t* a_source, std::size_t a_lane) {
+			auto v = Load<T>(a_source, a_lane);
+			return a_float ? Order(v) : v;
+		};
+
+		std::size_t x = 0;
+		for (; x < std::min(a_channels, a_lanes); x++)
+			Store<T>(a_out, x, ZigZag<T>((T)(value(a_row, x) - value(a_up, x))));
+
+#ifdef PLANE_CODEC_SSE2
+		constexpr std::size_t Step = 16 / sizeof(T);
+		auto stride = a_channels * sizeof(T);
+		for (; x + Step <= a_lanes; x += Step) {
+			auto offset = x * sizeof(T);
+			auto current = LoadVector(a_row + offset);
+			auto left = LoadVector(a_row + offset - stride);
+			auto up = LoadVector(a_up + offset);
+			auto upLeft = LoadVector(a_up + offset - stride);
+			if (a_float) {
+				current = Order<T>(current);
+				left = Order<T>(left);
+				up = Order<T>(up);
+				upLeft = Order<T>(upLeft);
+			}
+			auto prediction = Sub<T>(Add<T>(left, up), upLeft);
+			StoreVector(a_out + offset, ZigZag<T>(Sub<T>(current, prediction)));
+		}
+#endif
+
+		for (; x < a_lanes; x++) {
+			auto prediction = (T)(value(a_row, x - a_channels) + value(a_up, x) - value(a_up, x - a_channels));
+			Store<T>(a_out, x, ZigZag<T>((T)(value(a_row, x) - prediction)));
+		}
+	}
+
+#ifdef PLANE_CODEC_SSE2
+	// Decodes whole vectors of pixels of PixelSize bytes, returns the first lane left for the scalar loop. The residual
+	// is the change of (value - up) along the row, so that is summed up per channel within the vector, continued from
+	// the previous vector's last pixel, then up is added back.
+	template <class T, uint32_t PixelSize>
+	static std::size_t DecodeVectors(const uint8_t* a_residuals, const uint8_t* a_up, uint8_t* a_row, std::size_t a_lanes, bool a_float)
+	{
+		constexpr std::size_t Step = 16 / sizeof(T);
+		auto carry = _mm_setzero_si128();
+		std::size_t x = 0;
+		for (; x + Step <= a_lanes; x += Step) {
+			auto offset = x * sizeof(T);
+			auto sum = UnZigZag<T>(LoadVector(a_residuals + offset));
+			sum = Add<T>(sum, _mm_slli_si128(sum, PixelSize));
+			if constexpr (PixelSize == 4)
+				sum = Add<T>(sum, _mm_slli_si128(sum, 8));
+			sum = Add<T>(sum, carry);
+			carry = PixelSize == 4 ? _mm_shuffle_epi32(sum, _MM_SHUFFLE(3, 3, 3, 3)) : _mm_shuffle_epi32(sum, _MM_SHUFFLE(3, 2, 3, 2));
+
+			auto up = LoadVector(a_up + offset);
+			auto value = Add<T>(sum, a_float ? Order<T>(up) : up);
+			StoreVector(a_row + offset, a_float ? Order<T>(value) : value);
+		}
+		return x;
+	}
+#endif
+
+	template <class T>
+	static void DecodeRow(const uint8_t* a_residuals, const uint8_t* a_up, uint8_t* a_row, std::size_t a_lanes, std::size_t a_channels, bool a_float)
+	{
+		auto value = [&](const uint8_t* a_source, std::size_t a_lane) {
+			auto v = Load<T>(a_source, a_lane);
+			return a_float ? Order(v) : v;
+		};
+
+		std::size_t x = 0;
+#ifdef PLANE_CODEC_SSE2
+		if (a_channels * sizeof(T) == 4)
+			x = DecodeVectors<T, 4>(a_residuals, a_up, a_row, a_lanes, a_float);
+		else if (a_channels * sizeof(T) == 8)
+			x = DecodeVectors<T, 8>(a_residuals, a_up, a_row, a_lanes, a_float);
+#endif
+		for (; x < a_lanes; x++) {
+			auto prediction = value(a_up, x);
+			if (x >= a_channels)
+				prediction = (T)(prediction + value(a_row, x - a_channels) - value(a_up, x - a_channels));
+			auto decoded = (T)(UnZigZag(Load<T>(a_residuals, x)) + prediction);
+			Store<T>(a_row, x, a_float ? Order(decoded) : decoded);
+		}
+	}
+
+	// Splits a_count pixels of a_pixelSize bytes into one plane per byte, a_stride bytes apart
+	template <uint32_t PixelSize>
+	static void Shuffle(const uint8_t* a_pixels, uint8_t* a_planes, std::size_t a_count, std::size_t a_stride)
+	{
+		for (std::size_t i = 0; i < a_count; i++) {
+			for (uint32_t k = 0; k < PixelSize; k++)
+				a_planes[k * a_stride + i] = a_pixels[i * PixelSize + k];
+		}
+	}
+
+	template <uint32_t PixelSize>
+	static void Unshuffle(const uint8_t* a_planes, uint8_t* a_pixels, std::size_t a_count, std::size_t a_stride)
+	{
+		for (std::size_t i = 0; i < a_count; i++) {
+			for (uint32_t k = 0; k < PixelSize; k++)
+				a_pixels[i * PixelSize + k] = a_planes[k * a_stride + i];
+		}
+	}
+
+	// Fixed sizes let the loops above unroll for the common formats
+	static void Shuffle(const uint8_t* a_pixels, uint8_t* a_planes, std::size_t a_count, std::size_t a_stride, uint32_t a_pixelSize)
+	{
+		switch (a_pixelSize) {
+		case 1:
+			std::memcpy(a_planes, a_pixels, a_count);
+			break;
+		case 2:
+			Shuffle<2>(a_pixels, a_planes, a_count, a_stride);
+			break;
+		case 4:
+			Shuffle<4>(a_pixels, a_planes, a_count, a_stride);
+			break;
+		case 8:
+			Shuffle<8>(a_pixels, a_planes, a_count, a_stride);
+			break;
+		default:
+			for (std::size_t i = 0; i < a_count; i++) {
+				for (uint32_t k = 0; k < a_pixelSize; k++)
+					a_planes[k * a_stride + i] = a_pixels[i * a_pixelSize + k];
+			}
+			break;
+		}
+	}
+
+	static void Unshuffle(const uint8_t* a_planes, uint8_t* a_pixels, std::size_t a_count, std::size_t a_stride, uint32_t a_pixelSize)
+	{
+		switch (a_pixelSize) {
+		case 1:
+			std::memcpy(a_pixels, a_planes, a_count);
+			break;
+		case 2:
+			Unshuffle<2>(a_planes, a_pixels, a_count, a_stride);
+			break;
+		case 4:
+			Unshuffle<4>(a_planes, a_pixels, a_count, a_stride);
+			break;
+		case 8:
+			Unshuffle<8>(a_planes, a_pixels, a_count, a_stride);
+			break;
+		default:
+			for (std::size_t i = 0; i < a_count; i++) {
+				for (uint32_t k = 0; k < a_pixelSize; k++)
+					a_pixels[i * a_pixelSize + k] = a_planes[k * a_stride + i];
+			}
+			break;
+		}
+	}
+
+	// Writes the bits of a block at the width of its largest byte, one 32 bit word per bit, returns the width
+	static uint32_t PackBlock(const uint8_t* a_block, uint8_t*& a_out)
+	{
+#ifdef PLANE_CODEC_SSE2
+		auto low = LoadVector(a_block);
+		auto high = LoadVector(a_block + 16);
+		auto any = _mm_or_si128(low, high);
+		any = _mm_or_si128(any, _mm_srli_si128(any, 8));
+		any = _mm_or_si128(any, _mm_srli_si128(any, 4));
+		any = _mm_or_si128(any, _mm_srli_si128(any, 2));
+		any = _mm_or_si128(any, _mm_srli_si128(any, 1));
+		auto width = (uint32_t)std::bit_width((uint32_t)_mm_cvtsi128_si32(any) & 0xFFu);
+
+		// Shifting a 16 bit lane moves bit b of both its bytes into their top bit, which movemask gathers
+		for (uint32_t b = 0; b < width; b++) {
+			auto shift = _mm_cvtsi32_si128((int)(7 - b));
+			auto word = (uint32_t)_mm_movemask_epi8(_mm_sll_epi16(low, shift)) | ((uint32_t)_mm_movemask_epi8(_mm_sll_epi16(high, shift)) << 16);
+			std::memcpy(a_out, &word, sizeof(word));
+			a_out += sizeof(word);
+		}
+#else
+		uint32_t any = 0;
+		for (std::size_t j = 0; j < BlockSize; j++)
+			any |= a_block[j];
+		auto width = (uint32_t)std::bit_width(any);
+
+		for (uint32_t b = 0; b < width; b++) {
+			uint32_t word = 0;
+			for (std::size_t j = 0; j < BlockSize; j++)
+				word |= (uint32_t)((a_block[j] >> b) & 1u) << j;
+			std::memcpy(a_out, &word, sizeof(word));
+			a_out += sizeof(word);
+		}
+#endif
+		return width;
+	}
+
+	static void UnpackBlock(const uint8_t*& a_data, uint32_t a_width, uint8_t* a_block)
+	{
+#ifdef PLANE_CODEC_SSE2
+		// Byte i of a half tests bit i % 8 of the byte of the word that covers it
+		const auto select = _mm_set_epi8((char)0x80, 64, 32, 16, 8, 4, 2, 1, (char)0x80, 64, 32, 16, 8, 4, 2, 1);
+		auto spread = [&](uint32_t a_bits) {
+			auto bytes = _mm_cvtsi32_si128((int)a_bits);
+			bytes = _mm_unpacklo_epi8(bytes, bytes);
+			bytes = _mm_unpacklo_epi16(bytes, bytes);
+			bytes = _mm_unpacklo_epi32(bytes, bytes);
+			return _mm_cmpeq_epi8(_mm_and_si128(bytes, select), select);
+		};
+
+		auto low = _mm_setzero_si128();
+		auto high = _mm_setzero_si128();
+		for (uint32_t b = 0; b < a_width; b++) {
+			uint32_t word;
+			std::memcpy(&word, a_data, sizeof(word));
+			a_data += sizeof(word);
+
+			auto bit = _mm_set1_epi8((char)(1u << b));
+			low = _mm_or_si128(low, _mm_and_si128(spread(word & 0xFFFFu), bit));
+			high = _mm_or_si128(high, _mm_and_si128(spread(word >> 16), bit));
+		}
+		StoreVector(a_block, low);
+		StoreVector(a_block + 16, high);
+#else
+		std::memset(a_block, 0, BlockSize);
+		for (uint32_t b = 0; b < a_width; b++) {
+			uint32_t word;
+			std::memcpy(&word, a_data, sizeof(word));
+			a_data += sizeof(word);
+
+			for (std::size_t j = 0; j < BlockSize; j++)
+				a_block[j] |= (uint8_t)(((word >> j) & 1u) << b);
+		}
+#endif
+	}
+
+	struct Scratch
+	{
+		std::vector<uint8_t> residuals;
+		std::vector<uint8_t> planes;
+		std::vector<uint8_t> zeros;
+	};
+
+	struct Band
+	{
+		uint32_t firstRow;
+		uint32_t rows;
+		std::size_t rowBytes;
+		// Pixels in the band rounded up to whole blocks, the distance between byte planes
+		std::size_t stride;
+	};
+
+	static Band GetBand(const StreamHeader& a_header, uint32_t a_index)
+	{
+		Band band;
+		band.firstRow = a_index * a_header.bandRows;
+		band.rows = std::min(a_header.bandRows, a_header.height - band.firstRow);
+		band.rowBytes = (std::size_t)a_header.width * a_header.pixelSize;
+		auto pixels = (std::size_t)band.rows * a_header.width;
+		band.stride = (pixels + BlockSize - 1) / BlockSize * BlockSize;
+		return band;
+	}
+
+	template <class T>
+	static void EncodeRows(const StreamHeader& a_header, const Band& a_band, const uint8_t* a_pixels, Scratch& a_scratch)
+	{
+		auto lanes = a_band.rowBytes / sizeof(T);
+		auto channels = a_header.pixelSize / sizeof(T);
+		bool floatLanes = (a_header.flags & FloatLanes) != 0;
+		for (uint32_t y = 0; y < a_band.rows; y++) {
+			auto row = a_pixels + y * a_band.rowBytes;
+			auto up = y ? row - a_band.rowBytes : a_scratch.zeros.data();
+			EncodeRow<T>(row, up, a_scratch.residuals.data() + y * a_band.rowBytes, lanes, channels, floatLanes);
+		}
+	}
+
+	template <class T>
+	static void DecodeRows(const StreamHeader& a_header, const Band& a_band, uint8_t* a_pixels, Scratch& a_scratch)
+	{
+		auto lanes = a_band.rowBytes / sizeof(T);
+		auto channels = a_header.pixelSize / sizeof(T);
+		bool floatLanes = (a_header.flags & FloatLanes) != 0;
+		for (uint32_t y = 0; y < a_band.rows; y++) {
+			auto row = a_pixels + y * a_band.rowBytes;
+			auto up = y ? row - a_band.rowBytes : a_scratch.zeros.data();
+			DecodeRow<T>(a_scratch.residuals.data() + y * a_band.rowBytes, up, row, lanes, channels, floatLanes);
+		}
+	}
+
+	static void PrepareScratch(const Band& a_band, uint32_t a_pixelSize, Scratch& a_scratch)
+	{
+		a_scratch.residuals.resize(a_band.rows * a_band.rowBytes);
+		a_scratch.zeros.assign(a_band.rowBytes, 0);
+		// Blocks past the last pixel are packed too, they have to stay zero
+		a_scratch.planes.assign(a_band.stride * a_pixelSize, 0);
+	}
+
+	static void EncodeBand(const StreamHeader& a_header, const Band& a_band, const uint8_t* a_pixels, Scratch& a_scratch, std::vector<uint8_t>& a_out)
+	{
+		PrepareScratch(a_band, a_header.pixelSize, a_scratch);
+		switch (a_header.laneSize) {
+		case 4:
+			EncodeRows<uint32_t>(a_header, a_band, a_pixels, a_scratch);
+			break;
+		case 2:
+			EncodeRows<uint16_t>(a_header, a_band, a_pixels, a_scratch);
+			break;
+		default:
+			EncodeRows<uint8_t>(a_header, a_band, a_pixels, a_scratch);
+			break;
+		}
+		Shuffle(a_scratch.residuals.data(), a_scratch.planes.data(), (std::size_t)a_band.rows * a_header.width, a_band.stride, a_header.pixelSize);
+
+		// Worst case every block is 8 bits wide
+		auto blocks = a_band.stride / BlockSize;
+		auto widthBytes = (blocks + 1) / 2;
+		a_out.resize((widthBytes + a_band.stride) * a_header.pixelSize);
+
+		auto out = a_out.data();
+		for (uint32_t k = 0; k < a_header.pixelSize; k++) {
+			auto widths = out;
+			std::memset(widths, 0, widthBytes);
+			out += widthBytes;
+
+			auto plane = a_scratch.planes.data() + k * a_band.stride;
+			for (std::size_t block = 0; block < blocks; block++) {
+				auto width = PackBlock(plane + block * BlockSize, out);
+				widths[block / 2] |= (uint8_t)(width << (block % 2 * 4));
+			}
+		}
+		a_out.resize(out - a_out.data());
+	}
+
+	static bool DecodeBand(const StreamHeader& a_header, const Band& a_band, std::span<const uint8_t> a_data, uint8_t* a_pixels, Scratch& a_scratch)
+	{
+		PrepareScratch(a_band, a_header.pixelSize, a_scratch);
+
+		auto blocks = a_band.stride / BlockSize;
+		auto widthBytes = (blocks + 1) / 2;
+		auto data = a_data.data();
+		auto end = data + a_data.size();
+		for (uint32_t k = 0; k < a_header.pixelSize; k++) {
+			if ((std::size_t)(end - data) < widthBytes)
+				return false;
+			auto widths = data;
+			data += widthBytes;
+
+			auto plane = a_scratch.planes.data() + k * a_band.stride;
+			for (std::size_t block = 0; block < blocks; block++) {
+				auto width = (uint32_t)(widths[block / 2] >> (block % 2 * 4)) & 0xFu;
+				if (width > 8 || (std::size_t)(end - data) < width * sizeof(uint32_t))
+					return false;
+				UnpackBlock(data, width, plane + block * BlockSize);
+			}
+		}
+		if (data != end)
+			return false;
+
+		Unshuffle(a_scratch.planes.data(), a_scratch.residuals.data(), (std::size_t)a_band.rows * a_header.width, a_band.stride, a_header.pixelSize);
+		switch (a_header.laneSize) {
+		case 4:
+			DecodeRows<uint32_t>(a_header, a_band, a_pixels, a_scratch);
+			break;
+		case 2:
+			DecodeRows<uint16_t>(a_header, a_band, a_pixels, a_scratch);
+			break;
+		default:
+			DecodeRows<uint8_t>(a_header, a_band, a_pixels, a_scratch);
+			break;
+		}
+		return true;
+	}
+
+	// Calls a_func(scratch, band) for every band, spread over up to a_threads threads including the caller
+	template <class F>
+	static void ForEachBand(uint32_t a_count, uint32_t a_threads, F&& a_func)
+	{
+		if (!a_threads)
+			a_threads = std::max(1u, std::thread::hardware_concurrency());
+		a_threads = std::min(a_threads, a_count);
+
+		std::atomic<uint32_t> next = 0;
+		auto work = [&] {
+			Scratch scratch;
+			for (auto band = next++; band < a_count; band = next++)
+				a_func(scratch, band);
+		};
+
+		std::vector<std::jthread> workers;
+		for (uint32_t i = 1; i < a_threads; i++)
+			workers.emplace_back(work);
+		work();
+	}
+
+	bool Encode(std::span<const uint8_t> a_data, const Layout& a_layout, std::vector<uint8_t>& a_out, uint32_t a_threads)
+	{
+		if (!a_layout.width || !a_layout.height || !a_layout.pixelSize || a_layout.pixelSize > MaxPixelSize ||
+			a_data.size() != (uint64_t)a_layout.width * a_layout.height * a_layout.pixelSize)
+			return false;
+
+		auto lanes = GetLaneLayout(a_layout.format, a_layout.pixelSize);
+		StreamHeader header{};
+		header.width = a_layout.width;
+		header.height = a_layout.height;
+		header.pixelSize = a_layout.pixelSize;
+		header.laneSize = lanes.laneSize;
+		header.flags = lanes.floatLanes ? FloatLanes : 0;
+		header.bandRows = BandRows;
+		header.bandCount = (a_layout.height + BandRows - 1) / BandRows;
+
+		std::vector<std::vector<uint8_t>> bands(header.bandCount);
+		ForEachBand(header.bandCount, a_threads, [&](Scratch& a_scratch, uint32_t a_index) {
+			auto band = GetBand(header, a_index);
+			EncodeBand(header, band, a_data.data() + band.firstRow * band.rowBytes, a_scratch, bands[a_index]);
+		});
+
+		auto start = a_out.size();
+		auto total = sizeof(header) + bands.size() * sizeof(uint64_t);
+		for (auto& band : bands)
+			total += band.size();
+		a_out.resize(start + total);
+
+		auto out = a_out.data() + start;
+		std::memcpy(out, &header, sizeof(header));
+		out += sizeof(header);
+		for (auto& band : bands) {
+			uint64_t size = band.size();
+			std::memcpy(out, &size, sizeof(size));
+			out += sizeof(size);
+		}
+		for (auto& band : bands) {
+			std::memcpy(out, band.data(), band.size());
+			out += band.size();
+		}
+		return true;
+	}
+
+	bool Decode(std::span<const uint8_t> a_data, uint64_t a_rawSize, std::vector<uint8_t>& a_out, uint32_t a_threads)
+	{
+		StreamHeader header;
+		if (a_data.size() < sizeof(header))
+			return false;
+		std::memcpy(&header, a_data.data(), sizeof(header));
+
+		if (!header.width || !header.height || !header.pixelSize || header.pixelSize > MaxPixelSize ||
+			(header.laneSize != 1 && header.laneSize != 2 && header.laneSize != 4) || header.pixelSize % header.laneSize ||
+			header.bandRows != BandRows || header.bandCount != (header.height + BandRows - 1) / BandRows ||
+			a_rawSize != (uint64_t)header.width * header.height * header.pixelSize)
+			return false;
+
+		auto sizes = a_data.subspan(sizeof(header));
+		if (sizes.size() / sizeof(uint64_t) < header.bandCount)
+			return false;
+
+		std::vector<std::span<const uint8_t>> bands(header.bandCount);
+		auto remaining = sizes.subspan(header.bandCount * sizeof(uint64_t));
+		for (uint32_t i = 0; i < header.bandCount; i++) {
+			uint64_t size;
+			std::memcpy(&size, sizes.data() + i * sizeof(uint64_t), sizeof(size));
+			if (size > remaining.size())
+				return false;
+			bands[i] = remaining.first(size);
+			remaining = remaining.subspan(size);
+		}
+		if (!remaining.empty())
+			return false;
+
+		a_out.resize(a_rawSize);
+		std::atomic<bool> valid = true;
+		ForEachBand(header.bandCount, a_threads, [&](Scratch& a_scratch, uint32_t a_index) {
+			auto band = GetBand(header, a_index);
+			if (!DecodeBand(header, band, bands[a_index], a_out.data() + band.firstRow * band.rowBytes, a_scratch))
+				valid = false;
+		});
+		return valid;
+	}
+}
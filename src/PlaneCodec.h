@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Lossless codec for the planes frame captures store, tuned for depth and motion vectors, which change slowly across
+// the screen. Each channel is predicted from its left, upper and upper left neighbours, float channels are first
+// remapped so their bit patterns order like their values. The residuals are split into one plane per pixel byte and
+// every 32 bytes of a plane are bit packed at the width of their largest residual, so the near zero high bytes of
+// depth and motion vectors cost almost nothing. Bands of rows are coded independently and in parallel.
+// Portable, SSE2 where available, shared by the plugin and CaptureTool.
+namespace PlaneCodec
+{
+	struct Layout
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		// DXGI_FORMAT, picks the channel size and whether channels are floats
+		uint32_t format = 0;
+		uint32_t pixelSize = 0;
+	};
+
+	inline constexpr uint32_t BandRows = 64;
+
+	// Appends the encoded a_data to a_out, false without touching a_out when a_layout does not describe a_data.
+	// a_threads of zero uses every hardware thread.
+	bool Encode(std::span<const uint8_t> a_data, const Layout& a_layout, std::vector<uint8_t>& a_out, uint32_t a_threads = 0);
+	// Replaces a_out with exactly a_rawSize decoded bytes, false when a_data is corrupt
+	bool Decode(std::span<const uint8_t> a_data, uint64_t a_rawSize, std::vector<uint8_t>& a_out, uint32_t a_threads = 0);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// CPU reference of RCASClassifyCS.hlsl and of the RCAS filter it predicts, free of D3D so the skip threshold can be
+// checked in tests. Out of bounds taps repeat the edge texel, like both shaders do.
+namespace RCASClassifier
+{
+	inline constexpr uint32_t TileSize = 8;
+	// Largest negative lobe RCAS's limiter allows, at full sharpness
+	inline constexpr float MaxLobe = 0.1875f;
+	// A skipped tile must not be off by half an 8-bit step anywhere
+	inline constexpr float MaxSkippedChange = 0.5f / 255.0f;
+
+	// Per-channel range of a tile and its halo from which RCAS is run. RCAS moves a texel by
+	// lobe * (b + d + f + h - 4e) / (4 * lobe + 1) with -MaxLobe * sharpness <= lobe <= 0, and every tap is within
+	// range of e, so below this no texel of the tile moves by MaxSkippedChange.
+	inline float GetSkipThreshold(float a_sharpness)
+	{
+		auto lobe = MaxLobe * std::clamp(a_sharpness, 0.0f, 1.0f);
+		if (lobe <= 0.0f)
+			return std::numeric_limits<float>::max();
+		return MaxSkippedChange * (1.0f - 4.0f * lobe) / (4.0f * lobe);
+	}
+
+	struct Image
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		// Three floats per texel, rows top to bottom
+		std::vector<float> rgb;
+
+		const float* Load(int64_t a_x, int64_t a_y) const
+		{
+			auto x = (std::size_t)std::clamp<int64_t>(a_x, 0, (int64_t)width - 1);
+			auto y = (std::size_t)std::clamp<int64_t>(a_y, 0, (int64_t)height - 1);
+			return rgb.data() + (y * width + x) * 3;
+		}
+	};
+
+	// Largest per-channel range over the tile and the one texel halo RCAS reads around it
+	inline float GetTileRange(const Image& a_image, uint32_t a_tileX, uint32_t a_tileY)
+	{
+		std::array<float, 3> low, high;
+		low.fill(std::numeric_limits<float>::max());
+		high.fill(std::numeric_limits<float>::lowest());
+
+		auto originX = (int64_t)a_tileX * TileSize - 1;
+		auto originY = (int64_t)a_tileY * TileSize - 1;
+		for (int64_t y = originY; y < originY + TileSize + 2; y++) {
+			for (int64_t x = originX; x < originX + TileSize + 2; x++) {
+				auto texel = a_image.Load(x, y);
+				for (int c = 0; c < 3; c++) {
+					low[c] = std::min(low[c], texel[c]);
+					high[c] = std::max(high[c], texel[c]);
+				}
+			}
+		}
+		return std::max({ high[0] - low[0], high[1] - low[1], high[2] - low[2] });
+	}
+
+	// True when the classifier appends the tile for sharpening
+	inline bool IsSharpened(const Image& a_image, uint32_t a_tileX, uint32_t a_tileY, float a_threshold)
+	{
+		return GetTileRange(a_image, a_tileX, a_tileY) >= a_threshold;
+	}
+
+	inline float GetLuma(const float* a_rgb)
+	{
+		return a_rgb[0] * 0.5f + a_rgb[1] + a_rgb[2] * 0.5f;
+	}
+
+	// RCASFilter from RCAS.hlsl in full precision, with HLSL's saturate and min/max handling of NaN
+	inline std::array<float, 3> Filter(const float* b, const float* d, const float* e, const float* f, const float* h,
+		float bL, float dL, float eL, float fL, float hL, float a_sharpness)
+	{
+		auto nz = (bL + dL + fL + hL) * 0.25f - eL;
+		auto range = std::max({ bL, dL, eL, fL, hL }) - std::min({ bL, dL, eL, fL, hL });
+		auto ratio = std::abs(nz) / range;
+		nz = std::isnan(ratio) ? 0.0f : std::clamp(ratio, 0.0f, 1.0f);
+		nz = -0.5f * nz + 1.0f;
+
+		auto lobeMax = -std::numeric_limits<float>::infinity();
+		for (int c = 0; c < 3; c++) {
+			auto minC = std::min({ b[c], d[c], f[c], h[c] });
+			auto maxC = std::max({ b[c], d[c], f[c], h[c] });
+			auto hitMin = minC / (4.0f * maxC);
+			auto hitMax = (1.0f - maxC) / (4.0f * minC - 4.0f);
+			lobeMax = std::fmax(lobeMax, std::fmax(-hitMin, hitMax));
+		}
+		auto lobe = std::fmax(-MaxLobe, std::fmin(lobeMax, 0.0f)) * a_sharpness * nz;
+
+		auto rcpL = 1.0f / (4.0f * lobe + 1.0f);
+		std::array<float, 3> output;
+		for (int c = 0; c < 3; c++)
+			output[c] = ((b[c] + d[c] + f[c] + h[c]) * lobe + e[c]) * rcpL;
+		return output;
+	}
+
+	inline std::array<float, 3> Filter(const Image& a_image, uint32_t a_x, uint32_t a_y, float a_sharpness)
+	{
+		auto b = a_image.Load(a_x, (int64_t)a_y - 1);
+		auto d = a_image.Load((int64_t)a_x - 1, a_y);
+		auto e = a_image.Load(a_x, a_y);
+		auto f = a_image.Load((int64_t)a_x + 1, a_y);
+		auto h = a_image.Load(a_x, (int64_t)a_y + 1);
+		return Filter(b, d, e, f, h, GetLuma(b), GetLuma(d), GetLuma(e), GetLuma(f), GetLuma(h), a_sharpness);
+	}
+}
@@ -0,0 +1,31 @@
+#include "ReadbackRing.h"
+
+std::optional<uint> ReadbackRing::Claim(uint64_t a_frame, uint a_tag)
+{
+	auto& slot = slots[next];
+	if (slot.pending) {
+		statistics.dropped++;
+		return std::nullopt;
+	}
+
+	auto index = next;
+	slot = { a_frame, a_tag, true };
+	next = (next + 1) % slotCount;
+	return index;
+}
+
+void ReadbackRing::Complete(Slot& a_slot, uint64_t a_frame)
+{
+	a_slot.pending = false;
+	statistics.completed++;
+	statistics.latency = a_frame >= a_slot.frame ? a_frame - a_slot.frame : 0;
+	statistics.maxLatency = std::max(statistics.maxLatency, statistics.latency);
+}
+
+void ReadbackRing::Reset()
+{
+	for (auto& slot : slots)
+		slot = {};
+	next = 0;
+	statistics = {};
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <optional>
+
+// Slot bookkeeping for results the CPU reads a few frames after the GPU wrote them. A slot is claimed when its copy is
+// recorded and stays pending until the backend reports it finished and read. Nothing waits: a full ring drops the new
+// copy instead of reusing one the GPU may still write, and polling stops at the first unfinished slot since the GPU
+// completes work in submission order.
+// Only sees frame numbers and whether a slot is ready, so it can be driven by a simulated GPU.
+class ReadbackRing
+{
+public:
+	static constexpr uint MaxSlots = 8;
+
+	struct Slot
+	{
+		uint64_t frame = 0;
+		uint tag = 0;
+		bool pending = false;
+	};
+
+	struct Statistics
+	{
+		uint64_t completed = 0;
+		uint64_t dropped = 0;
+		// Frames between a copy and its read, the newest one and the most seen
+		uint64_t latency = 0;
+		uint64_t maxLatency = 0;
+	};
+
+	explicit ReadbackRing(uint a_slots) :
+		slotCount(std::clamp(a_slots, 1u, MaxSlots))
+	{}
+
+	// Slot to record a copy into for a_frame, none when every slot is still pending
+	std::optional<uint> Claim(uint64_t a_frame, uint a_tag);
+
+	// Calls a_read(index, slot) for pending slots, oldest first, until one returns false because it is unfinished
+	template <class F>
+	uint Poll(uint64_t a_frame, F&& a_read)
+	{
+		uint count = 0;
+		for (uint i = 0; i < slotCount; i++) {
+			auto index = (next + i) % slotCount;
+			auto& slot = slots[index];
+			if (!slot.pending)
+				continue;
+			if (!a_read(index, static_cast<const Slot&>(slot)))
+				break;
+			Complete(slot, a_frame);
+			count++;
+		}
+		return count;
+	}
+
+	void Reset();
+
+	// Claim would drop a copy
+	bool IsFull() const { return slots[next].pending; }
+	uint GetSlotCount() const { return slotCount; }
+	const Slot& GetSlot(uint a_index) const { return slots[a_index]; }
+	const Statistics& GetStatistics() const { return statistics; }
+
+private:
+	void Complete(Slot& a_slot, uint64_t a_frame);
+
+	uint slotCount;
+	// Claimed next, the oldest slot whenever the ring is full
+	uint next = 0;
+	Slot slots[MaxSlots];
+	Statistics statistics;
+};
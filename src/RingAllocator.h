@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Offset arithmetic behind ConstantBufferRing, free of D3D so it can be driven by tests. Space is handed out linearly
+// and wraps around, and each frame's space is freed once its fence is known to have been reached.
+class RingAllocator
+{
+public:
+	// Offset binding works in 16-byte constants and requires offsets/sizes to be multiples of 16 constants
+	static constexpr uint32_t Alignment = 256;
+	static constexpr uint32_t FrameLatency = 3;
+	static constexpr uint32_t Full = UINT32_MAX;
+
+	explicit RingAllocator(uint32_t a_capacity) :
+		capacity(a_capacity) {}
+
+	static constexpr uint32_t AlignUp(std::size_t a_size)
+	{
+		return (uint32_t)((a_size + (Alignment - 1)) & ~(std::size_t)(Alignment - 1));
+	}
+
+	// Returns the offset of a free range of a_size bytes, or Full
+	uint32_t Reserve(uint32_t a_size)
+	{
+		if (a_size > capacity)
+			return Full;
+
+		uint32_t offset = head;
+		uint32_t wasted = 0;
+		if (used > 0 && head <= tail) {
+			// Live data sits between head and tail
+			if (tail - head < a_size)
+				return Full;
+		} else if (capacity - head < a_size) {
+			// Wrap around, the end of the ring is skipped for this pass
+			if ((used == 0 ? head : tail) < a_size)
+				return Full;
+			wasted = capacity - head;
+			offset = 0;
+		}
+
+		head = (offset + a_size) % capacity;
+		used += a_size + wasted;
+		frameSize += a_size + wasted;
+		return offset;
+	}
+
+	// Retires frames oldest first while a_reached(fence) reports their fence as passed, then starts a new frame
+	template <class F>
+	void BeginFrame(F&& a_reached)
+	{
+		while (pendingFrames > 0) {
+			auto fence = (frameIndex + FrameLatency - pendingFrames) % FrameLatency;
+			if (!a_reached(fence))
+				break;
+			tail = frames[fence].end;
+			used -= frames[fence].size;
+			pendingFrames--;
+		}
+		frameSize = 0;
+	}
+
+	// Closes the frame and returns the fence to issue for it
+	uint32_t EndFrame()
+	{
+		if (pendingFrames == FrameLatency) {
+			// Every fence is in flight, fold the oldest frame into the next one which completes after it anyway
+			frames[(frameIndex + 1) % FrameLatency].size += frames[frameIndex].size;
+			pendingFrames--;
+		}
+
+		auto fence = frameIndex;
+		frames[fence].end = head;
+		frames[fence].size = frameSize;
+		frameIndex = (frameIndex + 1) % FrameLatency;
+		pendingFrames++;
+		return fence;
+	}
+
+	// The buffer was renamed, fences still in flight only guard the old one
+	void Reset()
+	{
+		head = tail = 0;
+		used = frameSize = 0;
+		pendingFrames = 0;
+	}
+
+	uint32_t GetCapacity() const { return capacity; }
+	// Includes the space skipped at the end of the ring when wrapping
+	uint32_t GetUsed() const { return used; }
+	uint32_t GetPendingFrames() const { return pendingFrames; }
+
+private:
+	struct Frame
+	{
+		uint32_t end = 0;
+		uint32_t size = 0;
+	};
+
+	uint32_t capacity;
+	Frame frames[FrameLatency];
+	uint32_t frameIndex = 0;
+	uint32_t pendingFrames = 0;
+
+	uint32_t head = 0;
+	uint32_t tail = 0;
+	uint32_t used = 0;
+	uint32_t frameSize = 0;
+};
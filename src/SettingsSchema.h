@@ -0,0 +1,291 @@
+#pragma once
+
+#include <charconv>
+#include <tuple>
+
+#include "INITokenizer.h"
+#include "UpscalingSettings.h"
+
+// Single description of every persisted setting. INI parsing/serialisation, the ENB UI and range clamping are all
+// generated from it, and none of them allocate.
+namespace SettingsSchema
+{
+	using Settings = UpscalingSettings;
+
+	inline constexpr std::string_view Section = "ANTIALIASING";
+
+	enum class Visibility
+	{
+		kAlways,
+		kWithDLSS,
+		kWithoutDLSS,
+		kHidden
+	};
+
+	struct FloatField
+	{
+		std::string_view key;
+		std::string_view label;
+		std::string_view comment;
+		float Settings::*member;
+		float min;
+		float max;
+		float step;
+		Visibility visibility = Visibility::kAlways;
+	};
+
+	struct BoolField
+	{
+		std::string_view key;
+		std::string_view label;
+		std::string_view comment;
+		bool Settings::*member;
+		Visibility visibility = Visibility::kAlways;
+	};
+
+	// Comma separated names, kept inline in the settings
+	struct ListField
+	{
+		std::string_view key;
+		std::string_view label;
+		std::string_view comment;
+		MenuList Settings::*member;
+		Visibility visibility = Visibility::kHidden;
+	};
+
+	// Stored as uint, values of E count up from zero and each has a name
+	template <class E, std::size_t N>
+	struct EnumField
+	{
+		using Enum = E;
+
+		std::string_view key;
+		std::string_view label;
+		std::string_view comment;
+		uint Settings::*member;
+		std::string_view typeName;
+		std::array<std::string_view, N> names;
+		// Options past this are hidden from the UI and rejected when parsing
+		std::size_t count = N;
+		Visibility visibility = Visibility::kAlways;
+	};
+
+	inline constexpr std::array<std::string_view, 3> MethodNames = { "TAA", "AMD FSR 3.1", "NVIDIA DLAA" };
+	inline constexpr std::array<std::string_view, 2> SharpenKernelNames = { "Direct", "Groupshared" };
+	inline constexpr std::array<std::string_view, 7> PresetNames = { "Default", "Preset A", "Preset B", "Preset C", "Preset D", "Preset E", "Preset F" };
+
+	inline constexpr auto Fields = std::make_tuple(
+		EnumField<UpscaleMethod, 3>{ "Method", "Method", "Used when DLAA is available", &Settings::upscaleMethod, "AA_METHOD", MethodNames, 3, Visibility::kWithDLSS },
+		EnumField<UpscaleMethod, 3>{ "MethodNoDLAA", "Method", "Used when DLAA is not available", &Settings::upscaleMethodNoDLSS, "AA_METHOD_NO_DLAA", MethodNames, 2, Visibility::kWithoutDLSS },
+		FloatField{ "Sharpness", "Sharpness", "RCAS sharpening, range of 0.0 to 1.0", &Settings::sharpness, 0.0f, 1.0f, 0.1f },
+		EnumField<SharpenKernel, 2>{ "SharpenKernel", "Sharpen Kernel", "RCAS kernel, Groupshared caches each tile in shared memory, output is identical", &Settings::sharpenKernel, "SHARPEN_KERNEL", SharpenKernelNames },
+		BoolField{ "HalfPrecision", "Half Precision", "Run sharpening and mask encoding with 16-bit math where the GPU supports it", &Settings::halfPrecision },
+		EnumField<DLSSPreset, 7>{ "DLAAPreset", "DLAA Preset", "DLAA preset which affects image clarity and ghosting", &Settings::dlssPreset, "DLSS_PRESET", PresetNames },
+		BoolField{ "MenuBypass", "Bypass In Menus", "Use the game's TAA while full-screen menus are open", &Settings::menuBypass },
+		BoolField{ "IdleReuse", "Reuse Idle Frames", "Skip upscaling and repeat the last frame while nothing on screen moves", &Settings::idleReuse },
+		BoolField{ "AutoMethod", "Auto Method", "Use the best looking method up to Method whose measured GPU cost fits AutoBudget", &Settings::autoMethod },
+		FloatField{ "AutoBudget", "Auto Budget (ms)", "GPU milliseconds anti-aliasing may take when AutoMethod is enabled, range of 0.5 to 10.0", &Settings::autoBudget, 0.5f, 10.0f, 0.25f },
+		BoolField{ "FrameGeneration", "Frame Generation", "Present an FSR 3 interpolated frame between real frames, only with AMD FSR 3.1 and never in menus", &Settings::frameGeneration },
+		BoolField{ "FrameGenerationRenderStart", "Frame Generation At Render Start", "Let the real frame wait for the game to start rendering the next one, presents in the middle of the game's frame", &Settings::frameGenerationRenderStart, Visibility::kHidden },
+		ListField{ "BypassMenus", "Bypass Menus", "Comma separated menus that use the game's TAA while open when MenuBypass is enabled, only list menus that cover the whole screen", &Settings::bypassMenus });
+
+	template <class F>
+	constexpr void ForEachField(F&& a_func)
+	{
+		std::apply([&](const auto&... a_fields) { (a_func(a_fields), ...); }, Fields);
+	}
+
+	inline bool IsVisible(Visibility a_visibility, bool a_dlss)
+	{
+		switch (a_visibility) {
+		case Visibility::kAlways:
+			return true;
+		case Visibility::kWithDLSS:
+			return a_dlss;
+		case Visibility::kWithoutDLSS:
+			return !a_dlss;
+		default:
+			return false;
+		}
+	}
+
+	inline bool Parse(const FloatField& a_field, std::string_view a_text, Settings& a_settings)
+	{
+		float value;
+		auto [ptr, ec] = std::from_chars(a_text.data(), a_text.data() + a_text.size(), value);
+		if (ec != std::errc() || !std::isfinite(value))
+			return false;
+		a_settings.*a_field.member = std::clamp(value, a_field.min, a_field.max);
+		return true;
+	}
+
+	inline bool Parse(const BoolField& a_field, std::string_view a_text, Settings& a_settings)
+	{
+		if (a_text == "1" || a_text == "true")
+			a_settings.*a_field.member = true;
+		else if (a_text == "0" || a_text == "false")
+			a_settings.*a_field.member = false;
+		else
+			return false;
+		return true;
+	}
+
+	// Lists longer than the settings can hold are rejected rather than cut off mid name
+	inline bool Parse(const ListField& a_field, std::string_view a_text, Settings& a_settings)
+	{
+		return (a_settings.*a_field.member).Assign(a_text);
+	}
+
+	template <class E, std::size_t N>
+	bool Parse(const EnumField<E, N>& a_field, std::string_view a_text, Settings& a_settings)
+	{
+		uint value;
+		auto [ptr, ec] = std::from_chars(a_text.data(), a_text.data() + a_text.size(), value);
+		if (ec != std::errc() || value >= a_field.count)
+			return false;
+		a_settings.*a_field.member = value;
+		return true;
+	}
+
+	inline void Clamp(const FloatField& a_field, Settings& a_settings)
+	{
+		auto& value = a_settings.*a_field.member;
+		value = std::isfinite(value) ? std::clamp(value, a_field.min, a_field.max) : Settings{}.*a_field.member;
+	}
+
+	inline void Clamp(const BoolField&, Settings&) {}
+
+	inline void Clamp(const ListField&, Settings&) {}
+
+	template <class E, std::size_t N>
+	void Clamp(const EnumField<E, N>& a_field, Settings& a_settings)
+	{
+		auto& value = a_settings.*a_field.member;
+		if (value >= a_field.count)
+			value = Settings{}.*a_field.member;
+	}
+
+	inline void Validate(Settings& a_settings)
+	{
+		ForEachField([&](const auto& a_field) { Clamp(a_field, a_settings); });
+	}
+
+	// Appends to a fixed buffer, silently truncating once full
+	struct Writer
+	{
+		char* data;
+		std::size_t capacity;
+		std::size_t size = 0;
+
+		void Append(std::string_view a_text)
+		{
+			auto count = std::min(a_text.size(), capacity - size);
+			std::memcpy(data + size, a_text.data(), count);
+			size += count;
+		}
+
+		template <class T>
+			requires std::is_arithmetic_v<T>
+		void Append(T a_value)
+		{
+			auto [ptr, ec] = std::to_chars(data + size, data + capacity, a_value);
+			if (ec == std::errc())
+				size = ptr - data;
+		}
+	};
+
+	inline void Serialize(const FloatField& a_field, const Settings& a_settings, Writer& a_writer)
+	{
+		a_writer.Append("# ");
+		a_writer.Append(a_field.comment);
+		a_writer.Append("\n# Default: ");
+		a_writer.Append(Settings{}.*a_field.member);
+		a_writer.Append("\n");
+		a_writer.Append(a_field.key);
+		a_writer.Append(" = ");
+		a_writer.Append(a_settings.*a_field.member);
+		a_writer.Append("\n\n");
+	}
+
+	inline void Serialize(const BoolField& a_field, const Settings& a_settings, Writer& a_writer)
+	{
+		a_writer.Append("# ");
+		a_writer.Append(a_field.comment);
+		a_writer.Append("\n# Default: ");
+		a_writer.Append(Settings{}.*a_field.member ? "1" : "0");
+		a_writer.Append("\n");
+		a_writer.Append(a_field.key);
+		a_writer.Append(" = ");
+		a_writer.Append(a_settings.*a_field.member ? "1" : "0");
+		a_writer.Append("\n\n");
+	}
+
+	inline void Serialize(const ListField& a_field, const Settings& a_settings, Writer& a_writer)
+	{
+		a_writer.Append("# ");
+		a_writer.Append(a_field.comment);
+		a_writer.Append("\n# Default: ");
+		a_writer.Append((Settings{}.*a_field.member).View());
+		a_writer.Append("\n");
+		a_writer.Append(a_field.key);
+		a_writer.Append(" = ");
+		a_writer.Append((a_settings.*a_field.member).View());
+		a_writer.Append("\n\n");
+	}
+
+	template <class E, std::size_t N>
+	void Serialize(const EnumField<E, N>& a_field, const Settings& a_settings, Writer& a_writer)
+	{
+		auto defaultValue = Settings{}.*a_field.member;
+		a_writer.Append("# ");
+		a_writer.Append(a_field.comment);
+		a_writer.Append("\n# Default: ");
+		a_writer.Append(defaultValue);
+		if (defaultValue < N) {
+			a_writer.Append(" (");
+			a_writer.Append(a_field.names[defaultValue]);
+			a_writer.Append(")");
+		}
+		a_writer.Append("\n");
+		a_writer.Append(a_field.key);
+		a_writer.Append(" = ");
+		a_writer.Append(a_settings.*a_field.member);
+		a_writer.Append("\n\n");
+	}
+
+	// Calls a_func with each trimmed, non-empty item of a comma separated list
+	template <class F>
+	void ForEachListItem(std::string_view a_list, F&& a_func)
+	{
+		while (!a_list.empty()) {
+			auto comma = a_list.find(',');
+			auto item = Util::Trim(a_list.substr(0, comma));
+			a_list = comma == std::string_view::npos ? std::string_view{} : a_list.substr(comma + 1);
+			if (!item.empty())
+				a_func(item);
+		}
+	}
+
+	// Keys missing from the text or holding invalid values keep whatever a_settings already had
+	inline void ParseINI(std::string_view a_text, Settings& a_settings)
+	{
+		Util::ForEachINIValue(a_text, [&](std::string_view a_section, std::string_view a_key, std::string_view a_value) {
+			if (a_section != Section)
+				return;
+			ForEachField([&](const auto& a_field) {
+				if (a_field.key == a_key)
+					Parse(a_field, a_value, a_settings);
+			});
+		});
+	}
+
+	inline std::size_t SerializeINI(const Settings& a_settings, char* a_buffer, std::size_t a_capacity)
+	{
+		Writer writer{ a_buffer, a_capacity };
+		writer.Append("[");
+		writer.Append(Section);
+		writer.Append("]\n\n");
+		ForEachField([&](const auto& a_field) { Serialize(a_field, a_settings, writer); });
+		return writer.size;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+
+// Triple-buffered value handed from writer threads to the render thread.
+// Publish must be serialised by the caller, Acquire must only be called from a single reader.
+template <class T>
+class Snapshot
+{
+public:
+	Snapshot()
+	{
+		for (auto& buffer : buffers)
+			buffer.version = 0;
+	}
+
+	void Publish(const T& a_value)
+	{
+		auto& buffer = buffers[back];
+		buffer.value = a_value;
+		buffer.version = ++latestVersion;
+		back = state.exchange(back | kDirty, std::memory_order_acq_rel) & kIndexMask;
+	}
+
+	// Swaps in the most recently published value, if any, and returns it
+	const T& Acquire()
+	{
+		if (state.load(std::memory_order_acquire) & kDirty)
+			front = state.exchange(front, std::memory_order_acq_rel) & kIndexMask;
+		return buffers[front].value;
+	}
+
+	// Version of the value last returned by Acquire, 0 before anything was published
+	uint64_t Version() const { return buffers[front].version; }
+
+private:
+	static constexpr uint32_t kIndexMask = 0x3;
+	static constexpr uint32_t kDirty = 0x4;
+
+	struct Versioned
+	{
+		T value{};
+		uint64_t version;
+	};
+
+	Versioned buffers[3];
+	std::atomic<uint32_t> state = 1;
+	uint32_t front = 0;
+	uint32_t back = 2;
+	uint64_t latestVersion = 0;
+};
@@ -0,0 +1,63 @@
+#include "StaticDetector.h"
+
+StaticDetector::State StaticDetector::Update(uint64_t a_frame, bool a_cameraStatic, const Statistics* a_statistics)
+{
+	justBecameStatic = false;
+
+	if (!a_cameraStatic) {
+		Reset();
+		return state;
+	}
+
+	switch (state) {
+	case State::kMoving:
+		state = State::kConverging;
+		stillFrames = 0;
+		convergeStart = a_frame;
+		motionConfirmed = false;
+		[[fallthrough]];
+	case State::kConverging:
+		if (a_statistics && a_statistics->hasMotion && a_statistics->frame >= convergeStart) {
+			if (a_statistics->motion > thresholds.motion) {
+				// Something in the scene is still moving, start counting again from here
+				stillFrames = 0;
+				convergeStart = a_frame;
+				motionConfirmed = false;
+				break;
+			}
+			motionConfirmed = true;
+		}
+
+		if (++stillFrames >= thresholds.convergeFrames && motionConfirmed) {
+			state = State::kStatic;
+			staticStart = a_frame;
+			justBecameStatic = true;
+		}
+		break;
+	case State::kStatic:
+		if (a_statistics && a_statistics->hasColor && a_statistics->frame > staticStart && a_statistics->color > thresholds.color)
+			Reset();
+		break;
+	}
+
+	return state;
+}
+
+void StaticDetector::Reset()
+{
+	state = State::kMoving;
+	stillFrames = 0;
+	motionConfirmed = false;
+	justBecameStatic = false;
+}
+
+bool StaticDetector::IsCameraStatic(const float4x4& a_current, const float4x4& a_previous, float a_epsilon)
+{
+	auto current = &a_current._11;
+	auto previous = &a_previous._11;
+	for (int i = 0; i < 16; i++) {
+		if (std::abs(current[i] - previous[i]) > a_epsilon)
+			return false;
+	}
+	return true;
+}
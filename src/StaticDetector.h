@@ -0,0 +1,56 @@
+#pragma once
+
+// Decides when the camera and scene have been still long enough to reuse the last upscaled frame.
+// GPU statistics arrive a few frames late, so each one carries the frame it was measured on.
+class StaticDetector
+{
+public:
+	enum class State
+	{
+		kMoving,
+		kConverging,
+		kStatic
+	};
+
+	struct Thresholds
+	{
+		// Largest per-element difference between the current and previous camera matrices
+		float camera = 1e-5f;
+		// Largest motion vector, in pixels
+		float motion = 0.1f;
+		// Largest per-channel change of the input colour against the frame captured on entering kStatic
+		float color = 2.0f / 255.0f;
+		// Still frames needed before reuse, at least one full jitter cycle so the history is converged
+		uint convergeFrames = 8;
+	};
+
+	struct Statistics
+	{
+		uint64_t frame = 0;
+		float motion = 0.0f;
+		float color = 0.0f;
+		bool hasMotion = false;
+		bool hasColor = false;
+	};
+
+	Thresholds thresholds;
+
+	State Update(uint64_t a_frame, bool a_cameraStatic, const Statistics* a_statistics);
+	void Reset();
+
+	State GetState() const { return state; }
+	bool IsStatic() const { return state == State::kStatic; }
+
+	// True on the frame Update moved into kStatic, the caller captures its reference colour then
+	bool JustBecameStatic() const { return justBecameStatic; }
+
+	static bool IsCameraStatic(const float4x4& a_current, const float4x4& a_previous, float a_epsilon);
+
+private:
+	State state = State::kMoving;
+	uint stillFrames = 0;
+	uint64_t convergeStart = 0;
+	uint64_t staticStart = 0;
+	bool motionConfirmed = false;
+	bool justBecameStatic = false;
+};
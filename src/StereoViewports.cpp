@@ -0,0 +1,18 @@
+#include "StereoViewports.h"
+
+void StereoViewports::Configure(uint a_eyeCount, uint a_width, uint a_height)
+{
+	eyeCount = std::clamp(a_eyeCount, 1u, MaxEyes);
+	width = a_width;
+	height = a_height;
+
+	// An odd width gives the extra column to the right eye so the eyes cover the target exactly
+	uint left = 0;
+	for (uint eye = 0; eye < eyeCount; eye++) {
+		uint right = a_width * (eye + 1) / eyeCount;
+		rects[eye] = { left, 0, right - left, a_height };
+		left = right;
+	}
+	for (uint eye = eyeCount; eye < MaxEyes; eye++)
+		rects[eye] = {};
+}
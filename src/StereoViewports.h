@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+
+// Splits the render target into one viewport per eye. Skyrim VR renders both eyes side by side into the same targets,
+// the flat game has a single eye covering all of it. Backends evaluate every eye back to back on the same textures and
+// key their per-eye state by GetViewportId.
+class StereoViewports
+{
+public:
+	static constexpr uint MaxEyes = 2;
+
+	struct Rect
+	{
+		uint left = 0;
+		uint top = 0;
+		uint width = 0;
+		uint height = 0;
+	};
+
+	// a_width and a_height are the size of the whole target holding every eye
+	void Configure(uint a_eyeCount, uint a_width, uint a_height);
+
+	uint GetEyeCount() const { return eyeCount; }
+	bool IsStereo() const { return eyeCount > 1; }
+	const Rect& GetRect(uint a_eye) const { return rects[a_eye]; }
+	float GetAspectRatio(uint a_eye) const { return (float)rects[a_eye].width / (float)rects[a_eye].height; }
+	// Size of the whole target holding every eye
+	uint GetWidth() const { return width; }
+	uint GetHeight() const { return height; }
+
+	// Streamline viewport, or other per-eye backend slot, of a_eye. Flat keeps the id it always used.
+	static uint GetViewportId(uint a_eye) { return a_eye; }
+
+	// Projection offset for a jitter in pixels. Every eye has its own projection, so it is relative to one eye's size.
+	std::pair<float, float> GetProjectionOffset(float a_jitterX, float a_jitterY) const
+	{
+		return { -2.0f * a_jitterX / (float)rects[0].width, 2.0f * a_jitterY / (float)rects[0].height };
+	}
+	// Motion vectors are in UV of the whole target, each eye's extent only covers part of it
+	float GetMotionVectorScale(uint a_eye) const { return (float)width / (float)rects[a_eye].width; }
+	// Vertical FOV of an eye's projection, which comes from the headset rather than the game's FOV setting
+	static float GetVerticalFOV(const float4x4& a_viewToClip) { return 2.0f * std::atan(1.0f / a_viewToClip._22); }
+
+private:
+	uint eyeCount = 1;
+	uint width = 0;
+	uint height = 0;
+	std::array<Rect, MaxEyes> rects;
+};
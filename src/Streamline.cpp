@@ -2,8 +2,34 @@
 
 #include <magic_enum.hpp>
 
+#include "CapabilityCache.h"
+#include "LogLimiter.h"
+#include "MemoryTracker.h"
 #include "Util.h"
 
+void Streamline::StartInterposer()
+{
+	startup = std::async(std::launch::async, [this] {
+		LoadInterposer();
+		if (interposer)
+			Initialize();
+	});
+}
+
+bool Streamline::IsCapabilityError(sl::Result a_result)
+{
+	switch (a_result) {
+	case sl::Result::eErrorNoSupportedAdapterFound:
+	case sl::Result::eErrorAdapterNotSupported:
+	case sl::Result::eErrorDriverOutOfDate:
+	case sl::Result::eErrorOSOutOfDate:
+	case sl::Result::eErrorFeatureNotSupported:
+		return true;
+	default:
+		return false;
+	}
+}
+
 void Streamline::LoadInterposer()
 {
 	interposer = LoadLibraryW(L"Data/SKSE/Plugins/ENBAntiAliasing/Streamline/sl.interposer.dll");
@@ -15,18 +41,44 @@ void Streamline::LoadInterposer()
 	}
 }
 
+void Streamline::LogMessageCallback(sl::LogType a_type, const char* a_message)
+{
+	// Streamline repeats itself every frame when something is wrong, so each severity is limited on its own
+	static LogLimiter warnLimiter;
+	static LogLimiter errorLimiter;
+
+	std::string_view message{ a_message };
+	while (!message.empty() && (message.back() == '\n' || message.back() == '\r'))
+		message.remove_suffix(1);
+
+	switch (a_type) {
+	case sl::LogType::eInfo:
+		logger::debug("[Streamline] {}", message);
+		break;
+	case sl::LogType::eWarn:
+		if (auto repeats = warnLimiter.Check())
+			logger::warn("[Streamline] {}{}", message, *repeats);
+		break;
+	default:
+		if (auto repeats = errorLimiter.Check())
+			logger::error("[Streamline] {}{}", message, *repeats);
+		break;
+	}
+}
+
 void Streamline::Initialize()
 {
 	logger::info("[Streamline] Initializing Streamline");
 
 	sl::Preferences pref;
 
+	// DLSS Frame Generation is only implemented for D3D12 and Vulkan, on this D3D11 device frame generation goes through FSR 3
 	sl::Feature featuresToLoad[] = { sl::kFeatureDLSS };
 	pref.featuresToLoad = featuresToLoad;
 	pref.numFeaturesToLoad = _countof(featuresToLoad);
 
-	pref.logLevel = sl::LogLevel::eOff;
-	pref.logMessageCallback = nullptr;
+	pref.logLevel = sl::LogLevel::eDefault;
+	pref.logMessageCallback = LogMessageCallback;
 	pref.showConsole = false;
 
 	pref.engine = sl::EngineType::eCustom;
@@ -78,6 +130,12 @@ HRESULT Streamline::CreateDeviceAndSwapChain(IDXGIAdapter* pAdapter,
 	D3D_FEATURE_LEVEL* pFeatureLevel,
 	ID3D11DeviceContext** ppImmediateContext)
 {
+	if (startup.valid())
+		startup.get();
+
+	if (!interposer)
+		return ptrD3D11CreateDeviceAndSwapChain(pAdapter, DriverType, Software, Flags, pFeatureLevels, FeatureLevels, SDKVersion, pSwapChainDesc, ppSwapChain, ppDevice, pFeatureLevel, ppImmediateContext);
+
 	if (!initialized)
 		Initialize();
 
@@ -88,21 +146,30 @@ HRESULT Streamline::CreateDeviceAndSwapChain(IDXGIAdapter* pAdapter,
 	adapterInfo.deviceLUID = (uint8_t*)&adapterDesc.AdapterLuid;
 	adapterInfo.deviceLUIDSizeInBytes = sizeof(LUID);
 
+	// Only definite answers are cached, a missing or broken install is probed again next launch
+	bool definite = false;
+
 	slIsFeatureLoaded(sl::kFeatureDLSS, featureDLSS);
 	if (featureDLSS) {
 		logger::info("[Streamline] DLSS feature is loaded");
-		featureDLSS = slIsFeatureSupported(sl::kFeatureDLSS, adapterInfo) == sl::Result::eOk;
+		sl::Result result = slIsFeatureSupported(sl::kFeatureDLSS, adapterInfo);
+		featureDLSS = result == sl::Result::eOk;
+		definite = featureDLSS || IsCapabilityError(result);
 	} else {
 		logger::info("[Streamline] DLSS feature is not loaded");
 		sl::FeatureRequirements featureRequirements;
 		sl::Result result = slGetFeatureRequirements(sl::kFeatureDLSS, featureRequirements);
 		if (result != sl::Result::eOk) {
 			logger::info("[Streamline] DLSS feature failed to load due to: {}", magic_enum::enum_name(result));
+			definite = IsCapabilityError(result);
 		}
 	}
 
 	logger::info("[Streamline] DLSS {} available", featureDLSS ? "is" : "is not");
 
+	if (definite && initialized)
+		CapabilityCache::GetSingleton()->SetDLSS(Util::GetAdapterKey(pAdapter, true), featureDLSS);
+
 	HRESULT hr = ptrD3D11CreateDeviceAndSwapChain(
 			pAdapter,
 			DriverType,
@@ -128,29 +195,38 @@ HRESULT Streamline::CreateDeviceAndSwapChain(IDXGIAdapter* pAdapter,
 	return hr;
 }
 
-void Streamline::Upscale(Texture2D* a_upscaleTexture, Texture2D* a_alphaMask, float2 a_jitter, bool a_reset, sl::DLSSPreset a_preset)
+bool Streamline::Upscale(Texture2D* a_upscaleTexture, Texture2D* a_alphaMask, const StereoViewports& a_viewports, float2 a_jitter, bool a_reset, sl::DLSSPreset a_preset)
 {
-	UpdateConstants(a_jitter, a_reset);
+	if (!AcquireFrameToken())
+		return false;
 
 	static auto renderer = RE::BSGraphics::Renderer::GetSingleton();
 	static auto& depthTexture = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPOST_ZPREPASS_COPY];
 	static auto& motionVectorsTexture = renderer->GetRuntimeData().renderTargets[RE::RENDER_TARGET::kMOTION_VECTOR];
 
-	static auto gameViewport = RE::BSGraphics::State::GetSingleton();
 	static auto context = reinterpret_cast<ID3D11DeviceContext*>(renderer->GetRuntimeData().context);
 
-	static auto previousDlssPreset = a_preset;
+	// Resources stay the same for every eye, only the extents and viewport differ
+	sl::Resource colorIn = { sl::ResourceType::eTex2d, a_upscaleTexture->resource.get(), 0 };
+	sl::Resource colorOut = { sl::ResourceType::eTex2d, a_upscaleTexture->resource.get(), 0 };
+	sl::Resource depth = { sl::ResourceType::eTex2d, depthTexture.texture, 0 };
+	sl::Resource mvec = { sl::ResourceType::eTex2d, motionVectorsTexture.texture, 0 };
 
-	if (previousDlssPreset != a_preset)
-		DestroyDLSSResources();
+	bool needsMask = a_preset != sl::DLSSPreset::ePresetA && a_preset != sl::DLSSPreset::ePresetB;
+	sl::Resource alpha = { sl::ResourceType::eTex2d, needsMask ? a_alphaMask->resource.get() : nullptr, 0 };
 
-	previousDlssPreset = a_preset;
+	eyeCount = a_viewports.GetEyeCount();
+	for (uint eye = 0; eye < eyeCount; eye++) {
+		sl::ViewportHandle viewport(StereoViewports::GetViewportId(eye));
+		auto& rect = a_viewports.GetRect(eye);
+
+		if (!UpdateConstants(a_viewports, eye, a_jitter, a_reset))
+			return false;
 
-	{
 		sl::DLSSOptions dlssOptions{};
 		dlssOptions.mode = sl::DLSSMode::eMaxQuality;
-		dlssOptions.outputWidth = gameViewport->screenWidth;
-		dlssOptions.outputHeight = gameViewport->screenHeight;
+		dlssOptions.outputWidth = rect.width;
+		dlssOptions.outputHeight = rect.height;
 		dlssOptions.colorBuffersHDR = sl::Boolean::eFalse;
 		dlssOptions.preExposure = 1.0f;
 		dlssOptions.sharpness = 0.0f;
@@ -161,48 +237,60 @@ void Streamline::Upscale(Texture2D* a_upscaleTexture, Texture2D* a_alphaMask, fl
 		dlssOptions.ultraPerformancePreset = a_preset;
 
 		if (SL_FAILED(result, slDLSSSetOptions(viewport, dlssOptions))) {
-			logger::critical("[Streamline] Could not enable DLSS");
+			static LogLimiter limiter;
+			if (auto repeats = limiter.Check())
+				logger::critical("[Streamline] Could not enable DLSS{}", *repeats);
+			return false;
 		}
-	}
 
-	{
-		sl::Extent fullExtent{ 0, 0, gameViewport->screenWidth, gameViewport->screenHeight };
+		sl::Extent extent{ rect.top, rect.left, rect.width, rect.height };
 
-		sl::Resource colorIn = { sl::ResourceType::eTex2d, a_upscaleTexture->resource.get(), 0 };
-		sl::Resource colorOut = { sl::ResourceType::eTex2d, a_upscaleTexture->resource.get(), 0 };
-		sl::Resource depth = { sl::ResourceType::eTex2d, depthTexture.texture, 0 };
-		sl::Resource mvec = { sl::ResourceType::eTex2d, motionVectorsTexture.texture, 0 };
+		sl::ResourceTag colorInTag = sl::ResourceTag{ &colorIn, sl::kBufferTypeScalingInputColor, sl::ResourceLifecycle::eOnlyValidNow, &extent };
+		sl::ResourceTag colorOutTag = sl::ResourceTag{ &colorOut, sl::kBufferTypeScalingOutputColor, sl::ResourceLifecycle::eOnlyValidNow, &extent };
+		sl::ResourceTag depthTag = sl::ResourceTag{ &depth, sl::kBufferTypeDepth, sl::ResourceLifecycle::eValidUntilPresent, &extent };
+		sl::ResourceTag mvecTag = sl::ResourceTag{ &mvec, sl::kBufferTypeMotionVectors, sl::ResourceLifecycle::eValidUntilPresent, &extent };
+		sl::ResourceTag alphaTag = sl::ResourceTag{ &alpha, sl::kBufferTypeBiasCurrentColorHint, sl::ResourceLifecycle::eValidUntilPresent, &extent };
 
-		sl::ResourceTag colorInTag = sl::ResourceTag{ &colorIn, sl::kBufferTypeScalingInputColor, sl::ResourceLifecycle::eOnlyValidNow, &fullExtent };
-		sl::ResourceTag colorOutTag = sl::ResourceTag{ &colorOut, sl::kBufferTypeScalingOutputColor, sl::ResourceLifecycle::eOnlyValidNow, &fullExtent };
-		sl::ResourceTag depthTag = sl::ResourceTag{ &depth, sl::kBufferTypeDepth, sl::ResourceLifecycle::eValidUntilPresent, &fullExtent };
-		sl::ResourceTag mvecTag = sl::ResourceTag{ &mvec, sl::kBufferTypeMotionVectors, sl::ResourceLifecycle::eValidUntilPresent, &fullExtent };
+		sl::ResourceTag resourceTags[] = { colorInTag, colorOutTag, depthTag, mvecTag, alphaTag };
+		if (SL_FAILED(result, slSetTag(viewport, resourceTags, _countof(resourceTags), context))) {
+			static LogLimiter limiter;
+			if (auto repeats = limiter.Check())
+				logger::error("[Streamline] Could not tag resources{}", *repeats);
+			return false;
+		}
 
-		bool needsMask = a_preset != sl::DLSSPreset::ePresetA && a_preset != sl::DLSSPreset::ePresetB;
+		const sl::BaseStructure* inputs[] = { &viewport };
+		if (SL_FAILED(result, slEvaluateFeature(sl::kFeatureDLSS, *frameToken, inputs, _countof(inputs), context))) {
+			static LogLimiter limiter;
+			if (auto repeats = limiter.Check())
+				logger::error("[Streamline] Could not evaluate DLSS{}", *repeats);
+			return false;
+		}
+	}
 
-		sl::Resource alpha = { sl::ResourceType::eTex2d, needsMask ? a_alphaMask->resource.get() : nullptr, 0 };
-		sl::ResourceTag alphaTag = sl::ResourceTag{ &alpha, sl::kBufferTypeBiasCurrentColorHint, sl::ResourceLifecycle::eValidUntilPresent, &fullExtent };
+	return true;
+}
 
-		sl::ResourceTag resourceTags[] = { colorInTag, colorOutTag, depthTag, mvecTag, alphaTag };
-		slSetTag(viewport, resourceTags, _countof(resourceTags), context);
+bool Streamline::AcquireFrameToken()
+{
+	if (SL_FAILED(res, slGetNewFrameToken(frameToken, nullptr))) {
+		static LogLimiter limiter;
+		if (auto repeats = limiter.Check())
+			logger::error("[Streamline] Could not get frame token{}", *repeats);
+		return false;
 	}
-
-	sl::ViewportHandle view(viewport);
-	const sl::BaseStructure* inputs[] = { &view };
-	slEvaluateFeature(sl::kFeatureDLSS, *frameToken, inputs, _countof(inputs), context);
+	return true;
 }
 
-void Streamline::UpdateConstants(float2 a_jitter, bool a_reset)
+bool Streamline::UpdateConstants(const StereoViewports& a_viewports, uint a_eye, float2 a_jitter, bool a_reset)
 {
-	auto cameraData = Util::GetCameraData(0);
-	auto eyePosition = Util::GetEyePosition(0);
+	auto cameraData = Util::GetCameraData(a_eye);
+	auto eyePosition = Util::GetEyePosition(a_eye);
 
 	auto clipToCameraView = cameraData.viewMat.Invert();
 	auto cameraToWorld = cameraData.viewProjMatrixUnjittered.Invert();
 	auto cameraToWorldPrev = cameraData.previousViewProjMatrixUnjittered.Invert();
 
-	auto gameViewport = RE::BSGraphics::State::GetSingleton();
-
 	float4x4 cameraToPrevCamera;
 
 	calcCameraToPrevCamera(*(sl::float4x4*)&cameraToPrevCamera, *(sl::float4x4*)&cameraToWorld, *(sl::float4x4*)&cameraToWorldPrev);
@@ -212,8 +300,8 @@ void Streamline::UpdateConstants(float2 a_jitter, bool a_reset)
 	prevCameraToCamera.Invert();
 
 	sl::Constants slConstants = {};
-	slConstants.cameraAspectRatio = (float)gameViewport->screenWidth / (float)gameViewport->screenHeight;
-	slConstants.cameraFOV = Util::GetVerticalFOVRad();
+	slConstants.cameraAspectRatio = a_viewports.GetAspectRatio(a_eye);
+	slConstants.cameraFOV = a_viewports.IsStereo() ? StereoViewports::GetVerticalFOV(cameraData.viewMat) : Util::GetVerticalFOVRad();
 	slConstants.cameraFar = (*(float*)(REL::RelocationID(517032, 403540).address() + 0x44));
 	slConstants.cameraMotionIncluded = sl::Boolean::eTrue;
 	slConstants.cameraNear = (*(float*)(REL::RelocationID(517032, 403540).address() + 0x40));
@@ -227,7 +315,7 @@ void Streamline::UpdateConstants(float2 a_jitter, bool a_reset)
 	slConstants.clipToPrevClip = *(sl::float4x4*)&cameraToPrevCamera;
 	slConstants.depthInverted = sl::Boolean::eFalse;
 	slConstants.jitterOffset = { -a_jitter.x, -a_jitter.y};
-	slConstants.mvecScale = { 1, 1 };
+	slConstants.mvecScale = { a_viewports.GetMotionVectorScale(a_eye), 1 };
 	slConstants.prevClipToClip = *(sl::float4x4*)&prevCameraToCamera;
 	slConstants.reset = a_reset ? sl::Boolean::eTrue : sl::Boolean::eFalse;
 	slConstants.motionVectors3D = sl::Boolean::eFalse;
@@ -236,19 +324,46 @@ void Streamline::UpdateConstants(float2 a_jitter, bool a_reset)
 	slConstants.motionVectorsDilated = sl::Boolean::eFalse;
 	slConstants.motionVectorsJittered = sl::Boolean::eFalse;
 
-	if (SL_FAILED(res, slGetNewFrameToken(frameToken, nullptr))) {
-		logger::error("[Streamline] Could not get frame token");
+	if (SL_FAILED(res, slSetConstants(slConstants, *frameToken, sl::ViewportHandle(StereoViewports::GetViewportId(a_eye))))) {
+		static LogLimiter limiter;
+		if (auto repeats = limiter.Check())
+			logger::error("[Streamline] Could not set constants{}", *repeats);
+		return false;
 	}
 
-	if (SL_FAILED(res, slSetConstants(slConstants, *frameToken, viewport))) {
-		logger::error("[Streamline] Could not set constants");
-	}
+	return true;
 }
 
 void Streamline::DestroyDLSSResources()
 {
-	sl::DLSSOptions dlssOptions{};
-	dlssOptions.mode = sl::DLSSMode::eOff;
-	slDLSSSetOptions(viewport, dlssOptions);
-	slFreeResources(sl::kFeatureDLSS, viewport);
-}
\ No newline at end of file
+	for (uint eye = 0; eye < eyeCount; eye++) {
+		sl::ViewportHandle viewport(StereoViewports::GetViewportId(eye));
+		sl::DLSSOptions dlssOptions{};
+		dlssOptions.mode = sl::DLSSMode::eOff;
+		slDLSSSetOptions(viewport, dlssOptions);
+		slFreeResources(sl::kFeatureDLSS, viewport);
+	}
+
+	MemoryTracker::GetSingleton()->Remove(MemoryTracker::Category::kDLSS, dlssBytes);
+	dlssBytes = 0;
+}
+
+void Streamline::UpdateMemoryUsage()
+{
+	if (!featureDLSS)
+		return;
+
+	uint64_t bytes = 0;
+	for (uint eye = 0; eye < eyeCount; eye++) {
+		sl::ViewportHandle viewport(StereoViewports::GetViewportId(eye));
+		sl::DLSSState state{};
+		if (SL_FAILED(result, slDLSSGetState(viewport, state)))
+			return;
+		bytes += state.estimatedVRAMUsageInBytes;
+	}
+
+	auto memoryTracker = MemoryTracker::GetSingleton();
+	memoryTracker->Remove(MemoryTracker::Category::kDLSS, dlssBytes);
+	memoryTracker->Add(MemoryTracker::Category::kDLSS, bytes);
+	dlssBytes = bytes;
+}
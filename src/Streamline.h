@@ -1,5 +1,7 @@
 #pragma once
 
+#include <future>
+
 #define NV_WINDOWS
 #include <sl.h>
 #include <sl_consts.h>
@@ -9,6 +11,7 @@
 #include <sl_reflex.h>
 
 #include "Buffer.h"
+#include "StereoViewports.h"
 
 class Streamline
 {
@@ -24,8 +27,9 @@ public:
 	bool initialized = false;
 	bool featureDLSS = false;
 
-	sl::ViewportHandle viewport{ 0 };
-	sl::FrameToken* frameToken;
+	// Eyes whose viewports hold DLSS resources
+	uint eyeCount = 1;
+	sl::FrameToken* frameToken = nullptr;
 
 	HMODULE interposer = NULL;
 
@@ -53,13 +57,32 @@ public:
 	PFun_slDLSSGetState* slDLSSGetState{};
 	PFun_slDLSSSetOptions* slDLSSSetOptions{};
 
+	// Loads the interposer and runs slInit on a worker thread while the game starts, joined before device creation
+	std::future<void> startup;
+	void StartInterposer();
+
 	void LoadInterposer();
 	void Initialize();
 
+	// Routes Streamline's own messages into the plugin log
+	static void LogMessageCallback(sl::LogType a_type, const char* a_message);
+
+	// Results that say DLSS can never work with this adapter, driver and OS, rather than a broken install
+	static bool IsCapabilityError(sl::Result a_result);
+
 	HRESULT CreateDeviceAndSwapChain(IDXGIAdapter* pAdapter, D3D_DRIVER_TYPE DriverType, HMODULE Software, UINT Flags, const D3D_FEATURE_LEVEL* pFeatureLevels, UINT FeatureLevels, UINT SDKVersion, const DXGI_SWAP_CHAIN_DESC* pSwapChainDesc, IDXGISwapChain** ppSwapChain, ID3D11Device** ppDevice, D3D_FEATURE_LEVEL* pFeatureLevel, ID3D11DeviceContext** ppImmediateContext);
 
-	void Upscale(Texture2D* a_color, Texture2D* a_alphaMask, float2 a_jitter, bool a_reset, sl::DLSSPreset a_preset);
-	void UpdateConstants(float2 a_jitter, bool a_reset);
+	// All return false when Streamline rejected the frame. Every eye is evaluated back to back on the same textures,
+	// each tagged with its own extent.
+	bool Upscale(Texture2D* a_color, Texture2D* a_alphaMask, const StereoViewports& a_viewports, float2 a_jitter, bool a_reset, sl::DLSSPreset a_preset);
+	bool AcquireFrameToken();
+	bool UpdateConstants(const StereoViewports& a_viewports, uint a_eye, float2 a_jitter, bool a_reset);
 
 	void DestroyDLSSResources();
+
+	// DLSS's own estimate for every eye, added to MemoryTracker
+	uint64_t dlssBytes = 0;
+	// Refreshes dlssBytes, DLSS only knows it once options were set
+	void UpdateMemoryUsage();
+
 };
@@ -1,35 +1,193 @@
 #include "Upscaling.h"
 
-#include <ClibUtil/simpleINI.hpp>
+#include <magic_enum.hpp>
 
 #include <ENB/ENBSeriesAPI.h>
 extern ENB_API::ENBSDKALT1001* g_ENB;
 
+#include "ConfigService.h"
+#include "FrameCapture.h"
+#include "MemoryTracker.h"
+#include "RCASClassifier.h"
+#include "SettingsSchema.h"
+#include "StaticDetector.h"
 #include "Util.h"
 
-void Upscaling::LoadINI()
+static_assert((uint)DLSSPreset::kPresetA == (uint)sl::DLSSPreset::ePresetA && (uint)DLSSPreset::kPresetF == (uint)sl::DLSSPreset::ePresetF);
+static_assert(DefaultBypassMenus.View() == MenuList{ { RE::LoadingMenu::MENU_NAME, RE::MapMenu::MENU_NAME, RE::LockpickingMenu::MENU_NAME, RE::MainMenu::MENU_NAME, RE::MistMenu::MENU_NAME, RE::InventoryMenu::MENU_NAME, RE::MagicMenu::MENU_NAME, RE::StatsMenu::MENU_NAME, RE::JournalMenu::MENU_NAME, RE::CreationClubMenu::MENU_NAME, RE::ModManagerMenu::MENU_NAME, RE::CreditsMenu::MENU_NAME }, ',' }.View());
+
+void Upscaling::RegisterINI()
 {
-	std::lock_guard<std::shared_mutex> lk(fileLock);
-	CSimpleIniA ini;
-	ini.LoadFile(L"enbseries/enbantialiasing.ini");
+	iniFile = ConfigService::GetSingleton()->Register(L"enbseries/enbantialiasing.ini", [this](std::string_view a_text) { ApplyINI(a_text); }, true);
+}
 
-	settings.upscaleMethod = clib_util::ini::get_value<uint>(ini, settings.upscaleMethod, "ANTIALIASING", "Method", "# Used when DLAA is available\n# Default: 2 (DLAA)");
-	settings.upscaleMethodNoDLSS = clib_util::ini::get_value<uint>(ini, settings.upscaleMethodNoDLSS, "ANTIALIASING", "MethodNoDLAA", "# Used when DLAA is not available\n# Default: 1 (FSR)");
-	settings.sharpness = clib_util::ini::get_value<float>(ini, settings.sharpness, "ANTIALIASING", "Sharpness", "# RCAS sharpening, range of 0.0 to 1.0\n# Default: 0.5");
-	settings.dlssPreset = clib_util::ini::get_value<uint>(ini, settings.dlssPreset, "ANTIALIASING", "DLAAPreset", "# DLAA preset which affects image clarity and ghosting\n# Default: 5 (Preset E)");
+void Upscaling::LoadINI()
+{
+	ConfigService::GetSingleton()->RequestLoad(iniFile);
 }
 
 void Upscaling::SaveINI()
 {
+	std::array<char, 4 * 1024> buffer;
+	std::size_t size;
+	{
+		std::shared_lock<std::shared_mutex> lk(fileLock);
+		size = SettingsSchema::SerializeINI(settings, buffer.data(), buffer.size());
+	}
+	ConfigService::GetSingleton()->RequestSave(iniFile, { buffer.data(), size });
+}
+
+void Upscaling::ApplyINI(std::string_view a_text)
+{
+	// Parsed straight into the edit copy, keys the file does not have keep their current values, and publishing
+	// only queues commands for what actually changed
 	std::lock_guard<std::shared_mutex> lk(fileLock);
-	CSimpleIniA ini;
+	SettingsSchema::ParseINI(a_text, settings);
+	PublishSettings();
+}
+
+template <class T>
+static void TW_CALL SetSettingCallback(const void* a_value, void* a_clientData)
+{
+	auto upscaling = Upscaling::GetSingleton();
+	std::lock_guard<std::shared_mutex> lk(upscaling->fileLock);
+	*static_cast<T*>(a_clientData) = *static_cast<const T*>(a_value);
+	upscaling->PublishSettings();
+}
+
+template <class T>
+static void TW_CALL GetSettingCallback(void* a_value, void* a_clientData)
+{
+	auto upscaling = Upscaling::GetSingleton();
+	std::shared_lock<std::shared_mutex> lk(upscaling->fileLock);
+	*static_cast<T*>(a_value) = *static_cast<const T*>(a_clientData);
+}
 
-	ini.SetValue("ANTIALIASING", "Method", std::to_string(settings.upscaleMethod).c_str(), "# Used when DLAA is available\n# Default: 2 (DLAA)");
-	ini.SetValue("ANTIALIASING", "MethodNoDLAA", std::to_string(settings.upscaleMethodNoDLSS).c_str(), "# Used when DLAA is not available\n# Default: 1 (FSR)");
-	ini.SetValue("ANTIALIASING", "Sharpness", std::to_string(settings.sharpness).c_str(), "# RCAS sharpening, range of 0.0 to 1.0\n# Default: 0.5");
-	ini.SetValue("ANTIALIASING", "DLAAPreset", std::to_string(settings.dlssPreset).c_str(), "# DLAA preset which affects image clarity and ghosting\n# Default: 5 (Preset E)");
+static void AddSettingUI(TwBar* a_bar, const SettingsSchema::FloatField& a_field, Upscaling::Settings& a_settings)
+{
+	char def[128]{};
+	SettingsSchema::Writer writer{ def, sizeof(def) - 1 };
+	writer.Append("group='");
+	writer.Append(SettingsSchema::Section);
+	writer.Append("' min=");
+	writer.Append(a_field.min);
+	writer.Append(" max=");
+	writer.Append(a_field.max);
+	writer.Append(" step=");
+	writer.Append(a_field.step);
+
+	g_ENB->TwAddVarCB(a_bar, a_field.label.data(), TwType::TW_TYPE_FLOAT, SetSettingCallback<float>, GetSettingCallback<float>, &(a_settings.*a_field.member), def);
+}
 
-	ini.SaveFile("enbseries/enbantialiasing.ini");
+static void AddSettingUI(TwBar* a_bar, const SettingsSchema::BoolField& a_field, Upscaling::Settings& a_settings)
+{
+	g_ENB->TwAddVarCB(a_bar, a_field.label.data(), TwType::TW_TYPE_BOOLCPP, SetSettingCallback<bool>, GetSettingCallback<bool>, &(a_settings.*a_field.member), "group='ANTIALIASING'");
+}
+
+// Lists are only edited in the INI
+static void AddSettingUI(TwBar*, const SettingsSchema::ListField&, Upscaling::Settings&) {}
+
+template <class E, std::size_t N>
+static void AddSettingUI(TwBar* a_bar, const SettingsSchema::EnumField<E, N>& a_field, Upscaling::Settings& a_settings)
+{
+	// Schema strings are literals, so they are already null terminated
+	TwEnumVal values[N];
+	for (std::size_t i = 0; i < N; i++)
+		values[i] = { (int)i, a_field.names[i].data() };
+
+	TwType type = g_ENB->TwDefineEnum(a_field.typeName.data(), values, (unsigned int)a_field.count);
+	g_ENB->TwAddVarCB(a_bar, a_field.label.data(), type, SetSettingCallback<uint>, GetSettingCallback<uint>, &(a_settings.*a_field.member), "group='ANTIALIASING'");
+}
+
+static constexpr std::size_t HealthTextSize = 64;
+
+static void TW_CALL GetHealthCallback(void* a_value, void* a_clientData)
+{
+	static auto gameViewport = RE::BSGraphics::State::GetSingleton();
+
+	auto health = static_cast<const CircuitBreaker*>(a_clientData);
+	auto text = static_cast<char*>(a_value);
+	auto trips = health->GetTrips();
+
+	std::format_to_n_result<char*> result;
+	switch (health->GetState()) {
+	case CircuitBreaker::State::kTripped:
+		{
+			auto retryFrame = health->GetRetryFrame();
+			auto frames = retryFrame > gameViewport->frameCount ? retryFrame - gameViewport->frameCount : 0;
+			result = std::format_to_n(text, HealthTextSize - 1, "Failing, using TAA, retry in {} frames", frames);
+			break;
+		}
+	case CircuitBreaker::State::kRetrying:
+		result = std::format_to_n(text, HealthTextSize - 1, "Retrying");
+		break;
+	default:
+		result = trips ? std::format_to_n(text, HealthTextSize - 1, "Healthy, recovered {} times", trips) : std::format_to_n(text, HealthTextSize - 1, "Healthy");
+		break;
+	}
+	*result.out = '\0';
+}
+
+static void TW_CALL GetPacingCallback(void* a_value, void*)
+{
+	auto frameGeneration = FrameGeneration::GetSingleton();
+	auto mean = frameGeneration->pacingMean.load(std::memory_order_relaxed);
+	auto deviation = frameGeneration->pacingDeviation.load(std::memory_order_relaxed);
+	auto text = static_cast<char*>(a_value);
+
+	auto result = mean < 0.0f ? std::format_to_n(text, HealthTextSize - 1, "Inactive") : std::format_to_n(text, HealthTextSize - 1, "{:.1f} ms, deviation {:.2f} ms", mean, deviation);
+	*result.out = '\0';
+}
+
+static void TW_CALL GetMemoryCallback(void* a_value, void* a_clientData)
+{
+	auto bytes = MemoryTracker::GetSingleton()->Get((MemoryTracker::Category)(uintptr_t)a_clientData);
+	auto text = static_cast<char*>(a_value);
+
+	auto result = std::format_to_n(text, HealthTextSize - 1, "{} MB", bytes >> 20);
+	*result.out = '\0';
+}
+
+static void TW_CALL GetBudgetCallback(void* a_value, void*)
+{
+	auto memoryTracker = MemoryTracker::GetSingleton();
+	auto budget = memoryTracker->budget.load(std::memory_order_relaxed);
+	auto usage = memoryTracker->usage.load(std::memory_order_relaxed);
+	auto text = static_cast<char*>(a_value);
+
+	std::format_to_n_result<char*> result;
+	if (!budget) {
+		result = std::format_to_n(text, HealthTextSize - 1, "Unknown");
+	} else {
+		switch (Upscaling::GetSingleton()->memoryLevel.load(std::memory_order_relaxed)) {
+		case MemoryPolicy::Level::kNoFrameGeneration:
+			result = std::format_to_n(text, HealthTextSize - 1, "{} of {} MB, frame generation off", usage >> 20, budget >> 20);
+			break;
+		case MemoryPolicy::Level::kTAAOnly:
+			result = std::format_to_n(text, HealthTextSize - 1, "{} of {} MB, using TAA", usage >> 20, budget >> 20);
+			break;
+		default:
+			result = std::format_to_n(text, HealthTextSize - 1, "{} of {} MB", usage >> 20, budget >> 20);
+			break;
+		}
+	}
+	*result.out = '\0';
+}
+
+static void TW_CALL ToggleCaptureCallback(void*)
+{
+	auto frameCapture = FrameCapture::GetSingleton();
+	frameCapture->requested = !frameCapture->requested;
+}
+
+static void TW_CALL GetCaptureCallback(void* a_value, void*)
+{
+	auto frameCapture = FrameCapture::GetSingleton();
+	auto text = static_cast<char*>(a_value);
+
+	auto result = frameCapture->recording ? std::format_to_n(text, HealthTextSize - 1, "Recording, {} frames, {} planes dropped", frameCapture->framesCaptured.load(), frameCapture->planesDropped.load()) :
+	                                        std::format_to_n(text, HealthTextSize - 1, "Off");
+	*result.out = '\0';
 }
 
 void Upscaling::RefreshUI()
@@ -38,76 +196,366 @@ void Upscaling::RefreshUI()
 
 	auto generalBar = g_ENB->TwGetBarByEnum(ENB_API::ENBWindowType::EditorBarButtons);
 
-	TwEnumVal aaMethodsDefine[] = { { 0, "TAA" }, { 1, "AMD FSR 3.1" }, { 2, "NVIDIA DLAA" } };
-	TwType aaMethodType = g_ENB->TwDefineEnum("AA_METHOD", aaMethodsDefine, streamline->featureDLSS ? 3 : 2);
-	g_ENB->TwAddVarRW(generalBar, "Method", aaMethodType, streamline->featureDLSS ? &settings.upscaleMethod : &settings.upscaleMethodNoDLSS, "group='ANTIALIASING'");
-	
-	g_ENB->TwAddVarRW(generalBar, "Sharpness", TwType::TW_TYPE_FLOAT, &settings.sharpness, "group='ANTIALIASING' min=0.0 max=1.0 step=0.1");
+	SettingsSchema::ForEachField([&](const auto& a_field) {
+		if (SettingsSchema::IsVisible(a_field.visibility, streamline->featureDLSS))
+			AddSettingUI(generalBar, a_field, settings);
+	});
+
+	// Read only, there is no set callback
+	if (streamline->featureDLSS)
+		g_ENB->TwAddVarCB(generalBar, "DLAA Status", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetHealthCallback, &dlssHealth, "group='ANTIALIASING'");
+	g_ENB->TwAddVarCB(generalBar, "FSR Status", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetHealthCallback, &fsrHealth, "group='ANTIALIASING'");
+	g_ENB->TwAddVarCB(generalBar, "Frame Pacing", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetPacingCallback, nullptr, "group='ANTIALIASING'");
+
+	g_ENB->TwAddVarCB(generalBar, "Video Memory", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetBudgetCallback, nullptr, "group='ANTIALIASING'");
+	g_ENB->TwAddVarCB(generalBar, "Shared Memory", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetMemoryCallback, (void*)(uintptr_t)MemoryTracker::Category::kShared, "group='ANTIALIASING'");
+	g_ENB->TwAddVarCB(generalBar, "FSR Memory", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetMemoryCallback, (void*)(uintptr_t)MemoryTracker::Category::kFSR, "group='ANTIALIASING'");
+	if (streamline->featureDLSS)
+		g_ENB->TwAddVarCB(generalBar, "DLAA Memory", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetMemoryCallback, (void*)(uintptr_t)MemoryTracker::Category::kDLSS, "group='ANTIALIASING'");
+	g_ENB->TwAddVarCB(generalBar, "Frame Generation Memory", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetMemoryCallback, (void*)(uintptr_t)MemoryTracker::Category::kFrameGeneration, "group='ANTIALIASING'");
+
+	// Writes the upscaler's inputs to enbseries/captures for offline tuning
+	g_ENB->TwAddButton(generalBar, "Start/Stop Frame Capture", ToggleCaptureCallback, nullptr, "group='ANTIALIASING'");
+	g_ENB->TwAddVarCB(generalBar, "Frame Capture", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetCaptureCallback, nullptr, "group='ANTIALIASING'");
+	g_ENB->TwAddVarCB(generalBar, "Frame Capture Memory", TW_TYPE_CSSTRING(HealthTextSize), nullptr, GetMemoryCallback, (void*)(uintptr_t)MemoryTracker::Category::kCapture, "group='ANTIALIASING'");
+}
+
+void Upscaling::PublishSettings()
+{
+	SettingsSchema::Validate(settings);
+	settingsSnapshot.Publish(settings);
+
+	if (settings.upscaleMethod != publishedSettings.upscaleMethod || settings.upscaleMethodNoDLSS != publishedSettings.upscaleMethodNoDLSS)
+		PushCommand(Command::kMethodChanged);
+	if (settings.dlssPreset != publishedSettings.dlssPreset)
+		PushCommand(Command::kPresetChanged);
 
-	TwEnumVal dlssPresetsDefine[] = { { 0, "Default" }, { 1, "Preset A" }, { 2, "Preset B" }, { 3, "Preset C" }, { 4, "Preset D" }, { 5, "Preset E" }, { 6, "Preset F" } };
-	TwType dlssPresetType = g_ENB->TwDefineEnum("DLSS_PRESET", dlssPresetsDefine, 7);
-	g_ENB->TwAddVarRW(generalBar, "DLAA Preset", dlssPresetType, &settings.dlssPreset, "group='ANTIALIASING'");
+	publishedSettings = settings;
 }
 
-Upscaling::UpscaleMethod Upscaling::GetUpscaleMethod()
+void Upscaling::AcquireSettings()
+{
+	frameSettings = settingsSnapshot.Acquire();
+}
+
+void Upscaling::PushCommand(Command a_command)
+{
+	std::lock_guard<std::mutex> lk(commandLock);
+	if (!commands.Push(a_command))
+		logger::warn("Command queue is full, dropping {}", magic_enum::enum_name(a_command));
+}
+
+RE::BSEventNotifyControl Upscaling::ProcessEvent(const RE::MenuOpenCloseEvent* a_event, RE::BSTEventSource<RE::MenuOpenCloseEvent>*)
+{
+	std::string_view name = a_event->menuName.c_str();
+
+	bool listed = false;
+	{
+		std::shared_lock<std::shared_mutex> lk(fileLock);
+		SettingsSchema::ForEachListItem(settings.bypassMenus.View(), [&](std::string_view a_item) { listed |= a_item == name; });
+	}
+
+	// A menu that opened while listed still ends the bypass when it closes, even if the list changed since
+	auto open = std::find(openBypassMenus.begin(), openBypassMenus.end(), name);
+	if (a_event->opening && listed && open == openBypassMenus.end())
+		openBypassMenus.emplace_back(name);
+	else if (!a_event->opening && open != openBypassMenus.end())
+		openBypassMenus.erase(open);
+
+	bool anyOpen = !openBypassMenus.empty();
+	if (anyOpen != anyBypassMenuOpen) {
+		anyBypassMenuOpen = anyOpen;
+		PushCommand(anyOpen ? Command::kMenuBypassBegin : Command::kMenuBypassEnd);
+	}
+
+	return RE::BSEventNotifyControl::kContinue;
+}
+
+void Upscaling::ProcessCommands()
+{
+	// Drain before acquiring settings, anything published alongside a command is then visible this frame
+	bool resize = false;
+	bool presetChanged = false;
+
+	Command command;
+	while (commands.Pop(command)) {
+		switch (command) {
+		case Command::kMethodChanged:
+			resourcesDirty = true;
+			reset = true;
+			// Picking a method again is an explicit request to retry it
+			fsrHealth.Reset();
+			dlssHealth.Reset();
+			break;
+		case Command::kPresetChanged:
+			presetChanged = true;
+			break;
+		case Command::kResize:
+			resize = true;
+			reset = true;
+			break;
+		case Command::kMenuBypassBegin:
+			menuOpen = true;
+			reset = true;
+			break;
+		case Command::kMenuBypassEnd:
+			menuOpen = false;
+			reset = true;
+			break;
+		}
+	}
+
+	AcquireSettings();
+	UpdateMemoryBudget();
+	SelectMethod();
+
+	static auto gameViewport = RE::BSGraphics::State::GetSingleton();
+	auto health = GetHealth(GetUpscaleMethod());
+
+	// History is stale after any stretch of frames the upscaler did not see
+	bool bypass = (menuOpen && frameSettings.menuBypass) || (health && !health->Allow(gameViewport->frameCount));
+	if (bypassed && !bypass)
+		reset = true;
+	bypassed = bypass;
+
+	if (resize && resourceMethod != UpscaleMethod::kTAA) {
+		auto method = resourceMethod;
+		CheckResources(UpscaleMethod::kTAA);
+		CheckResources(method);
+	}
+
+	if (resourcesDirty) {
+		CheckResources(GetUpscaleMethod());
+		resourcesDirty = false;
+	}
+
+	if (presetChanged && resourceMethod == UpscaleMethod::kDLSS)
+		Streamline::GetSingleton()->DestroyDLSSResources();
+
+	auto fidelityFX = FidelityFX::GetSingleton();
+	bool frameGeneration = UseFrameGeneration();
+	if (resourceMethod == UpscaleMethod::kFSR && fidelityFX->frameGeneration != frameGeneration) {
+		fidelityFX->DestroyFSRResources();
+		fidelityFX->CreateFSRResources(frameGeneration);
+		reset = true;
+	}
+
+	FrameGeneration::GetSingleton()->renderStartPresent = frameSettings.frameGenerationRenderStart;
+	// Interpolated menus smear the UI, and without FSR running there is nothing to interpolate from
+	FrameGeneration::GetSingleton()->active = fidelityFX->frameGeneration && resourceMethod == UpscaleMethod::kFSR && !menuOpen && !bypassed;
+
+	FrameCapture::GetSingleton()->Update(frameIndex);
+}
+
+static_assert((uint)MethodSelector::Method::kFSR == (uint)Upscaling::UpscaleMethod::kFSR && (uint)MethodSelector::Method::kDLSS == (uint)Upscaling::UpscaleMethod::kDLSS);
+
+void Upscaling::SelectMethod()
+{
+	static auto gameViewport = RE::BSGraphics::State::GetSingleton();
+
+	auto method = GetConfiguredMethod();
+
+	// FSR 3 takes no input offsets, so it cannot run on one eye of a side by side target
+	bool stereo = REL::Module::IsVR();
+	if (stereo && method == UpscaleMethod::kFSR)
+		method = UpscaleMethod::kTAA;
+
+	if (autoActive != frameSettings.autoMethod) {
+		autoActive = frameSettings.autoMethod;
+		methodSelector.Reset();
+	}
+
+	if (autoActive) {
+		methodSelector.thresholds.budget = frameSettings.autoBudget;
+		methodTimer.Collect([&](uint a_method, float a_milliseconds) {
+			methodSelector.Record((MethodSelector::Method)a_method, a_milliseconds);
+		});
+
+		// Menus are not representative of the game's cost, keep whatever was chosen before them
+		if (menuOpen && frameSettings.menuBypass) {
+			method = std::min(method, (UpscaleMethod)methodSelector.GetChoice());
+		} else {
+			uint available = 1 << (uint)UpscaleMethod::kTAA;
+			if (!stereo)
+				available |= 1 << (uint)UpscaleMethod::kFSR;
+			if (Streamline::GetSingleton()->featureDLSS)
+				available |= 1 << (uint)UpscaleMethod::kDLSS;
+			method = (UpscaleMethod)methodSelector.Update(gameViewport->frameCount, available, (MethodSelector::Method)method);
+		}
+	}
+
+	if (memoryPolicy.GetLevel() == MemoryPolicy::Level::kTAAOnly)
+		method = UpscaleMethod::kTAA;
+
+	if (method != frameMethod) {
+		if (autoActive && !methodSelector.IsMeasuring())
+			logger::info("Auto method switched to {}, measured TAA {:.2f} ms, FSR {:.2f} ms, DLAA {:.2f} ms", magic_enum::enum_name(method),
+				methodSelector.GetEstimate(MethodSelector::Method::kTAA), methodSelector.GetEstimate(MethodSelector::Method::kFSR), methodSelector.GetEstimate(MethodSelector::Method::kDLSS));
+		frameMethod = method;
+		resourcesDirty = true;
+		reset = true;
+	}
+}
+
+Upscaling::UpscaleMethod Upscaling::GetConfiguredMethod()
 {
 	auto streamline = Streamline::GetSingleton();
-	return streamline->featureDLSS ? (UpscaleMethod)settings.upscaleMethod : (UpscaleMethod)settings.upscaleMethodNoDLSS;
+	return streamline->featureDLSS ? (UpscaleMethod)frameSettings.upscaleMethod : (UpscaleMethod)frameSettings.upscaleMethodNoDLSS;
 }
 
-void Upscaling::CheckResources()
+CircuitBreaker* Upscaling::GetHealth(UpscaleMethod a_method)
 {
-	static auto previousUpscaleMode = UpscaleMethod::kTAA;
-	auto currentUpscaleMode = GetUpscaleMethod();
+	switch (a_method) {
+	case UpscaleMethod::kFSR:
+		return &fsrHealth;
+	case UpscaleMethod::kDLSS:
+		return &dlssHealth;
+	default:
+		return nullptr;
+	}
+}
 
+void Upscaling::CheckResources(UpscaleMethod a_method)
+{
 	auto streamline = Streamline::GetSingleton();
 	auto fidelityFX = FidelityFX::GetSingleton();
 
-	if (previousUpscaleMode != currentUpscaleMode) {
-		if (previousUpscaleMode == UpscaleMethod::kTAA)
+	if (resourceMethod != a_method) {
+		if (resourceMethod == UpscaleMethod::kTAA)
 			CreateUpscalingResources();
-		else if (previousUpscaleMode == UpscaleMethod::kFSR)
+		else if (resourceMethod == UpscaleMethod::kFSR)
 			fidelityFX->DestroyFSRResources();
-		else if (previousUpscaleMode == UpscaleMethod::kDLSS)
+		else if (resourceMethod == UpscaleMethod::kDLSS)
 			streamline->DestroyDLSSResources();
 
-		if (currentUpscaleMode == UpscaleMethod::kTAA)
+		if (a_method == UpscaleMethod::kTAA)
 			DestroyUpscalingResources();
-		else if (currentUpscaleMode == UpscaleMethod::kFSR)
-			fidelityFX->CreateFSRResources();
+		else if (a_method == UpscaleMethod::kFSR)
+			fidelityFX->CreateFSRResources(UseFrameGeneration());
 
-		previousUpscaleMode = currentUpscaleMode;
+		resourceMethod = a_method;
 	}
 }
 
-ID3D11ComputeShader* Upscaling::GetRCASComputeShader()
+void Upscaling::UpdateMemoryBudget()
 {
-	static auto previousSharpness = settings.sharpness;
-	auto currentSharpness = settings.sharpness;
+	static auto gameViewport = RE::BSGraphics::State::GetSingleton();
+	if (gameViewport->frameCount % MemoryInterval)
+		return;
+
+	if (resourceMethod == UpscaleMethod::kDLSS)
+		Streamline::GetSingleton()->UpdateMemoryUsage();
+
+	auto memoryTracker = MemoryTracker::GetSingleton();
+	if (!memoryTracker->QueryBudget())
+		return;
+
+	using Category = MemoryTracker::Category;
+	MemoryPolicy::Sample sample{
+		.budget = memoryTracker->budget.load(std::memory_order_relaxed),
+		.usage = memoryTracker->usage.load(std::memory_order_relaxed),
+		.frameGenerationBytes = memoryTracker->Get(Category::kFrameGeneration),
+		.upscalingBytes = memoryTracker->Get(Category::kShared) + memoryTracker->Get(Category::kFSR) + memoryTracker->Get(Category::kDLSS)
+	};
 
-	if (previousSharpness != currentSharpness) {
-		previousSharpness = currentSharpness;
+	auto previous = memoryPolicy.GetLevel();
+	auto level = memoryPolicy.Update(gameViewport->frameCount, sample);
+	if (level == previous)
+		return;
 
-		if (rcasCS) {
-			rcasCS->Release();
-			rcasCS = nullptr;
-		}
+	auto headroom = MemoryPolicy::GetHeadroom(sample) / (1 << 20);
+	if (level > previous)
+		logger::warn("Video memory headroom is {} MB, degrading to {}, plugin holds {} MB", headroom, magic_enum::enum_name(level), memoryTracker->GetTotal() >> 20);
+	else
+		logger::info("Video memory headroom is {} MB, restoring {}", headroom, magic_enum::enum_name(level));
+
+	// SelectMethod and the FSR context follow the new level this frame, the copies are only freed here
+	if (level != MemoryPolicy::Level::kNormal)
+		FrameGeneration::GetSingleton()->Release();
+	memoryLevel.store(level, std::memory_order_relaxed);
+}
+
+bool Upscaling::UseHalfPrecision()
+{
+	if (!halfPrecisionSupported.has_value()) {
+		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+		D3D11_FEATURE_DATA_SHADER_MIN_PRECISION_SUPPORT precision{};
+		halfPrecisionSupported = SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_SHADER_MIN_PRECISION_SUPPORT, &precision, sizeof(precision))) &&
+		                         (precision.AllOtherShaderStagesMinPrecision & D3D11_SHADER_MIN_PRECISION_16_BIT);
+		logger::info("16-bit shader precision {}", *halfPrecisionSupported ? "supported" : "not supported");
 	}
+	return frameSettings.halfPrecision && *halfPrecisionSupported;
+}
 
-	if (!rcasCS) {
-		logger::debug("Compiling RCAS.hlsl");
-		rcasCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data/SKSE/Plugins/ENBAntiAliasing/RCAS/RCAS.hlsl", { { "SHARPNESS", std::format("{}", currentSharpness).c_str() } }, "cs_5_0");
+// GROUP_SIZE_X and GROUP_SIZE_Y for a GroupSizeTuner candidate
+static void AddGroupSizeDefines(std::vector<std::pair<const char*, const char*>>& a_defines, uint a_groupSize)
+{
+	static const auto values = [] {
+		std::array<std::pair<std::string, std::string>, GroupSizeTuner::Candidates.size()> values;
+		for (uint i = 0; i < values.size(); i++)
+			values[i] = { std::to_string(GroupSizeTuner::Candidates[i].x), std::to_string(GroupSizeTuner::Candidates[i].y) };
+		return values;
+	}();
+	a_defines.push_back({ "GROUP_SIZE_X", values[a_groupSize].first.c_str() });
+	a_defines.push_back({ "GROUP_SIZE_Y", values[a_groupSize].second.c_str() });
+}
+
+ID3D11ComputeShader* Upscaling::GetRCASComputeShader(bool a_tiled, SharpenKernel a_kernel, uint a_groupSize)
+{
+	bool half = UseHalfPrecision();
+	auto& shader = rcasCS[a_tiled][(uint)a_kernel][half][a_groupSize];
+	if (!shader) {
+		logger::debug("Compiling RCAS.hlsl {}{}{} {}x{}", magic_enum::enum_name(a_kernel), a_tiled ? " TILED" : "", half ? " HALF" : "",
+			GroupSizeTuner::Candidates[a_groupSize].x, GroupSizeTuner::Candidates[a_groupSize].y);
+		std::vector<std::pair<const char*, const char*>> defines;
+		if (a_tiled)
+			defines.push_back({ "TILED", "" });
+		else
+			AddGroupSizeDefines(defines, a_groupSize);
+		if (a_kernel == SharpenKernel::kGroupshared)
+			defines.push_back({ "GROUPSHARED", "" });
+		if (half)
+			defines.push_back({ "HALF", "" });
+		shader = (ID3D11ComputeShader*)Util::CompileShader(L"Data/SKSE/Plugins/ENBAntiAliasing/RCAS/RCAS.hlsl", defines, "cs_5_0");
+	}
+	return shader;
+}
+
+ID3D11ComputeShader* Upscaling::GetRCASClassifyCS()
+{
+	if (!rcasClassifyCS) {
+		logger::debug("Compiling RCASClassifyCS.hlsl");
+		rcasClassifyCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data/SKSE/Plugins/ENBAntiAliasing/RCAS/RCASClassifyCS.hlsl", {}, "cs_5_0");
 	}
-	return rcasCS;
+	return rcasClassifyCS;
 }
 
-ID3D11ComputeShader* Upscaling::GetEncodeTexturesCS()
+ID3D11ComputeShader* Upscaling::GetStatisticsCS(bool a_compareColor)
 {
-	if (!encodeTexturesCS) {
-		logger::debug("Compiling EncodeTexturesCS.hlsl");
-		encodeTexturesCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data/SKSE/Plugins/ENBAntiAliasing/EncodeTexturesCS.hlsl", {}, "cs_5_0");
+	auto& shader = a_compareColor ? colorStatisticsCS : motionStatisticsCS;
+	if (!shader) {
+		logger::debug("Compiling StaticDetectionCS.hlsl");
+		if (a_compareColor)
+			shader = (ID3D11ComputeShader*)Util::CompileShader(L"Data/SKSE/Plugins/ENBAntiAliasing/StaticDetectionCS.hlsl", { { "COMPARE_COLOR", "" } }, "cs_5_0");
+		else
+			shader = (ID3D11ComputeShader*)Util::CompileShader(L"Data/SKSE/Plugins/ENBAntiAliasing/StaticDetectionCS.hlsl", {}, "cs_5_0");
 	}
-	return encodeTexturesCS;
+	return shader;
+}
+
+ID3D11ComputeShader* Upscaling::GetEncodeTexturesCS(uint a_groupSize)
+{
+	bool half = UseHalfPrecision();
+	auto& shader = encodeTexturesCS[half][a_groupSize];
+	if (!shader) {
+		logger::debug("Compiling EncodeTexturesCS.hlsl{} {}x{}", half ? " HALF" : "", GroupSizeTuner::Candidates[a_groupSize].x, GroupSizeTuner::Candidates[a_groupSize].y);
+		std::vector<std::pair<const char*, const char*>> defines;
+		AddGroupSizeDefines(defines, a_groupSize);
+		if (half)
+			defines.push_back({ "HALF", "" });
+		shader = (ID3D11ComputeShader*)Util::CompileShader(L"Data/SKSE/Plugins/ENBAntiAliasing/EncodeTexturesCS.hlsl", defines, "cs_5_0");
+	}
+	return shader;
 }
 
 static void SetDirtyStates(bool a_computeShader)
@@ -120,19 +568,25 @@ static void SetDirtyStates(bool a_computeShader)
 void Upscaling::UpdateJitter()
 {
 	auto upscaleMethod = GetUpscaleMethod();
-	if (upscaleMethod != UpscaleMethod::kTAA) {
+	if (!bypassed && upscaleMethod != UpscaleMethod::kTAA) {
 		static auto gameViewport = RE::BSGraphics::State::GetSingleton();
 
-		ffxFsr3UpscalerGetJitterOffset(&jitter.x, &jitter.y, gameViewport->frameCount, 8);
+		// Hold the jitter while idle so consecutive inputs are identical and can be compared against the reference
+		if (!staticDetector.IsStatic())
+			ffxFsr3UpscalerGetJitterOffset(&jitter.x, &jitter.y, gameViewport->frameCount, JitterPhaseCount);
 
-		gameViewport->projectionPosScaleX = -2.0f * jitter.x / (float)gameViewport->screenWidth;
-		gameViewport->projectionPosScaleY = 2.0f * jitter.y / (float)gameViewport->screenHeight;
+		auto offset = viewports.GetProjectionOffset(jitter.x, jitter.y);
+		gameViewport->projectionPosScaleX = offset.first;
+		gameViewport->projectionPosScaleY = offset.second;
 	}
 }
 
 void Upscaling::Upscale()
 {
-	CheckResources();
+	if (!constantBufferRing)
+		constantBufferRing = new ConstantBufferRing(64 * 1024);
+	constantBufferRing->BeginFrame();
+	GroupSizeTuner::GetSingleton()->Update();
 
 	SetDirtyStates(false);
 
@@ -160,14 +614,46 @@ void Upscaling::Upscale()
 	ID3D11Resource* outputTextureResource;
 	outputTextureRTV->GetResource(&outputTextureResource);
 
+	frameIndex++;
+
+	if (frameSettings.idleReuse && !reset) {
+		StaticDetector::Statistics statistics;
+		bool hasStatistics = ReadStatistics(statistics);
+
+		auto cameraData = Util::GetCameraData(0);
+		bool cameraStatic = StaticDetector::IsCameraStatic(cameraData.viewProjMatrixUnjittered, cameraData.previousViewProjMatrixUnjittered, staticDetector.thresholds.camera);
+		staticDetector.Update(frameIndex, cameraStatic, hasStatistics ? &statistics : nullptr);
+	} else {
+		staticDetector.Reset();
+	}
+
+	if (staticDetector.IsStatic() && !staticDetector.JustBecameStatic()) {
+		// upscalingTexture still holds last frame's final output, only watch for the scene changing again
+		DispatchStatistics(inputTextureSRV);
+		auto outputUAV = sharpenedToOutput ? GetOutputUAV(outputTextureResource) : nullptr;
+		if (outputUAV)
+			SharpenToOutput(outputUAV);
+		else
+			context->CopyResource(outputTextureResource, upscalingTexture->resource.get());
+		constantBufferRing->EndFrame();
+		return;
+	}
+
+	if (staticDetector.JustBecameStatic())
+		context->CopyResource(referenceTexture->resource.get(), inputTextureResource);
+
 	context->CopyResource(upscalingTexture->resource.get(), inputTextureResource);
+	Capture(inputTextureResource);
 
 	static auto gameViewport = RE::BSGraphics::State::GetSingleton();
-	uint dispatchX = (uint)std::ceil((float)gameViewport->screenWidth / 8.0f);
-	uint dispatchY = (uint)std::ceil((float)gameViewport->screenHeight / 8.0f);
+	auto tuner = GroupSizeTuner::GetSingleton();
 
 	auto upscaleMethod = GetUpscaleMethod();
-	auto dlssPreset = (sl::DLSSPreset)settings.dlssPreset;
+	auto dlssPreset = (sl::DLSSPreset)frameSettings.dlssPreset;
+
+	// Reused idle frames are left out, they would make every method look free
+	if (autoActive)
+		methodTimer.Begin((uint)upscaleMethod);
 
 	{	
 		static auto& temporalAAMask = renderer->GetRuntimeData().renderTargets[RE::RENDER_TARGETS::kTEMPORAL_AA_MASK];
@@ -179,9 +665,14 @@ void Upscaling::Upscale()
 			ID3D11UnorderedAccessView* uavs[1] = { alphaMaskTexture->uav.get() };
 			context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
 
-			context->CSSetShader(GetEncodeTexturesCS(), nullptr, 0);
+			auto groupSize = tuner->Begin(GroupSizeTuner::Kernel::kEncodeTextures);
 
-			context->Dispatch(dispatchX, dispatchY, 1);
+			context->CSSetShader(GetEncodeTexturesCS(groupSize), nullptr, 0);
+
+			auto& size = GroupSizeTuner::Candidates[groupSize];
+			context->Dispatch(size.CountX(viewports.GetWidth()), size.CountY(viewports.GetHeight()), 1);
+
+			tuner->End(GroupSizeTuner::Kernel::kEncodeTextures);
 		}
 
 		ID3D11ShaderResourceView* views[1] = { nullptr };
@@ -194,41 +685,273 @@ void Upscaling::Upscale()
 		context->CSSetShader(shader, nullptr, 0);
 	}
 
+	if (frameSettings.idleReuse && staticDetector.GetState() == StaticDetector::State::kConverging)
+		DispatchStatistics(nullptr);
+
+	bool upscaled;
 	if (upscaleMethod == UpscaleMethod::kDLSS)
-		Streamline::GetSingleton()->Upscale(upscalingTexture, alphaMaskTexture, jitter, reset, dlssPreset);
+		upscaled = Streamline::GetSingleton()->Upscale(upscalingTexture, alphaMaskTexture, viewports, jitter, reset, dlssPreset);
 	else
-		FidelityFX::GetSingleton()->Upscale(upscalingTexture, alphaMaskTexture, jitter, reset, settings.sharpness);
+		upscaled = FidelityFX::GetSingleton()->Upscale(upscalingTexture, alphaMaskTexture, jitter, reset, frameSettings.sharpness);
+
+	GetHealth(upscaleMethod)->Record(gameViewport->frameCount, upscaled);
+
+	// upscalingTexture may hold anything now, the aliased input is the best this frame can show
+	if (!upscaled) {
+		if (GetHealth(upscaleMethod)->GetState() == CircuitBreaker::State::kTripped)
+			logger::warn("{} keeps failing, using TAA until frame {}", magic_enum::enum_name(upscaleMethod), GetHealth(upscaleMethod)->GetRetryFrame());
+		context->CopyResource(outputTextureResource, inputTextureResource);
+		methodTimer.End();
+		staticDetector.Reset();
+		constantBufferRing->EndFrame();
+		return;
+	}
 
-	if (upscaleMethod != UpscaleMethod::kFSR && settings.sharpness > 0.0f) {
-		context->CopyResource(inputTextureResource, upscalingTexture->resource.get());
+	// Sharpening straight into the output avoids both full screen copies, but leaves upscalingTexture unsharpened
+	sharpenedToOutput = false;
+	if (upscaleMethod != UpscaleMethod::kFSR && frameSettings.sharpness > 0.0f) {
+		if (auto outputUAV = GetOutputUAV(outputTextureResource)) {
+			SharpenToOutput(outputUAV);
+			sharpenedToOutput = true;
+		} else {
+			context->CopyResource(inputTextureResource, upscalingTexture->resource.get());
+			Sharpen(inputTextureSRV);
+		}
+	}
 
-		{
-			{
-				ID3D11ShaderResourceView* views[1] = { inputTextureSRV };
-				context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+	if (!sharpenedToOutput)
+		context->CopyResource(outputTextureResource, upscalingTexture->resource.get());
 
-				ID3D11UnorderedAccessView* uavs[1] = { upscalingTexture->uav.get() };
-				context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+	auto frameGeneration = FrameGeneration::GetSingleton();
+	if (frameGeneration->active && upscaleMethod == UpscaleMethod::kFSR)
+		frameGeneration->CaptureHUDLess(upscalingTexture->resource.get());
 
-				context->CSSetShader(GetRCASComputeShader(), nullptr, 0);
+	methodTimer.End();
 
-				context->Dispatch(dispatchX, dispatchY, 1);
-			}
+	constantBufferRing->EndFrame();
 
-			ID3D11ShaderResourceView* views[1] = { nullptr };
-			context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+	reset = false;
+}
 
-			ID3D11UnorderedAccessView* uavs[1] = { nullptr };
-			context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+void Upscaling::Sharpen(ID3D11ShaderResourceView* a_input)
+{
+	static auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(renderer->GetRuntimeData().context);
+
+	uint tilesX = (viewports.GetWidth() + 7) / 8;
+	uint tilesY = (viewports.GetHeight() + 7) / 8;
+
+	// upscalingTexture already holds the unsharpened image, tiles that are skipped simply keep it
+	{
+		ID3D11ShaderResourceView* views[1] = { a_input };
+		context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+
+		UINT initialCount = 0;
+		ID3D11UnorderedAccessView* uavs[1] = { rcasTiles->uav.get() };
+		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, &initialCount);
+
+		RCASClassifyCB classifyData{ { viewports.GetWidth(), viewports.GetHeight() }, RCASClassifier::GetSkipThreshold(frameSettings.sharpness) };
+		constantBufferRing->CSSetConstantBuffer(0, constantBufferRing->Allocate(classifyData));
 
-			ID3D11ComputeShader* shader = nullptr;
-			context->CSSetShader(shader, nullptr, 0);
+		context->CSSetShader(GetRCASClassifyCS(), nullptr, 0);
+
+		context->Dispatch(tilesX, tilesY, 1);
+	}
+
+	context->CopyStructureCount(rcasIndirectArgs->resource.get(), 0, rcasTiles->uav.get());
+
+	{
+		ID3D11ShaderResourceView* views[2] = { a_input, rcasTiles->srv.get() };
+		context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+
+		ID3D11UnorderedAccessView* uavs[1] = { upscalingTexture->uav.get() };
+		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+
+		RCASCB rcasData{ frameSettings.sharpness, { viewports.GetWidth(), viewports.GetHeight() } };
+		constantBufferRing->CSSetConstantBuffer(0, constantBufferRing->Allocate(rcasData));
+
+		context->CSSetShader(GetRCASComputeShader(true, (SharpenKernel)frameSettings.sharpenKernel), nullptr, 0);
+
+		context->DispatchIndirect(rcasIndirectArgs->resource.get(), 0);
+	}
+
+	ID3D11ShaderResourceView* views[2] = { nullptr, nullptr };
+	context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+
+	ID3D11UnorderedAccessView* uavs[1] = { nullptr };
+	context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+
+	ID3D11Buffer* buffers[1] = { nullptr };
+	context->CSSetConstantBuffers(0, ARRAYSIZE(buffers), buffers);
+
+	ID3D11ComputeShader* shader = nullptr;
+	context->CSSetShader(shader, nullptr, 0);
+}
+
+ID3D11UnorderedAccessView* Upscaling::GetOutputUAV(ID3D11Resource* a_resource)
+{
+	if (outputResource.get() != a_resource) {
+		outputResource.copy_from(a_resource);
+		outputUAV = nullptr;
+
+		D3D11_TEXTURE2D_DESC desc;
+		static_cast<ID3D11Texture2D*>(a_resource)->GetDesc(&desc);
+
+		if ((desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS) && desc.Format == upscalingTexture->desc.Format) {
+			auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+			D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
+				.Format = desc.Format,
+				.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D,
+				.Texture2D = { .MipSlice = 0 }
+			};
+			if (FAILED(device->CreateUnorderedAccessView(a_resource, &uavDesc, outputUAV.put())))
+				outputUAV = nullptr;
 		}
+
+		logger::info("Sharpening {} the output texture", outputUAV ? "writes directly to" : "is copied to");
 	}
+	return outputUAV.get();
+}
 
-	context->CopyResource(outputTextureResource, upscalingTexture->resource.get());
+void Upscaling::SharpenToOutput(ID3D11UnorderedAccessView* a_output)
+{
+	static auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(renderer->GetRuntimeData().context);
 
-	reset = false;
+	// Every output texel is written, so there is no tile classification
+	{
+		ID3D11ShaderResourceView* views[1] = { upscalingTexture->srv.get() };
+		context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+
+		ID3D11UnorderedAccessView* uavs[1] = { a_output };
+		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+
+		RCASCB rcasData{ frameSettings.sharpness, { viewports.GetWidth(), viewports.GetHeight() } };
+		constantBufferRing->CSSetConstantBuffer(0, constantBufferRing->Allocate(rcasData));
+
+		auto sharpenKernel = (SharpenKernel)frameSettings.sharpenKernel;
+		auto tunerKernel = sharpenKernel == SharpenKernel::kGroupshared ? GroupSizeTuner::Kernel::kRCASGroupshared : GroupSizeTuner::Kernel::kRCASDirect;
+		auto tuner = GroupSizeTuner::GetSingleton();
+		auto groupSize = tuner->Begin(tunerKernel);
+
+		context->CSSetShader(GetRCASComputeShader(false, sharpenKernel, groupSize), nullptr, 0);
+
+		auto& size = GroupSizeTuner::Candidates[groupSize];
+		context->Dispatch(size.CountX(viewports.GetWidth()), size.CountY(viewports.GetHeight()), 1);
+
+		tuner->End(tunerKernel);
+	}
+
+	ID3D11ShaderResourceView* views[1] = { nullptr };
+	context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+
+	ID3D11UnorderedAccessView* uavs[1] = { nullptr };
+	context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+
+	ID3D11Buffer* buffers[1] = { nullptr };
+	context->CSSetConstantBuffers(0, ARRAYSIZE(buffers), buffers);
+
+	ID3D11ComputeShader* shader = nullptr;
+	context->CSSetShader(shader, nullptr, 0);
+}
+
+void Upscaling::Capture(ID3D11Resource* a_color)
+{
+	auto frameCapture = FrameCapture::GetSingleton();
+	if (!frameCapture->recording)
+		return;
+
+	static float& deltaTime = (*(float*)REL::RelocationID(523660, 410199).address());
+	static float& cameraNear = (*(float*)(REL::RelocationID(517032, 403540).address() + 0x40));
+	static float& cameraFar = (*(float*)(REL::RelocationID(517032, 403540).address() + 0x44));
+
+	CaptureFile::FrameInfo infos[2]{};
+	auto eyeCount = std::min(viewports.GetEyeCount(), 2u);
+	for (uint eye = 0; eye < eyeCount; eye++) {
+		auto cameraData = Util::GetCameraData(eye);
+		auto eyePosition = Util::GetEyePosition(eye);
+		auto& rect = viewports.GetRect(eye);
+		auto& info = infos[eye];
+
+		std::memcpy(info.viewToClip, &cameraData.viewMat, sizeof(info.viewToClip));
+		std::memcpy(info.viewProjUnjittered, &cameraData.viewProjMatrixUnjittered, sizeof(info.viewProjUnjittered));
+		std::memcpy(info.previousViewProjUnjittered, &cameraData.previousViewProjMatrixUnjittered, sizeof(info.previousViewProjUnjittered));
+		std::memcpy(info.position, &eyePosition, sizeof(info.position));
+		std::memcpy(info.forward, &cameraData.viewForward, sizeof(info.forward));
+		std::memcpy(info.up, &cameraData.viewUp, sizeof(info.up));
+		std::memcpy(info.right, &cameraData.viewRight, sizeof(info.right));
+		info.jitter[0] = jitter.x;
+		info.jitter[1] = jitter.y;
+		info.cameraNear = cameraNear;
+		info.cameraFar = cameraFar;
+		info.verticalFOV = viewports.IsStereo() ? StereoViewports::GetVerticalFOV(cameraData.viewMat) : Util::GetVerticalFOVRad();
+		info.aspectRatio = viewports.GetAspectRatio(eye);
+		info.frameTime = deltaTime;
+		info.eye = eye;
+		info.eyeCount = eyeCount;
+		info.left = rect.left;
+		info.top = rect.top;
+		info.width = rect.width;
+		info.height = rect.height;
+		info.reset = reset;
+		info.method = (uint)GetUpscaleMethod();
+	}
+
+	frameCapture->Capture(frameIndex, a_color, { infos, eyeCount });
+}
+
+void Upscaling::DispatchStatistics(ID3D11ShaderResourceView* a_color)
+{
+	static auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+	static auto context = reinterpret_cast<ID3D11DeviceContext*>(renderer->GetRuntimeData().context);
+	static auto& motionVectors = renderer->GetRuntimeData().renderTargets[RE::RENDER_TARGETS::kMOTION_VECTOR];
+
+	bool compareColor = a_color != nullptr;
+
+	UINT clear[4] = { 0, 0, 0, 0 };
+	context->ClearUnorderedAccessViewUint(statisticsBuffer->uav.get(), clear);
+
+	{
+		ID3D11ShaderResourceView* views[2] = { compareColor ? a_color : motionVectors.SRV, compareColor ? referenceTexture->srv.get() : nullptr };
+		context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+
+		ID3D11UnorderedAccessView* uavs[1] = { statisticsBuffer->uav.get() };
+		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+
+		StaticDetectionCB data{ { (float)viewports.GetWidth(), (float)viewports.GetHeight() } };
+		constantBufferRing->CSSetConstantBuffer(0, constantBufferRing->Allocate(data));
+
+		context->CSSetShader(GetStatisticsCS(compareColor), nullptr, 0);
+
+		context->Dispatch((viewports.GetWidth() + 7) / 8, (viewports.GetHeight() + 7) / 8, 1);
+	}
+
+	ID3D11ShaderResourceView* views[2] = { nullptr, nullptr };
+	context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+
+	ID3D11UnorderedAccessView* uavs[1] = { nullptr };
+	context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
+
+	ID3D11Buffer* buffers[1] = { nullptr };
+	context->CSSetConstantBuffers(0, ARRAYSIZE(buffers), buffers);
+
+	ID3D11ComputeShader* shader = nullptr;
+	context->CSSetShader(shader, nullptr, 0);
+
+	statisticsReadback->Copy(statisticsBuffer->resource.get(), frameIndex, compareColor);
+}
+
+bool Upscaling::ReadStatistics(StaticDetector::Statistics& a_statistics)
+{
+	// Oldest first, so the newest finished result wins
+	return statisticsReadback->Read(frameIndex, [&](const ReadbackRing::Slot& a_slot, const D3D11_MAPPED_SUBRESOURCE& a_mapped) {
+		auto values = static_cast<const float*>(a_mapped.pData);
+		a_statistics.frame = a_slot.frame;
+		a_statistics.hasMotion = a_slot.tag == 0;
+		a_statistics.hasColor = a_slot.tag != 0;
+		a_statistics.motion = values[0];
+		a_statistics.color = values[1];
+	}) > 0;
 }
 
 void Upscaling::CreateUpscalingResources()
@@ -240,6 +963,13 @@ void Upscaling::CreateUpscalingResources()
 	main.texture->GetDesc(&texDesc);
 	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
 
+	// Skyrim VR renders both eyes side by side into the game's targets
+	static auto gameViewport = RE::BSGraphics::State::GetSingleton();
+	if (REL::Module::IsVR())
+		viewports.Configure(2, texDesc.Width, texDesc.Height);
+	else
+		viewports.Configure(1, gameViewport->screenWidth, gameViewport->screenHeight);
+
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {
 		.Format = texDesc.Format,
 		.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D,
@@ -267,6 +997,56 @@ void Upscaling::CreateUpscalingResources()
 	alphaMaskTexture = new Texture2D(texDesc);
 	alphaMaskTexture->CreateSRV(srvDesc);
 	alphaMaskTexture->CreateUAV(uavDesc);
+
+	texDesc.Format = upscalingTexture->desc.Format;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	srvDesc.Format = texDesc.Format;
+
+	referenceTexture = new Texture2D(texDesc);
+	referenceTexture->CreateSRV(srvDesc);
+
+	D3D11_BUFFER_DESC bufferDesc{};
+	bufferDesc.ByteWidth = sizeof(uint) * 4;
+	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	bufferDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+	bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+
+	statisticsBuffer = new Buffer(bufferDesc);
+	statisticsBuffer->CreateUAV({ .Format = DXGI_FORMAT_R32_TYPELESS,
+		.ViewDimension = D3D11_UAV_DIMENSION_BUFFER,
+		.Buffer = { .FirstElement = 0, .NumElements = 4, .Flags = D3D11_BUFFER_UAV_FLAG_RAW } });
+
+	statisticsReadback = new GpuReadback(bufferDesc, StatisticsLatency);
+
+	uint tileCount = ((texDesc.Width + 7) / 8) * ((texDesc.Height + 7) / 8);
+
+	rcasTiles = new Buffer(StructuredBufferDesc<uint>(tileCount, true, false));
+	rcasTiles->CreateSRV({ .Format = DXGI_FORMAT_UNKNOWN,
+		.ViewDimension = D3D11_SRV_DIMENSION_BUFFER,
+		.Buffer = { .FirstElement = 0, .NumElements = tileCount } });
+	rcasTiles->CreateUAV({ .Format = DXGI_FORMAT_UNKNOWN,
+		.ViewDimension = D3D11_UAV_DIMENSION_BUFFER,
+		.Buffer = { .FirstElement = 0, .NumElements = tileCount, .Flags = D3D11_BUFFER_UAV_FLAG_APPEND } });
+
+	// Only ThreadGroupCountX is overwritten by CopyStructureCount
+	uint dispatchArgs[3] = { 0, 1, 1 };
+	D3D11_SUBRESOURCE_DATA argsData{ dispatchArgs, 0, 0 };
+	D3D11_BUFFER_DESC argsDesc{};
+	argsDesc.ByteWidth = sizeof(dispatchArgs);
+	argsDesc.Usage = D3D11_USAGE_DEFAULT;
+	argsDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
+
+	rcasIndirectArgs = new Buffer(argsDesc, &argsData);
+
+	sharedBytes = 0;
+	for (auto texture : { upscalingTexture, alphaMaskTexture, referenceTexture })
+		sharedBytes += MemoryTracker::GetSize(texture->desc);
+	for (auto buffer : { statisticsBuffer, rcasTiles, rcasIndirectArgs })
+		sharedBytes += MemoryTracker::GetSize(buffer->desc);
+	sharedBytes += statisticsReadback->GetSize();
+	MemoryTracker::GetSingleton()->Add(MemoryTracker::Category::kShared, sharedBytes);
+
+	staticDetector.Reset();
 }
 
 void Upscaling::DestroyUpscalingResources()
@@ -280,4 +1060,28 @@ void Upscaling::DestroyUpscalingResources()
 	alphaMaskTexture->uav = nullptr;
 	alphaMaskTexture->resource = nullptr;
 	delete alphaMaskTexture;
+
+	referenceTexture->srv = nullptr;
+	referenceTexture->resource = nullptr;
+	delete referenceTexture;
+
+	outputUAV = nullptr;
+	outputResource = nullptr;
+
+	delete statisticsBuffer;
+	statisticsBuffer = nullptr;
+
+	delete statisticsReadback;
+	statisticsReadback = nullptr;
+
+	delete rcasTiles;
+	rcasTiles = nullptr;
+
+	delete rcasIndirectArgs;
+	rcasIndirectArgs = nullptr;
+
+	MemoryTracker::GetSingleton()->Remove(MemoryTracker::Category::kShared, sharedBytes);
+	sharedBytes = 0;
+
+	staticDetector.Reset();
 }
@@ -1,10 +1,24 @@
 #pragma once
 
+#include <mutex>
+#include <optional>
 #include <shared_mutex>
 
 #include "Buffer.h"
+#include "CircuitBreaker.h"
+#include "CommandQueue.h"
 #include "FidelityFX.h"
+#include "FrameGeneration.h"
+#include "GpuReadback.h"
+#include "GpuTimer.h"
+#include "GroupSizeTuner.h"
+#include "MemoryPolicy.h"
+#include "MethodSelector.h"
+#include "Snapshot.h"
+#include "StaticDetector.h"
+#include "StereoViewports.h"
 #include "Streamline.h"
+#include "UpscalingSettings.h"
 
 class Upscaling : public RE::BSTEventSink<RE::MenuOpenCloseEvent>
 {
@@ -15,57 +29,175 @@ public:
 		return &singleton;
 	}
 
+	// Render thread only, set by whatever leaves the upscaler's history stale
 	bool reset = false;
 	float2 jitter = { 0, 0 };
 
-	virtual RE::BSEventNotifyControl ProcessEvent(const RE::MenuOpenCloseEvent* a_event, RE::BSTEventSource<RE::MenuOpenCloseEvent>*)
+	enum class Command
 	{
-		if (a_event->menuName == RE::LoadingMenu::MENU_NAME || 
-			a_event->menuName == RE::MapMenu::MENU_NAME ||
-			a_event->menuName == RE::LockpickingMenu::MENU_NAME ||
-			a_event->menuName == RE::MainMenu::MENU_NAME ||
-			a_event->menuName == RE::MistMenu::MENU_NAME)
-			reset = true;
-		return RE::BSEventNotifyControl::kContinue;
-	}
+		kMethodChanged,
+		kPresetChanged,
+		kResize,
+		kMenuBypassBegin,
+		kMenuBypassEnd
+	};
+
+	// Producers are serialised by commandLock so the queue only ever sees one writer
+	std::mutex commandLock;
+	CommandQueue<Command, 64> commands;
+	void PushCommand(Command a_command);
+	void ProcessCommands();
+
+	// Event thread only, names of listed menus that are open
+	std::vector<std::string> openBypassMenus;
+	bool anyBypassMenuOpen = false;
+
+	// Render thread only
+	bool menuOpen = false;
+	bool bypassed = false;
+
+	// Per backend, a tripped breaker bypasses the upscaler exactly like a menu does
+	CircuitBreaker fsrHealth;
+	CircuitBreaker dlssHealth;
+
+	virtual RE::BSEventNotifyControl ProcessEvent(const RE::MenuOpenCloseEvent* a_event, RE::BSTEventSource<RE::MenuOpenCloseEvent>*);
 
 	std::shared_mutex fileLock;
+	uint32_t iniFile = 0;
+	void RegisterINI();
 	void LoadINI();
 	void SaveINI();
 	void RefreshUI();
 
-	enum class UpscaleMethod
+	using UpscaleMethod = ::UpscaleMethod;
+	using SharpenKernel = ::SharpenKernel;
+	using Settings = UpscalingSettings;
+
+	// Worker thread, merges the keys present in a_text into settings
+	void ApplyINI(std::string_view a_text);
+
+	// Edited by the UI and INI under fileLock, never read by the render thread
+	Settings settings;
+	Settings publishedSettings;
+	Snapshot<Settings> settingsSnapshot;
+	void PublishSettings();
+
+	// Render thread copy, acquired once per frame
+	Settings frameSettings;
+	void AcquireSettings();
+
+	// Method picked by the user, with Auto enabled it is the best method Auto may choose
+	UpscaleMethod GetConfiguredMethod();
+	// Method used this frame, resolved once per frame by SelectMethod
+	UpscaleMethod GetUpscaleMethod() { return frameMethod; }
+	CircuitBreaker* GetHealth(UpscaleMethod a_method);
+
+	// Render thread only
+	UpscaleMethod frameMethod = UpscaleMethod::kTAA;
+	MethodSelector methodSelector;
+	// Tagged with the UpscaleMethod that ran
+	GpuTimer methodTimer;
+	bool autoActive = false;
+	void SelectMethod();
+
+	// Method the upscaling resources currently exist for, render thread only
+	UpscaleMethod resourceMethod = UpscaleMethod::kTAA;
+	bool resourcesDirty = true;
+	void CheckResources(UpscaleMethod a_method);
+
+	static constexpr uint MemoryInterval = 60;
+
+	// Drops frame generation and then the upscaler as the video memory budget runs out, render thread only
+	MemoryPolicy memoryPolicy;
+	// Copy of the policy's level for the UI
+	std::atomic<MemoryPolicy::Level> memoryLevel = MemoryPolicy::Level::kNormal;
+	void UpdateMemoryBudget();
+	bool UseFrameGeneration() { return frameSettings.frameGeneration && memoryPolicy.GetLevel() == MemoryPolicy::Level::kNormal; }
+
+	struct RCASCB
 	{
-		kTAA,
-		kFSR,
-		kDLSS
+		float sharpness;
+		uint screenSize[2];
+		float pad0;
 	};
 
-	struct Settings
+	struct RCASClassifyCB
 	{
-		uint upscaleMethod = (uint)UpscaleMethod::kDLSS;
-		uint upscaleMethodNoDLSS = (uint)UpscaleMethod::kFSR;
-		float sharpness = 0.5f;
-		uint dlssPreset = (uint)sl::DLSSPreset::ePresetE;
+		uint screenSize[2];
+		float contrastThreshold;
+		float pad0;
 	};
 
-	Settings settings;
+	ConstantBufferRing* constantBufferRing = nullptr;
+
+	// Whether the device runs min16float at 16 bits in compute shaders, queried once
+	std::optional<bool> halfPrecisionSupported;
+	bool UseHalfPrecision();
+
+	// Indexed by tiled, SharpenKernel, half precision and then GroupSizeTuner candidate, tiled always uses 8x8
+	ID3D11ComputeShader* rcasCS[2][2][2][GroupSizeTuner::Candidates.size()] = {};
+	ID3D11ComputeShader* rcasClassifyCS = nullptr;
+	ID3D11ComputeShader* GetRCASComputeShader(bool a_tiled, SharpenKernel a_kernel, uint a_groupSize = 0);
+	ID3D11ComputeShader* GetRCASClassifyCS();
+
+	// Sharpens high contrast tiles of a_input into upscalingTexture
+	void Sharpen(ID3D11ShaderResourceView* a_input);
 
-	UpscaleMethod GetUpscaleMethod();
+	// Game output texture and a UAV on it, null when it cannot be bound for unordered access
+	winrt::com_ptr<ID3D11Resource> outputResource;
+	winrt::com_ptr<ID3D11UnorderedAccessView> outputUAV;
+	ID3D11UnorderedAccessView* GetOutputUAV(ID3D11Resource* a_resource);
 
-	void CheckResources();
+	// Sharpens all of upscalingTexture directly into the output, replacing the copies around Sharpen
+	bool sharpenedToOutput = false;
+	void SharpenToOutput(ID3D11UnorderedAccessView* a_output);
 
-	ID3D11ComputeShader* rcasCS;
-	ID3D11ComputeShader* GetRCASComputeShader();
+	// Indexed by half precision and then GroupSizeTuner candidate
+	ID3D11ComputeShader* encodeTexturesCS[2][GroupSizeTuner::Candidates.size()] = {};
+	ID3D11ComputeShader* GetEncodeTexturesCS(uint a_groupSize);
 
-	ID3D11ComputeShader* encodeTexturesCS;
-	ID3D11ComputeShader* GetEncodeTexturesCS();
+	static constexpr uint JitterPhaseCount = 8;
 
 	void UpdateJitter();
 	void Upscale();
+	// Hands this frame's inputs and camera data to FrameCapture while it records
+	void Capture(ID3D11Resource* a_color);
+
+	struct StaticDetectionCB
+	{
+		float2 screenSize;
+		float pad0[2];
+	};
+
+	// Idle frame detection, the last output is reused while nothing on screen moves
+	StaticDetector staticDetector;
+	uint64_t frameIndex = 0;
+
+	ID3D11ComputeShader* motionStatisticsCS = nullptr;
+	ID3D11ComputeShader* colorStatisticsCS = nullptr;
+	ID3D11ComputeShader* GetStatisticsCS(bool a_compareColor);
+
+	static constexpr uint StatisticsLatency = 3;
+
+	Buffer* statisticsBuffer = nullptr;
+	// Tagged with whether colour was compared
+	GpuReadback* statisticsReadback = nullptr;
+
+	void DispatchStatistics(ID3D11ShaderResourceView* a_color);
+	bool ReadStatistics(StaticDetector::Statistics& a_statistics);
+
+	// Eyes within the textures below, configured with them
+	StereoViewports viewports;
 
 	Texture2D* upscalingTexture;
 	Texture2D* alphaMaskTexture;
+	Texture2D* referenceTexture;
+
+	Buffer* rcasTiles = nullptr;
+	Buffer* rcasIndirectArgs = nullptr;
+
+	// Size of everything CreateUpscalingResources allocates, added to MemoryTracker
+	uint64_t sharedBytes = 0;
 
 	void CreateUpscalingResources();
 	void DestroyUpscalingResources();
@@ -74,8 +206,11 @@ public:
 	{
 		static void thunk(RE::BSGraphics::State* a_state)
 		{
+			FrameGeneration::GetSingleton()->PresentHeld(FrameGeneration::Opportunity::kRenderStart);
 			func(a_state);
-			GetSingleton()->UpdateJitter();
+			auto singleton = GetSingleton();
+			singleton->ProcessCommands();
+			singleton->UpdateJitter();
 		}
 		static inline REL::Relocation<decltype(thunk)> func;
 	};
@@ -97,10 +232,15 @@ public:
 		static void thunk(RE::BSImagespaceShaderISTemporalAA* a_shader, RE::BSTriShape* a_null)
 		{
 			auto singleton = GetSingleton();
-			if (singleton->GetUpscaleMethod() != UpscaleMethod::kTAA && singleton->validTaaPass)
+			if (!singleton->bypassed && singleton->GetUpscaleMethod() != UpscaleMethod::kTAA && singleton->validTaaPass) {
 				singleton->Upscale();
-			else
+			} else {
+				// Auto needs the cost of the game's TAA to compare against
+				if (singleton->autoActive && !singleton->bypassed && singleton->validTaaPass)
+					singleton->methodTimer.Begin((uint)UpscaleMethod::kTAA);
 				func(a_shader, a_null);
+				singleton->methodTimer.End();
+			}
 			singleton->validTaaPass = false;
 		}
 		static inline REL::Relocation<decltype(thunk)> func;
@@ -108,10 +248,8 @@ public:
 
 	static void InstallHooks()
 	{
-		if (!REL::Module::IsVR()) {
-			stl::write_thunk_call<Main_UpdateJitter>(REL::RelocationID(75460, 77245).address() + REL::Relocate(0xE5, 0xE2, 0x104));
-			stl::write_thunk_call<TAA_BeginTechnique>(REL::RelocationID(100540, 107270).address() + REL::Relocate(0x3E9, 0x3EA, 0x448));
-			stl::write_thunk_call<TAA_EndTechnique>(REL::RelocationID(100540, 107270).address() + REL::Relocate(0x3F3, 0x3F4, 0x452));
-		}
+		stl::write_thunk_call<Main_UpdateJitter>(REL::RelocationID(75460, 77245).address() + REL::Relocate(0xE5, 0xE2, 0x104));
+		stl::write_thunk_call<TAA_BeginTechnique>(REL::RelocationID(100540, 107270).address() + REL::Relocate(0x3E9, 0x3EA, 0x448));
+		stl::write_thunk_call<TAA_EndTechnique>(REL::RelocationID(100540, 107270).address() + REL::Relocate(0x3F3, 0x3F4, 0x452));
 	}
 };
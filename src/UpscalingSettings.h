@@ -0,0 +1,67 @@
+#pragma once
+
+#include "FixedString.h"
+
+// Persisted settings of the upscaler. Free of the plugin's dependencies so SettingsSchema can be tested on its own.
+
+enum class UpscaleMethod
+{
+	kTAA,
+	kFSR,
+	kDLSS
+};
+
+enum class SharpenKernel
+{
+	kDirect,
+	kGroupshared
+};
+
+// Same values as sl::DLSSPreset
+enum class DLSSPreset
+{
+	kDefault,
+	kPresetA,
+	kPresetB,
+	kPresetC,
+	kPresetD,
+	kPresetE,
+	kPresetF
+};
+
+using MenuList = FixedString<512>;
+
+// Menus that cover the whole screen, while one is open the game's TAA runs instead of the upscaler. Same names as
+// the RE::<Menu>::MENU_NAME constants.
+inline constexpr MenuList DefaultBypassMenus{
+	{ "Loading Menu",
+		"MapMenu",
+		"Lockpicking Menu",
+		"Main Menu",
+		"Mist Menu",
+		"InventoryMenu",
+		"MagicMenu",
+		"StatsMenu",
+		"Journal Menu",
+		"Creation Club Menu",
+		"Mod Manager Menu",
+		"Credits Menu" },
+	','
+};
+
+struct UpscalingSettings
+{
+	uint upscaleMethod = (uint)UpscaleMethod::kDLSS;
+	uint upscaleMethodNoDLSS = (uint)UpscaleMethod::kFSR;
+	float sharpness = 0.5f;
+	uint dlssPreset = (uint)DLSSPreset::kPresetE;
+	bool menuBypass = true;
+	bool idleReuse = true;
+	uint sharpenKernel = (uint)SharpenKernel::kGroupshared;
+	bool halfPrecision = true;
+	bool autoMethod = false;
+	float autoBudget = 2.0f;
+	bool frameGeneration = false;
+	bool frameGenerationRenderStart = false;
+	MenuList bypassMenus = DefaultBypassMenus;
+};
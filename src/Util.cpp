@@ -1,6 +1,7 @@
 #include "Util.h"
 
 #include <d3dcompiler.h>
+#include <dxgi.h>
 
 namespace Util
 {
@@ -72,4 +73,41 @@ namespace Util
 		}
 		return shadowState->GetVRRuntimeData().cameraData.getEye(eyeIndex);
 	}
+
+	std::string GetAdapterKey(IDXGIAdapter* a_adapter, bool a_luid)
+	{
+		DXGI_ADAPTER_DESC desc{};
+		if (!a_adapter || FAILED(a_adapter->GetDesc(&desc)))
+			return "Unknown";
+
+		auto key = std::format("{:04X}-{:04X}", desc.VendorId, desc.DeviceId);
+
+		LARGE_INTEGER version{};
+		if (SUCCEEDED(a_adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &version)))
+			key += std::format("-{}.{}.{}.{}", HIWORD(version.HighPart), LOWORD(version.HighPart), HIWORD(version.LowPart), LOWORD(version.LowPart));
+
+		if (a_luid)
+			key += std::format("@{:08X}-{:08X}", (uint32_t)desc.AdapterLuid.HighPart, desc.AdapterLuid.LowPart);
+		return key;
+	}
+
+	std::string GetAdapterKey()
+	{
+		auto device = reinterpret_cast<ID3D11Device*>(RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder);
+
+		winrt::com_ptr<IDXGIDevice> dxgiDevice;
+		winrt::com_ptr<IDXGIAdapter> adapter;
+		if (FAILED(device->QueryInterface(IID_PPV_ARGS(dxgiDevice.put()))) || FAILED(dxgiDevice->GetAdapter(adapter.put())))
+			return "Unknown";
+		return GetAdapterKey(adapter.get());
+	}
+
+	std::string GetDefaultAdapterKey(bool a_luid)
+	{
+		winrt::com_ptr<IDXGIFactory1> factory;
+		winrt::com_ptr<IDXGIAdapter1> adapter;
+		if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(factory.put()))) || FAILED(factory->EnumAdapters1(0, adapter.put())))
+			return "Unknown";
+		return GetAdapterKey(adapter.get(), a_luid);
+	}
 }
\ No newline at end of file
@@ -9,4 +9,13 @@ namespace Util
 	RE::NiPoint3 GetEyePosition(int eyeIndex);
 
 	RE::BSGraphics::ViewData GetCameraData(int eyeIndex);
+
+	// Vendor, device and driver version of an adapter, e.g. 10DE-2684-32.0.15.6094. a_luid appends the LUID,
+	// e.g. @00000000-0000D2C4, which tells identical adapters apart but changes every boot.
+	std::string GetAdapterKey(IDXGIAdapter* a_adapter, bool a_luid = false);
+	// Key of the adapter the game's device was created on
+	std::string GetAdapterKey();
+	// Key of the adapter the game will pick by default, usable before the device exists. Only a guess with more than
+	// one adapter, the game may create its device on another.
+	std::string GetDefaultAdapterKey(bool a_luid = false);
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 
 #include <ENB/ENBSeriesAPI.h>
+#include <spdlog/async.h>
 
+#include "ConfigService.h"
+#include "GroupSizeTuner.h"
 #include "Hooks.h"
 #include "Upscaling.h"
 
@@ -30,9 +33,13 @@ void InitializeLog([[maybe_unused]] spdlog::level::level_enum a_level = spdlog::
 	const auto level = a_level;
 #endif
 
-	auto log = std::make_shared<spdlog::logger>("global log"s, std::move(sink));
+	// Messages are formatted on the calling thread and written by a single background thread, so the render thread
+	// never waits on the disk. If the queue ever fills the oldest messages are dropped rather than blocking.
+	spdlog::init_thread_pool(8192, 1);
+	auto log = std::make_shared<spdlog::async_logger>("global log"s, std::move(sink), spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
 	log->set_level(level);
-	log->flush_on(spdlog::level::info);
+	log->flush_on(spdlog::level::warn);
+	spdlog::flush_every(std::chrono::seconds(1));
 
 	spdlog::set_default_logger(std::move(log));
 	spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] [%t] [%s:%#] %v");
@@ -70,16 +77,18 @@ ENB_API::ENBSDKALT1001* g_ENB = nullptr;
 
 bool Load()
 {
-	if (REL::Module::IsVR()) {
-		logger::info("Skyrim VR detected, disabling all hooks and features");
-		return true;
-	}
+	if (REL::Module::IsVR())
+		logger::info("Skyrim VR detected, upscaling both eyes, FSR is unavailable");
 
 	g_ENB = reinterpret_cast<ENB_API::ENBSDKALT1001*>(ENB_API::RequestENBAPI(ENB_API::SDKVersion::V1001));
 
 	if (g_ENB) {
 		logger::info("Obtained ENB API, installing hooks");
 
+		Upscaling::GetSingleton()->RegisterINI();
+		GroupSizeTuner::GetSingleton()->RegisterINI();
+		ConfigService::GetSingleton()->Start();
+
 		g_ENB->SetCallbackFunction([](ENBCallbackType calltype) {
 			switch (calltype) {
 			case ENBCallbackType::ENBCallback_PostLoad:
@@ -88,10 +97,15 @@ bool Load()
 				break;
 			case ENBCallbackType::ENBCallback_PostReset:
 				Upscaling::GetSingleton()->RefreshUI();
+				Upscaling::GetSingleton()->PushCommand(Upscaling::Command::kResize);
 				break;
 			case ENBCallbackType::ENBCallback_PreSave:
 				Upscaling::GetSingleton()->SaveINI();
 				break;
+			case ENBCallbackType::ENBCallback_OnExit:
+				// Joins the worker while the process can still run it, so a save waiting out its delay is written
+				ConfigService::GetSingleton()->Stop();
+				break;
 			}
 		});
 
@@ -0,0 +1,172 @@
+#include "CapabilityCache.h"
+
+#include <fstream>
+#include <map>
+
+namespace
+{
+	constexpr auto IntegratedGPU = "8086-A780-31.0.101.4502@00000000-0000C1A0";
+	constexpr auto DiscreteGPU = "10DE-2684-32.0.15.6094@00000000-0000D2C4";
+	// The same discrete GPU after a reboot
+	constexpr auto DiscreteGPUNextBoot = "10DE-2684-32.0.15.6094@00000000-0000E3F1";
+
+	struct TempDirectory
+	{
+		std::filesystem::path path;
+
+		TempDirectory()
+		{
+			path = std::filesystem::temp_directory_path() / ("enbaa-capabilities-" + std::to_string(std::random_device{}()));
+			std::filesystem::create_directories(path);
+		}
+
+		~TempDirectory()
+		{
+			std::error_code ec;
+			std::filesystem::remove_all(path, ec);
+		}
+	};
+
+	// Stands in for sl.interposer.dll: loading it and running slInit costs startupCost, probing finds whether
+	// DLSS is supported on an adapter
+	struct StubInterposer
+	{
+		std::chrono::milliseconds startupCost{ 50 };
+		std::map<std::string, bool, std::less<>> supported;
+		uint loads = 0;
+	};
+
+	struct Launch
+	{
+		std::chrono::duration<double, std::milli> startup;
+		bool loaded = false;
+	};
+
+	// What InstallD3DHooks and the device creation hooks do, with a fresh cache per launch like a new process
+	Launch Start(const std::filesystem::path& a_path, StubInterposer& a_interposer, std::string_view a_expectedAdapter, std::string_view a_deviceAdapter)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		CapabilityCache cache;
+		cache.path = a_path;
+
+		auto probe = [&] {
+			std::this_thread::sleep_for(a_interposer.startupCost);
+			a_interposer.loads++;
+			cache.SetDLSS(a_deviceAdapter, a_interposer.supported.find(a_deviceAdapter)->second);
+		};
+
+		Launch launch;
+		if (cache.ShouldLoadStreamline(a_expectedAdapter) || cache.CheckDeviceAdapter(a_deviceAdapter)) {
+			probe();
+			launch.loaded = true;
+		}
+		launch.startup = std::chrono::steady_clock::now() - begin;
+		return launch;
+	}
+
+	std::string ReadFile(const std::filesystem::path& a_path)
+	{
+		std::ifstream stream{ a_path, std::ios::binary };
+		return { std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+	}
+}
+
+TEST_CASE("Capability cache format round trips", "[CapabilityCache]")
+{
+	CapabilityCache::Entries entries{ { IntegratedGPU, false }, { DiscreteGPU, true } };
+	auto text = CapabilityCache::Serialize(entries);
+	CHECK(text.ends_with("[DLSS]\n10DE-2684-32.0.15.6094@00000000-0000D2C4 = 1\n8086-A780-31.0.101.4502@00000000-0000C1A0 = 0\n"));
+
+	CapabilityCache::Entries parsed;
+	CapabilityCache::Parse(text + "[Other]\nKey = 1\n", parsed);
+	CHECK(parsed == entries);
+
+	CapabilityCache::Entries invalid;
+	CapabilityCache::Parse("[DLSS]\nA = yes\n = 1\nB = 2\n", invalid);
+	CHECK(invalid.empty());
+}
+
+TEST_CASE("Capability cache skips Streamline once DLSS is known to be unavailable", "[CapabilityCache]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "Capabilities.ini";
+	StubInterposer interposer;
+	interposer.supported = { { IntegratedGPU, false } };
+
+	auto cold = Start(path, interposer, IntegratedGPU, IntegratedGPU);
+	CHECK(cold.loaded);
+	CHECK(cold.startup >= interposer.startupCost);
+
+	auto warm = Start(path, interposer, IntegratedGPU, IntegratedGPU);
+	CHECK_FALSE(warm.loaded);
+	CHECK(warm.startup < cold.startup);
+	CHECK(interposer.loads == 1);
+}
+
+TEST_CASE("Capability cache keeps probing adapters that support DLSS", "[CapabilityCache]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "Capabilities.ini";
+	StubInterposer interposer;
+	interposer.supported = { { DiscreteGPU, true } };
+
+	CHECK(Start(path, interposer, DiscreteGPU, DiscreteGPU).loaded);
+	CHECK(Start(path, interposer, DiscreteGPU, DiscreteGPU).loaded);
+	CHECK(interposer.loads == 2);
+}
+
+TEST_CASE("Capability cache corrects a skip made for the wrong adapter", "[CapabilityCache]")
+{
+	// A hybrid laptop enumerates its integrated GPU first, but the game creates its device on the discrete one
+	TempDirectory directory;
+	auto path = directory.path / "Capabilities.ini";
+	StubInterposer interposer;
+	interposer.supported = { { IntegratedGPU, false }, { DiscreteGPU, true } };
+
+	// An earlier launch that really ran on the integrated GPU
+	Start(path, interposer, IntegratedGPU, IntegratedGPU);
+	REQUIRE(ReadFile(path).find(IntegratedGPU) != std::string::npos);
+
+	auto launch = Start(path, interposer, IntegratedGPU, DiscreteGPU);
+	CHECK(launch.loaded);
+	auto text = ReadFile(path);
+	CHECK(text.find(IntegratedGPU) == std::string::npos);
+	CHECK(text.find(std::string(DiscreteGPU) + " = 1") != std::string::npos);
+
+	// Later launches load Streamline up front instead of finding out at device creation
+	CapabilityCache cache;
+	cache.path = path;
+	CHECK(cache.ShouldLoadStreamline(IntegratedGPU));
+	CHECK_FALSE(cache.CheckDeviceAdapter(DiscreteGPU));
+}
+
+TEST_CASE("Capability cache replaces entries from earlier boots", "[CapabilityCache]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "Capabilities.ini";
+	StubInterposer interposer;
+	interposer.supported = { { DiscreteGPU, false }, { DiscreteGPUNextBoot, false }, { IntegratedGPU, false } };
+
+	Start(path, interposer, IntegratedGPU, IntegratedGPU);
+	Start(path, interposer, DiscreteGPU, DiscreteGPU);
+	// A new LUID misses the cache once
+	CHECK(Start(path, interposer, DiscreteGPUNextBoot, DiscreteGPUNextBoot).loaded);
+	CHECK_FALSE(Start(path, interposer, DiscreteGPUNextBoot, DiscreteGPUNextBoot).loaded);
+
+	auto text = ReadFile(path);
+	CHECK(text.find(DiscreteGPU) == std::string::npos);
+	CHECK(text.find(DiscreteGPUNextBoot) != std::string::npos);
+	CHECK(text.find(IntegratedGPU) != std::string::npos);
+}
+
+TEST_CASE("Capability cache startup timings", "[.benchmark]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "Capabilities.ini";
+	StubInterposer interposer;
+	interposer.supported = { { IntegratedGPU, false } };
+
+	auto cold = Start(path, interposer, IntegratedGPU, IntegratedGPU);
+	auto warm = Start(path, interposer, IntegratedGPU, IntegratedGPU);
+	std::printf("Stub interposer costing %lld ms: cold start %.2f ms, warm start %.3f ms\n", (long long)interposer.startupCost.count(), cold.startup.count(), warm.startup.count());
+}
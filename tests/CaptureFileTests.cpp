@@ -0,0 +1,141 @@
+#include "CaptureFile.h"
+
+#include <fstream>
+
+namespace
+{
+	constexpr uint32_t R32Float = 41;
+	constexpr uint32_t R8Unorm = 61;
+
+	struct TempFile
+	{
+		std::filesystem::path path = std::filesystem::temp_directory_path() / ("enbaa-capture-" + std::to_string(std::random_device{}()) + ".upcap");
+
+		~TempFile()
+		{
+			std::error_code ec;
+			std::filesystem::remove(path, ec);
+		}
+	};
+
+	std::vector<uint8_t> MakeDepth(uint32_t a_width, uint32_t a_height)
+	{
+		std::vector<uint8_t> data(a_width * a_height * sizeof(float));
+		auto depth = reinterpret_cast<float*>(data.data());
+		for (uint32_t y = 0; y < a_height; y++)
+			for (uint32_t x = 0; x < a_width; x++)
+				depth[y * a_width + x] = 0.5f + 0.001f * (float)x + 0.0005f * (float)y;
+		return data;
+	}
+
+	// One frame: its FrameInfo, a compressed depth plane and a raw mask
+	void WriteFrame(CaptureFile::Writer& a_writer, uint64_t a_frame)
+	{
+		CaptureFile::FrameInfo info{};
+		info.eyeCount = 1;
+		REQUIRE(a_writer.Write(CaptureFile::ChunkType::kFrame, a_frame, { reinterpret_cast<const uint8_t*>(&info), sizeof(info) }));
+		REQUIRE(a_writer.Write(CaptureFile::ChunkType::kDepth, a_frame, MakeDepth(128, 72), CaptureFile::Codec::kPlane, 128, 72, R32Float, 4));
+		std::vector<uint8_t> mask(128 * 72, 0);
+		REQUIRE(a_writer.Write(CaptureFile::ChunkType::kMask, a_frame, mask, CaptureFile::Codec::kNone, 128, 72, R8Unorm, 1));
+	}
+
+	std::vector<uint8_t> ReadBytes(const std::filesystem::path& a_path)
+	{
+		std::ifstream stream{ a_path, std::ios::binary };
+		return { std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+	}
+
+	void WriteBytes(const std::filesystem::path& a_path, std::span<const uint8_t> a_bytes)
+	{
+		std::ofstream stream{ a_path, std::ios::binary | std::ios::trunc };
+		stream.write(reinterpret_cast<const char*>(a_bytes.data()), (std::streamsize)a_bytes.size());
+	}
+}
+
+TEST_CASE("Capture files round trip", "[CaptureFile]")
+{
+	TempFile file;
+	CaptureFile::Writer writer;
+	REQUIRE(writer.Open(file.path));
+	WriteFrame(writer, 7);
+	WriteFrame(writer, 8);
+	REQUIRE(writer.Close());
+
+	CaptureFile::Reader reader;
+	REQUIRE(reader.Open(file.path));
+	CHECK(reader.HasIndex());
+	auto& chunks = reader.GetChunks();
+	REQUIRE(chunks.size() == 6);
+	CHECK(chunks[1].GetType() == CaptureFile::ChunkType::kDepth);
+	CHECK(chunks[1].header->codec == (uint32_t)CaptureFile::Codec::kPlane);
+	CHECK(chunks[5].header->frame == 8);
+
+	std::vector<uint8_t> depth;
+	REQUIRE(CaptureFile::Reader::Decode(chunks[4], depth));
+	CHECK(depth == MakeDepth(128, 72));
+}
+
+TEST_CASE("Capture files cut short are read by walking the chunks", "[CaptureFile]")
+{
+	TempFile file;
+	{
+		CaptureFile::Writer writer;
+		REQUIRE(writer.Open(file.path));
+		WriteFrame(writer, 1);
+		WriteFrame(writer, 2);
+		REQUIRE(writer.Close());
+	}
+	auto bytes = ReadBytes(file.path);
+
+	// The game crashed in the middle of the last chunk, before the index was written
+	CaptureFile::Reader indexed;
+	REQUIRE(indexed.Open(file.path));
+	auto lastOffset = (std::size_t)(reinterpret_cast<const uint8_t*>(indexed.GetChunks().back().header) - reinterpret_cast<const uint8_t*>(indexed.GetChunks().front().header));
+	indexed.Close();
+	bytes.resize(CaptureFile::ChunkAlignment + lastOffset + 100);
+	WriteBytes(file.path, bytes);
+
+	CaptureFile::Reader reader;
+	REQUIRE(reader.Open(file.path));
+	CHECK_FALSE(reader.HasIndex());
+	CHECK(reader.GetChunks().size() == 5);
+}
+
+TEST_CASE("Capture files with a corrupt index fall back to walking the chunks", "[CaptureFile]")
+{
+	TempFile file;
+	{
+		CaptureFile::Writer writer;
+		REQUIRE(writer.Open(file.path));
+		WriteFrame(writer, 1);
+		REQUIRE(writer.Close());
+	}
+	auto bytes = ReadBytes(file.path);
+	CaptureFile::Footer footer;
+	std::memcpy(&footer, bytes.data() + bytes.size() - sizeof(footer), sizeof(footer));
+	REQUIRE(footer.chunkCount == 3);
+
+	SECTION("A count whose size wraps around to the index's")
+	{
+		footer.chunkCount += 1ull << 61;
+		REQUIRE(footer.chunkCount * sizeof(CaptureFile::IndexEntry) == 3 * sizeof(CaptureFile::IndexEntry));
+	}
+
+	SECTION("A count larger than the index")
+	{
+		footer.chunkCount = 4;
+	}
+
+	SECTION("An index offset past the end")
+	{
+		footer.indexOffset = bytes.size() + CaptureFile::ChunkAlignment;
+	}
+
+	std::memcpy(bytes.data() + bytes.size() - sizeof(footer), &footer, sizeof(footer));
+	WriteBytes(file.path, bytes);
+
+	CaptureFile::Reader reader;
+	REQUIRE(reader.Open(file.path));
+	CHECK_FALSE(reader.HasIndex());
+	CHECK(reader.GetChunks().size() == 3);
+}
@@ -0,0 +1,110 @@
+#include "CircuitBreaker.h"
+
+namespace
+{
+	using State = CircuitBreaker::State;
+
+	// Stands in for slEvaluateFeature or ffxFsr3ContextDispatchUpscale, failing on the frames a_fails selects
+	struct FaultyBackend
+	{
+		std::function<bool(uint64_t)> fails;
+		std::vector<uint64_t> calls;
+
+		bool Upscale(uint64_t a_frame)
+		{
+			calls.push_back(a_frame);
+			return !fails(a_frame);
+		}
+	};
+
+	// What Upscaling does each frame: run the backend if the breaker allows it, otherwise the game's TAA
+	struct Simulation
+	{
+		CircuitBreaker breaker;
+		FaultyBackend backend;
+		uint64_t taaFrames = 0;
+		std::vector<uint64_t> trips;
+
+		void Run(uint64_t a_begin, uint64_t a_end)
+		{
+			for (auto frame = a_begin; frame < a_end; frame++) {
+				if (!breaker.Allow(frame)) {
+					taaFrames++;
+					continue;
+				}
+				auto tripsBefore = breaker.GetTrips();
+				breaker.Record(frame, backend.Upscale(frame));
+				if (breaker.GetTrips() != tripsBefore)
+					trips.push_back(frame);
+			}
+		}
+	};
+}
+
+TEST_CASE("CircuitBreaker ignores isolated failures", "[CircuitBreaker]")
+{
+	Simulation simulation;
+	// Two failures in a row at most
+	simulation.backend.fails = [](uint64_t a_frame) { return a_frame % 10 == 3 || a_frame % 10 == 4; };
+	simulation.Run(0, 1000);
+
+	CHECK(simulation.breaker.GetState() == State::kHealthy);
+	CHECK(simulation.breaker.GetTrips() == 0);
+	CHECK(simulation.taaFrames == 0);
+	CHECK(simulation.backend.calls.size() == 1000);
+}
+
+TEST_CASE("CircuitBreaker backs off exponentially while the backend keeps failing", "[CircuitBreaker]")
+{
+	Simulation simulation;
+	simulation.backend.fails = [](uint64_t a_frame) { return a_frame >= 100; };
+	simulation.Run(0, 40000);
+
+	auto& thresholds = simulation.breaker.thresholds;
+	REQUIRE(simulation.trips.size() >= 8);
+	// Tripped by the third failure, then by every single failed retry
+	CHECK(simulation.trips[0] == 100 + thresholds.failures - 1);
+	uint64_t backoff = thresholds.initialBackoff;
+	for (std::size_t i = 1; i < simulation.trips.size(); i++) {
+		CAPTURE(i);
+		CHECK(simulation.trips[i] - simulation.trips[i - 1] == backoff);
+		backoff = std::min(backoff * 2, thresholds.maxBackoff);
+	}
+
+	// Only the retries reach the backend once tripped
+	CHECK(simulation.backend.calls.size() == 100 + thresholds.failures + simulation.trips.size() - 1);
+	CHECK(simulation.breaker.GetState() == State::kTripped);
+	CHECK(simulation.breaker.GetRetryFrame() == simulation.trips.back() + thresholds.maxBackoff);
+}
+
+TEST_CASE("CircuitBreaker recovers after a transient fault", "[CircuitBreaker]")
+{
+	// A device reset breaks the backend for a few seconds
+	Simulation simulation;
+	simulation.backend.fails = [](uint64_t a_frame) { return a_frame >= 100 && a_frame < 500; };
+	simulation.Run(0, 1000);
+
+	// Trips at 102, retries fail at 222 and 462, the retry at 942 succeeds
+	CHECK(simulation.trips == std::vector<uint64_t>{ 102, 222, 462 });
+	CHECK(simulation.breaker.GetState() == State::kHealthy);
+	CHECK(simulation.taaFrames == 942 - 103 - 2);
+
+	// A successful retry resets the backoff, the next fault starts from the initial one again
+	simulation.backend.fails = [](uint64_t a_frame) { return a_frame >= 2000; };
+	simulation.Run(1000, 2200);
+	CHECK(simulation.trips == std::vector<uint64_t>{ 102, 222, 462, 2002, 2002 + simulation.breaker.thresholds.initialBackoff });
+}
+
+TEST_CASE("CircuitBreaker reset returns to healthy", "[CircuitBreaker]")
+{
+	Simulation simulation;
+	simulation.backend.fails = [](uint64_t) { return true; };
+	simulation.Run(0, 500);
+	REQUIRE(simulation.breaker.GetState() == State::kTripped);
+
+	// Changing the method resets the breaker, the backend runs again at once
+	simulation.breaker.Reset();
+	CHECK(simulation.breaker.GetState() == State::kHealthy);
+	CHECK(simulation.breaker.GetTrips() == 0);
+	CHECK(simulation.breaker.Allow(500));
+}
@@ -0,0 +1,95 @@
+#include "CommandQueue.h"
+
+TEST_CASE("CommandQueue fails to push when full and to pop when empty", "[CommandQueue]")
+{
+	CommandQueue<uint32_t, 4> queue;
+	uint32_t value = 0;
+	CHECK_FALSE(queue.Pop(value));
+
+	for (uint32_t i = 0; i < 4; i++)
+		CHECK(queue.Push(i));
+	CHECK_FALSE(queue.Push(4));
+
+	CHECK(queue.Pop(value));
+	CHECK(value == 0);
+	CHECK(queue.Push(4));
+
+	for (uint32_t i = 1; i <= 4; i++) {
+		CHECK(queue.Pop(value));
+		CHECK(value == i);
+	}
+	CHECK_FALSE(queue.Pop(value));
+}
+
+TEST_CASE("CommandQueue stress, one producer and one consumer", "[CommandQueue][stress]")
+{
+	constexpr uint64_t Items = 200000;
+	CommandQueue<uint64_t, 64> queue;
+	uint64_t rejected = 0;
+
+	std::thread producer([&] {
+		for (uint64_t i = 1; i <= Items;) {
+			if (queue.Push(i))
+				i++;
+			else {
+				rejected++;
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	uint64_t expected = 1, outOfOrder = 0, value = 0;
+	while (expected <= Items) {
+		if (!queue.Pop(value)) {
+			std::this_thread::yield();
+			continue;
+		}
+		outOfOrder += value != expected;
+		expected = value + 1;
+	}
+	producer.join();
+
+	CHECK(outOfOrder == 0);
+	CHECK_FALSE(queue.Pop(value));
+	// A small queue under a busy producer fills up, which is what exercises the wrap and the cached indices
+	CHECK(rejected > 0);
+}
+
+TEST_CASE("CommandQueue throughput", "[.benchmark]")
+{
+	CommandQueue<uint32_t, 64> queue;
+
+	BENCHMARK("push and pop 64 commands")
+	{
+		uint32_t sum = 0, value = 0;
+		for (uint32_t i = 0; i < 64; i++)
+			queue.Push(i);
+		while (queue.Pop(value))
+			sum += value;
+		return sum;
+	};
+
+	constexpr uint64_t Items = 1000000;
+	CommandQueue<uint64_t, 64> shared;
+	auto start = std::chrono::steady_clock::now();
+	std::thread producer([&] {
+		for (uint64_t i = 0; i < Items;) {
+			if (shared.Push(i))
+				i++;
+			else
+				std::this_thread::yield();
+		}
+	});
+
+	uint64_t received = 0, value = 0;
+	while (received < Items) {
+		if (shared.Pop(value))
+			received++;
+		else
+			std::this_thread::yield();
+	}
+	producer.join();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::printf("One producer and one consumer thread: %.1f M commands/s\n", Items / elapsed.count() / 1e6);
+}
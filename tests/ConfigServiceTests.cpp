@@ -0,0 +1,221 @@
+#include "ConfigService.h"
+
+#include <fstream>
+#include <mutex>
+
+namespace
+{
+	// A fresh directory under the system temp directory, removed again afterwards
+	struct TempDirectory
+	{
+		std::filesystem::path path;
+
+		TempDirectory()
+		{
+			path = std::filesystem::temp_directory_path() / ("enbaa-config-" + std::to_string(std::random_device{}()));
+			std::filesystem::create_directories(path);
+		}
+
+		~TempDirectory()
+		{
+			std::error_code ec;
+			std::filesystem::remove_all(path, ec);
+		}
+	};
+
+	struct Loads
+	{
+		std::mutex lock;
+		std::vector<std::string> texts;
+
+		ConfigService::LoadCallback Callback()
+		{
+			return [this](std::string_view a_text) {
+				std::lock_guard<std::mutex> lk(lock);
+				texts.emplace_back(a_text);
+			};
+		}
+
+		std::size_t Count()
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			return texts.size();
+		}
+
+		std::string Last()
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			return texts.empty() ? std::string{} : texts.back();
+		}
+	};
+
+	std::string ReadFile(const std::filesystem::path& a_path)
+	{
+		std::ifstream stream{ a_path, std::ios::binary };
+		return { std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+	}
+
+	void WriteFile(const std::filesystem::path& a_path, std::string_view a_text)
+	{
+		std::ofstream stream{ a_path, std::ios::binary | std::ios::trunc };
+		stream.write(a_text.data(), (std::streamsize)a_text.size());
+	}
+
+	template <class F>
+	bool WaitFor(F&& a_condition, std::chrono::milliseconds a_timeout = 5s)
+	{
+		auto deadline = std::chrono::steady_clock::now() + a_timeout;
+		while (!a_condition()) {
+			if (std::chrono::steady_clock::now() > deadline)
+				return false;
+			std::this_thread::sleep_for(5ms);
+		}
+		return true;
+	}
+}
+
+TEST_CASE("ConfigService loads on request", "[ConfigService]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "settings.ini";
+	WriteFile(path, "[ANTIALIASING]\nSharpness = 0.3\n");
+
+	ConfigService service;
+	Loads loads;
+	auto file = service.Register(path, loads.Callback(), false);
+	service.Start();
+	service.RequestLoad(file);
+
+	REQUIRE(WaitFor([&] { return loads.Count() == 1; }));
+	CHECK(loads.Last() == "[ANTIALIASING]\nSharpness = 0.3\n");
+	service.Stop();
+}
+
+TEST_CASE("ConfigService reports missing files as empty", "[ConfigService]")
+{
+	TempDirectory directory;
+
+	ConfigService service;
+	Loads loads;
+	auto file = service.Register(directory.path / "missing.ini", loads.Callback(), false);
+	service.Start();
+	service.RequestLoad(file);
+
+	REQUIRE(WaitFor([&] { return loads.Count() == 1; }));
+	CHECK(loads.Last().empty());
+	service.Stop();
+}
+
+TEST_CASE("ConfigService reports files too large to read as empty", "[ConfigService]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "large.ini";
+	WriteFile(path, std::string(ConfigService::MaxFileSize + 1, '#'));
+	auto exact = directory.path / "exact.ini";
+	WriteFile(exact, std::string(ConfigService::MaxFileSize - 1, '#') + "\n");
+
+	ConfigService service;
+	Loads loads;
+	auto file = service.Register(path, loads.Callback(), false);
+	auto exactFile = service.Register(exact, loads.Callback(), false);
+	service.Start();
+
+	service.RequestLoad(exactFile);
+	REQUIRE(WaitFor([&] { return loads.Count() == 1; }));
+	CHECK(loads.Last().size() == ConfigService::MaxFileSize);
+
+	service.RequestLoad(file);
+	REQUIRE(WaitFor([&] { return loads.Count() == 2; }));
+	CHECK(loads.Last().empty());
+	service.Stop();
+}
+
+TEST_CASE("ConfigService coalesces saves and replaces the file atomically", "[ConfigService]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "settings.ini";
+
+	ConfigService service;
+	service.saveDelay = 50ms;
+	Loads loads;
+	auto file = service.Register(path, loads.Callback(), true);
+	service.Start();
+
+	service.RequestSave(file, "first");
+	service.RequestSave(file, "second");
+	REQUIRE(WaitFor([&] { return ReadFile(path) == "second"; }));
+	CHECK_FALSE(std::filesystem::exists(directory.path / "settings.ini.tmp"));
+	service.Stop();
+
+	// Our own write is not mistaken for an external edit
+	CHECK(loads.Count() == 0);
+}
+
+TEST_CASE("ConfigService writes a pending save when stopped", "[ConfigService]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "settings.ini";
+
+	ConfigService service;
+	service.saveDelay = 1h;
+	Loads loads;
+	auto file = service.Register(path, loads.Callback(), false);
+	service.Start();
+
+	service.RequestSave(file, "saved on exit");
+	service.Stop();
+	CHECK(ReadFile(path) == "saved on exit");
+}
+
+TEST_CASE("ConfigService drops a load while a save is pending", "[ConfigService]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "settings.ini";
+	WriteFile(path, "old");
+
+	ConfigService service;
+	service.saveDelay = 1h;
+	Loads loads;
+	auto file = service.Register(path, loads.Callback(), true);
+	service.Start();
+
+	service.RequestSave(file, "new");
+	service.RequestLoad(file);
+	std::this_thread::sleep_for(50ms);
+	service.Stop();
+
+	CHECK(loads.Count() == 0);
+	CHECK(ReadFile(path) == "new");
+}
+
+TEST_CASE("ConfigService reloads files edited by something else", "[ConfigService]")
+{
+	TempDirectory directory;
+	auto path = directory.path / "settings.ini";
+	auto other = directory.path / "unwatched.ini";
+	WriteFile(path, "before");
+	WriteFile(other, "before");
+
+	ConfigService service;
+	service.pollInterval = 10ms;
+	Loads loads, otherLoads;
+	auto file = service.Register(path, loads.Callback(), true);
+	service.Register(other, otherLoads.Callback(), false);
+	service.Start();
+
+	service.RequestLoad(file);
+	REQUIRE(WaitFor([&] { return loads.Count() == 1; }));
+
+	// Some file systems only keep whole seconds, make sure the edit gets a newer time
+	WriteFile(path, "after");
+	WriteFile(other, "after");
+	std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + 2s);
+
+	REQUIRE(WaitFor([&] { return loads.Last() == "after"; }));
+	std::this_thread::sleep_for(50ms);
+	service.Stop();
+
+	// Parsed once per change, not once per poll
+	CHECK(loads.Count() == 2);
+	CHECK(otherLoads.Count() == 0);
+}
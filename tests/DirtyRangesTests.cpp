@@ -0,0 +1,144 @@
+#include "DirtyRanges.h"
+
+namespace
+{
+	// Large enough that uploading only the dirty ranges matters
+	constexpr uint32_t BufferSize = 1024 * 1024;
+
+	struct Pattern
+	{
+		const char* name;
+		std::vector<DirtyRanges::Range> writes;
+	};
+
+	std::vector<Pattern> GetPatterns()
+	{
+		std::vector<Pattern> patterns;
+		patterns.push_back({ "single element", { { 4096, 4096 + 64 } } });
+
+		Pattern scattered{ "scattered elements", {} };
+		std::mt19937 rng(1);
+		for (uint32_t i = 0; i < 64; i++) {
+			uint32_t begin = (rng() % (BufferSize / 64)) * 64;
+			scattered.writes.push_back({ begin, begin + 64 });
+		}
+		patterns.push_back(std::move(scattered));
+
+		Pattern block{ "contiguous block", {} };
+		for (uint32_t i = 0; i < 256; i++)
+			block.writes.push_back({ 8192 + i * 64, 8192 + (i + 1) * 64 });
+		patterns.push_back(std::move(block));
+
+		patterns.push_back({ "full rewrite", { { 0, BufferSize } } });
+		return patterns;
+	}
+}
+
+TEST_CASE("DirtyRanges ignores empty ranges", "[DirtyRanges]")
+{
+	DirtyRanges dirty;
+	dirty.Mark(64, 64);
+	dirty.Mark(128, 64);
+	CHECK(dirty.Empty());
+	CHECK(dirty.GetBytes() == 0);
+}
+
+TEST_CASE("DirtyRanges merges ranges within the gap", "[DirtyRanges]")
+{
+	DirtyRanges dirty(256);
+	dirty.Mark(0, 64);
+	dirty.Mark(64 + 256, 512);
+	REQUIRE(dirty.Get().size() == 1);
+	CHECK(dirty.Get()[0].begin == 0);
+	CHECK(dirty.Get()[0].end == 512);
+
+	dirty.Mark(512 + 257, 1024);
+	CHECK(dirty.Get().size() == 2);
+}
+
+TEST_CASE("DirtyRanges bridges several ranges at once", "[DirtyRanges]")
+{
+	DirtyRanges dirty(0);
+	dirty.Mark(0, 16);
+	dirty.Mark(32, 48);
+	dirty.Mark(64, 80);
+	CHECK(dirty.Get().size() == 3);
+
+	dirty.Mark(8, 72);
+	REQUIRE(dirty.Get().size() == 1);
+	CHECK(dirty.Get()[0].begin == 0);
+	CHECK(dirty.Get()[0].end == 80);
+	CHECK(dirty.GetBytes() == 80);
+}
+
+TEST_CASE("DirtyRanges with the exact gap never upload clean bytes", "[DirtyRanges]")
+{
+	// The GPU copy holds data the CPU shadow does not, as in a UAV-bound structured buffer
+	std::vector<uint8_t> gpu(1024, 0xAB);
+	std::vector<uint8_t> shadow(gpu.size(), 0);
+	DirtyRanges dirty(DirtyRanges::ExactGap);
+
+	auto write = [&](uint32_t a_begin, uint32_t a_end) {
+		std::fill(shadow.begin() + a_begin, shadow.begin() + a_end, 0x11);
+		dirty.Mark(a_begin, a_end);
+	};
+	write(100, 164);
+	write(264, 328);
+
+	for (auto& range : dirty.Get())
+		std::copy(shadow.begin() + range.begin, shadow.begin() + range.end, gpu.begin() + range.begin);
+
+	CHECK(dirty.Get().size() == 2);
+	CHECK(std::all_of(gpu.begin() + 164, gpu.begin() + 264, [](uint8_t a_byte) { return a_byte == 0xAB; }));
+	CHECK(std::all_of(gpu.begin() + 100, gpu.begin() + 164, [](uint8_t a_byte) { return a_byte == 0x11; }));
+	CHECK(std::all_of(gpu.begin() + 264, gpu.begin() + 328, [](uint8_t a_byte) { return a_byte == 0x11; }));
+	CHECK(gpu[99] == 0xAB);
+	CHECK(gpu[328] == 0xAB);
+}
+
+TEST_CASE("DirtyRanges stay sorted, disjoint and cover every write", "[DirtyRanges]")
+{
+	auto gap = GENERATE(0u, 64u, 256u);
+	std::mt19937 rng(gap);
+	DirtyRanges dirty(gap);
+	std::vector<bool> written(4096);
+
+	for (uint32_t i = 0; i < 200; i++) {
+		uint32_t begin = rng() % 4000;
+		uint32_t end = begin + 1 + rng() % 96;
+		dirty.Mark(begin, end);
+		for (auto b = begin; b < end; b++)
+			written[b] = true;
+	}
+
+	auto& ranges = dirty.Get();
+	for (std::size_t i = 1; i < ranges.size(); i++)
+		REQUIRE(ranges[i - 1].end + gap < ranges[i].begin);
+
+	for (uint32_t b = 0; b < written.size(); b++) {
+		if (!written[b])
+			continue;
+		bool covered = std::any_of(ranges.begin(), ranges.end(), [&](auto& a_range) { return a_range.begin <= b && b < a_range.end; });
+		REQUIRE(covered);
+	}
+}
+
+TEST_CASE("DirtyRanges bytes moved", "[.benchmark]")
+{
+	for (auto& pattern : GetPatterns()) {
+		DirtyRanges dirty;
+		for (auto& write : pattern.writes)
+			dirty.Mark(write.begin, write.end);
+		std::printf("%-20s %4zu copies %9llu bytes, %6.2f%% of a full upload\n", pattern.name, dirty.Get().size(),
+			(unsigned long long)dirty.GetBytes(), 100.0 * (double)dirty.GetBytes() / BufferSize);
+	}
+
+	auto patterns = GetPatterns();
+	BENCHMARK("mark scattered elements")
+	{
+		DirtyRanges dirty;
+		for (auto& write : patterns[1].writes)
+			dirty.Mark(write.begin, write.end);
+		return dirty.GetBytes();
+	};
+}
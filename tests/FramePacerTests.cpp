@@ -0,0 +1,176 @@
+#include "FramePacer.h"
+
+namespace
+{
+	// Synthetic presents of FrameGeneration at a steady real frame rate. Each real frame is simulated until render
+	// start, rendered until the game presents, and the generated frame goes out right after. Holding the real frame
+	// delays the game thread, so the wait is added to the frame.
+	struct PresentLoop
+	{
+		FramePacer pacer;
+		bool paced = true;
+		// False models the plugin's default, where the real frame always goes out from the game's present
+		bool renderStart = true;
+
+		// Milliseconds from the game's present to render start, and from render start to the next present
+		double simulation = 7.5;
+		double render = 9.2;
+		double jitter = 0.3;
+		// Frame generation and the copies around it
+		double generationCost = 0.2;
+
+		std::mt19937 rng{ 5 };
+		double time = 0.0;
+		double longestWait = 0.0;
+		double shortestWait = std::numeric_limits<double>::max();
+		uint deferred = 0;
+
+		double Noise() { return std::normal_distribution<double>(0.0, jitter)(rng); }
+
+		void PresentReal(double a_wait)
+		{
+			time += a_wait;
+			longestWait = std::max(longestWait, a_wait);
+			if (a_wait > 0.0)
+				shortestWait = std::min(shortestWait, a_wait);
+			pacer.OnRealPresent(time);
+		}
+
+		void Run(uint a_frames)
+		{
+			for (uint frame = 0; frame < a_frames; frame++) {
+				time += generationCost;
+				pacer.OnGeneratedPresent(time);
+
+				bool holding = true;
+				if (!paced) {
+					PresentReal(0.0);
+					holding = false;
+				} else if (auto decision = pacer.Decide(0, time, !renderStart); decision.present) {
+					PresentReal(decision.wait);
+					holding = false;
+				} else {
+					deferred++;
+				}
+
+				time += std::max(simulation + Noise(), 0.0);
+				if (renderStart) {
+					auto decision = pacer.Decide(1, time, true);
+					if (holding)
+						PresentReal(decision.wait);
+				}
+
+				time += std::max(render + Noise(), 0.0);
+			}
+		}
+
+		// Frame time standard deviation after the estimates settled
+		double Measure(uint a_frames)
+		{
+			Run(120);
+			pacer.ResetStatistics();
+			longestWait = 0.0;
+			Run(a_frames);
+			return std::sqrt(pacer.GetStatistics().variance);
+		}
+	};
+}
+
+TEST_CASE("FramePacer spaces real frames between generated ones", "[FramePacer]")
+{
+	PresentLoop unpaced;
+	unpaced.paced = false;
+	PresentLoop paced;
+
+	auto before = unpaced.Measure(2000);
+	auto after = paced.Measure(2000);
+	CAPTURE(before, after);
+
+	// Presenting the real frame right behind the generated one alternates frame times of almost zero and a full frame
+	CHECK(before > 7.0);
+	// Render start lands near the middle of the frame, the real frame goes out there
+	CHECK(after < 1.0);
+	CHECK(paced.deferred >= 2000);
+	CHECK(paced.pacer.GetStatistics().mean == Approx(paced.pacer.GetInterval() / 2).epsilon(0.05));
+	// The hold delays the game, costing at most maxWait per frame
+	CHECK(paced.longestWait <= paced.pacer.thresholds.maxWait);
+	CHECK(paced.pacer.GetInterval() <= unpaced.pacer.GetInterval() + paced.pacer.thresholds.maxWait);
+}
+
+TEST_CASE("FramePacer waits at the present when render start is too late", "[FramePacer]")
+{
+	// Render start close to the next generated frame, holding until then would be worse than presenting early
+	PresentLoop unpaced;
+	unpaced.paced = false;
+	unpaced.simulation = 15.0;
+	unpaced.render = 1.7;
+	PresentLoop paced = unpaced;
+	paced.paced = true;
+
+	auto before = unpaced.Measure(2000);
+	auto after = paced.Measure(2000);
+	CAPTURE(before, after);
+
+	CHECK(paced.deferred == 0);
+	CHECK(paced.longestWait <= paced.pacer.thresholds.maxWait);
+	// Bounded by maxWait, the real frame only moves that far towards the middle
+	CHECK(after == Approx(before - paced.pacer.thresholds.maxWait / 2).margin(0.1));
+}
+
+TEST_CASE("FramePacer waits at the present without render start", "[FramePacer]")
+{
+	PresentLoop unpaced;
+	unpaced.paced = false;
+	PresentLoop paced;
+	paced.renderStart = false;
+
+	auto before = unpaced.Measure(2000);
+	auto after = paced.Measure(2000);
+	CAPTURE(before, after, paced.shortestWait);
+
+	CHECK(paced.deferred == 0);
+	CHECK(after < before);
+	CHECK(paced.longestWait <= paced.pacer.thresholds.maxWait);
+	CHECK(paced.shortestWait >= paced.pacer.thresholds.minWait);
+}
+
+TEST_CASE("FramePacer skips waits a timer cannot hit", "[FramePacer]")
+{
+	FramePacer pacer;
+	pacer.OnGeneratedPresent(0.0);
+	pacer.Decide(0, 0.0, true);
+	pacer.OnRealPresent(0.0);
+	pacer.OnGeneratedPresent(10.0);
+
+	// Halfway is at 15 ms
+	CHECK(pacer.Decide(0, 14.0, true).wait == Approx(1.0));
+	CHECK(pacer.Decide(0, 14.6, true).wait == 0.0);
+}
+
+TEST_CASE("FramePacer restarts after a loading screen", "[FramePacer]")
+{
+	PresentLoop loop;
+	loop.Measure(500);
+	auto interval = loop.pacer.GetInterval();
+
+	// A hitch longer than maxInterval
+	loop.time += 2000.0;
+	loop.Run(1);
+	CHECK(loop.pacer.GetInterval() == 0.0);
+
+	loop.pacer.ResetStatistics();
+	loop.Run(2000);
+	CHECK(loop.pacer.GetInterval() == Approx(interval).epsilon(0.05));
+	CHECK(std::sqrt(loop.pacer.GetStatistics().variance) < 1.0);
+}
+
+TEST_CASE("FramePacer synthetic present trace", "[.benchmark]")
+{
+	// The frame time deviation reported with frame generation, render start near the middle of a 59 fps frame
+	PresentLoop unpaced;
+	unpaced.paced = false;
+	PresentLoop paced;
+	auto before = unpaced.Measure(10000);
+	auto after = paced.Measure(10000);
+	std::printf("Displayed frame time deviation: unpaced %.2f ms, paced %.2f ms (mean %.2f ms, longest wait %.2f ms)\n", before, after, paced.pacer.GetStatistics().mean, paced.longestWait);
+}
@@ -0,0 +1,148 @@
+#include "GroupSizes.h"
+
+namespace
+{
+	using GroupSizes::Candidates;
+	using GroupSizes::Search;
+
+	// Stands in for GPU timestamps: a fixed cost per candidate, jitter, and slow first dispatches while shaders compile
+	struct SimulatedTimings
+	{
+		std::array<float, Candidates.size()> milliseconds;
+		std::mt19937 rng{ 1 };
+		std::array<uint, Candidates.size()> dispatches{};
+
+		float Time(uint a_candidate)
+		{
+			std::normal_distribution<float> jitter(0.0f, 0.02f);
+			auto warmup = dispatches[a_candidate]++ < Search::WarmupSamples ? 5.0f : 0.0f;
+			// Occasional spikes from other work on the GPU
+			auto spike = std::uniform_int_distribution<int>(0, 9)(rng) == 0 ? 1.0f : 0.0f;
+			return milliseconds[a_candidate] + warmup + spike + jitter(rng);
+		}
+	};
+
+	uint RunSearch(SimulatedTimings& a_timings, uint& a_dispatches)
+	{
+		Search search;
+		for (a_dispatches = 0; !search.Done(); a_dispatches++) {
+			auto candidate = search.Next();
+			search.Record(candidate, a_timings.Time(candidate));
+		}
+		return search.Best();
+	}
+}
+
+TEST_CASE("Group size search picks the fastest candidate", "[GroupSizes]")
+{
+	auto fastest = GENERATE(0u, 1u, 2u, 3u);
+	SimulatedTimings timings;
+	timings.milliseconds = { 0.40f, 0.38f, 0.42f, 0.39f };
+	timings.milliseconds[fastest] = 0.30f;
+
+	uint dispatches;
+	CHECK(RunSearch(timings, dispatches) == fastest);
+	// Round-robin, every candidate gets exactly its warmup and samples
+	CHECK(dispatches == Candidates.size() * (Search::WarmupSamples + Search::SamplesPerCandidate));
+	for (auto count : timings.dispatches)
+		CHECK(count == Search::WarmupSamples + Search::SamplesPerCandidate);
+}
+
+TEST_CASE("Group size search keeps the default shape on ties", "[GroupSizes]")
+{
+	Search search;
+	while (!search.Done()) {
+		auto candidate = search.Next();
+		search.Record(candidate, 0.5f);
+	}
+	CHECK(search.Best() == 0);
+	// Once done it keeps returning the winner
+	CHECK(search.Next() == 0);
+}
+
+TEST_CASE("Group sizes parse", "[GroupSizes]")
+{
+	auto size = GroupSizes::ParseGroupSize("16x8");
+	REQUIRE(size);
+	CHECK(size->x == 16);
+	CHECK(size->y == 8);
+	CHECK(size->CountX(1921) == 121);
+	CHECK(size->CountY(1080) == 135);
+
+	CHECK_FALSE(GroupSizes::ParseGroupSize("16"));
+	CHECK_FALSE(GroupSizes::ParseGroupSize("x8"));
+	CHECK_FALSE(GroupSizes::ParseGroupSize("16x"));
+	CHECK_FALSE(GroupSizes::ParseGroupSize("axb"));
+}
+
+TEST_CASE("Group size results round trip per adapter", "[GroupSizes]")
+{
+	GroupSizes::Results results;
+	results[(uint)GroupSizes::Kernel::kEncodeTextures] = 1;
+	results[(uint)GroupSizes::Kernel::kRCASGroupshared] = 3;
+
+	auto text = GroupSizes::SerializeResults("", "10DE-2684-32.0.15.6094", results);
+	CHECK(text == "[10DE-2684-32.0.15.6094]\nEncodeTextures = 16x8\nRCASGroupshared = 32x4\n");
+
+	GroupSizes::Results parsed;
+	GroupSizes::ParseResults(text, "10DE-2684-32.0.15.6094", parsed);
+	CHECK(parsed == results);
+
+	GroupSizes::Results otherAdapter;
+	GroupSizes::ParseResults(text, "1002-744C-31.0.24027.1012", otherAdapter);
+	CHECK(otherAdapter == GroupSizes::Results{});
+}
+
+TEST_CASE("Group size results keep other adapters", "[GroupSizes]")
+{
+	auto existing =
+		"# Delete to tune again\n"
+		"[1002-744C-31.0.24027.1012]\n"
+		"EncodeTextures = 32x4\n"
+		"\n"
+		"[10DE-2684-32.0.15.6094]\n"
+		"EncodeTextures = 8x8\n"
+		"RCASDirect = 16x16\n"
+		"\n"
+		"[8086-A780-31.0.101.4502]\r\n"
+		"RCASDirect = 16x8";
+
+	GroupSizes::Results results;
+	results[(uint)GroupSizes::Kernel::kRCASDirect] = 2;
+	auto text = GroupSizes::SerializeResults(existing, "10DE-2684-32.0.15.6094", results);
+	CHECK(text ==
+		  "# Delete to tune again\n"
+		  "[1002-744C-31.0.24027.1012]\n"
+		  "EncodeTextures = 32x4\n"
+		  "\n"
+		  "[8086-A780-31.0.101.4502]\r\n"
+		  "RCASDirect = 16x8\n"
+		  "\n"
+		  "[10DE-2684-32.0.15.6094]\n"
+		  "RCASDirect = 16x16\n");
+
+	GroupSizes::Results amd, intel;
+	GroupSizes::ParseResults(text, "1002-744C-31.0.24027.1012", amd);
+	GroupSizes::ParseResults(text, "8086-A780-31.0.101.4502", intel);
+	CHECK(amd[(uint)GroupSizes::Kernel::kEncodeTextures] == 3u);
+	CHECK(intel[(uint)GroupSizes::Kernel::kRCASDirect] == 1u);
+}
+
+TEST_CASE("Group size results drop unknown entries", "[GroupSizes]")
+{
+	GroupSizes::Results results;
+	GroupSizes::ParseResults(
+		"[GPU]\n"
+		"; Shapes that are no longer candidates are tuned again\n"
+		"EncodeTextures = 4x4\n"
+		"RCASDirect = 16x16\n"
+		"Unknown = 8x8\n"
+		"RCASGroupshared\n"
+		"[GPU\n"
+		"RCASGroupshared = 16x8\n",
+		"GPU", results);
+
+	CHECK_FALSE(results[(uint)GroupSizes::Kernel::kEncodeTextures]);
+	CHECK(results[(uint)GroupSizes::Kernel::kRCASDirect] == 2u);
+	CHECK_FALSE(results[(uint)GroupSizes::Kernel::kRCASGroupshared]);
+}
@@ -0,0 +1,69 @@
+#include "INITokenizer.h"
+
+namespace
+{
+	struct Value
+	{
+		std::string section;
+		std::string key;
+		std::string value;
+
+		bool operator==(const Value&) const = default;
+	};
+
+	std::vector<Value> Tokenize(std::string_view a_text)
+	{
+		std::vector<Value> values;
+		Util::ForEachINIValue(a_text, [&](std::string_view a_section, std::string_view a_key, std::string_view a_value) {
+			values.push_back({ std::string(a_section), std::string(a_key), std::string(a_value) });
+		});
+		return values;
+	}
+}
+
+TEST_CASE("INI tokenizer trims sections, keys and values", "[INITokenizer]")
+{
+	auto values = Tokenize(
+		"Loose = 1\n"
+		"  [ ANTIALIASING ]  \r\n"
+		"\tSharpness= 0.5 \r\n"
+		"BypassMenus =Loading Menu, Map Menu\n"
+		"Empty =\n"
+		"[DLSS]\n"
+		"10DE-2684 = 1");
+
+	CHECK(values == std::vector<Value>{
+						{ "", "Loose", "1" },
+						{ "ANTIALIASING", "Sharpness", "0.5" },
+						{ "ANTIALIASING", "BypassMenus", "Loading Menu, Map Menu" },
+						{ "ANTIALIASING", "Empty", "" },
+						{ "DLSS", "10DE-2684", "1" } });
+}
+
+TEST_CASE("INI tokenizer skips comments and malformed lines", "[INITokenizer]")
+{
+	auto values = Tokenize(
+		"[A]\n"
+		"# Key = comment\n"
+		"; Key = comment\n"
+		"NoEquals\n"
+		"\n"
+		"Key = Value = More\n"
+		"[B\n"
+		"Orphan = 1\n");
+
+	REQUIRE(values.size() == 2);
+	CHECK(values[0] == Value{ "A", "Key", "Value = More" });
+	// A header missing its ] must not be mistaken for the section it names
+	CHECK(values[1].section != "B");
+	CHECK(values[1].section != "A");
+}
+
+TEST_CASE("INI sections", "[INITokenizer]")
+{
+	CHECK(Util::GetINISection("[ DLSS ]") == "DLSS"sv);
+	CHECK(Util::GetINISection("[]") == ""sv);
+	CHECK_FALSE(Util::GetINISection("[DLSS"));
+	CHECK_FALSE(Util::GetINISection("DLSS = 1"));
+	CHECK(Util::Trim(" \t\r\n") == "");
+}
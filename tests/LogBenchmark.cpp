@@ -0,0 +1,116 @@
+// Measures what a log call costs the calling thread with the plugin's logger setup from XSEPlugin.cpp: an async
+// logger with an 8192 entry queue and one writer thread, overrun_oldest, flushing on warnings and every second.
+// A synchronous logger flushing every message, as the plugin used before, is measured for comparison.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/async.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/spdlog.h>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr std::size_t QueueSize = 8192;
+static constexpr const char* Pattern = "[%Y-%m-%d %H:%M:%S.%e] [%l] [%t] [%s:%#] %v";
+
+struct Result
+{
+	double mean = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+};
+
+// Nanoseconds each call took on the calling thread
+static Result Summarize(std::vector<double>& a_times)
+{
+	std::sort(a_times.begin(), a_times.end());
+	Result result;
+	for (auto time : a_times)
+		result.mean += time;
+	result.mean /= (double)a_times.size();
+	result.p99 = a_times[a_times.size() * 99 / 100];
+	result.max = a_times.back();
+	return result;
+}
+
+// a_frames frames of a_perFrame messages, a_frameTime apart, like a failure logged from the render thread
+static Result Run(spdlog::logger& a_log, uint32_t a_frames, uint32_t a_perFrame, std::chrono::microseconds a_frameTime)
+{
+	std::vector<double> times;
+	times.reserve((std::size_t)a_frames * a_perFrame);
+
+	for (uint32_t frame = 0; frame < a_frames; frame++) {
+		auto frameStart = Clock::now();
+		for (uint32_t i = 0; i < a_perFrame; i++) {
+			auto begin = Clock::now();
+			a_log.info("Failed to evaluate DLSS on frame {} for eye {}, error {:#x}", frame, i % 2, 0x80004005u);
+			times.push_back(std::chrono::duration<double, std::nano>(Clock::now() - begin).count());
+		}
+		if (a_frameTime.count() > 0)
+			std::this_thread::sleep_until(frameStart + a_frameTime);
+	}
+	return Summarize(times);
+}
+
+static void Print(const char* a_logger, const char* a_load, const Result& a_result)
+{
+	std::printf("%-26s %-30s mean %8.0f ns  p99 %8.0f ns  max %10.0f ns\n", a_logger, a_load, a_result.mean, a_result.p99, a_result.max);
+}
+
+int main()
+{
+	auto path = std::filesystem::temp_directory_path() / ("enbaa-logbench-" + std::to_string(std::random_device{}()) + ".log");
+
+	struct Load
+	{
+		const char* name;
+		uint32_t frames;
+		uint32_t perFrame;
+		std::chrono::microseconds frameTime;
+	};
+	const Load loads[] = {
+		{ "1 per frame at 60 fps", 240, 1, std::chrono::microseconds(16667) },
+		{ "64 per frame at 60 fps", 120, 64, std::chrono::microseconds(16667) },
+		{ "burst of 100000", 1, 100000, std::chrono::microseconds(0) },
+	};
+
+	{
+		spdlog::init_thread_pool(QueueSize, 1);
+		auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(path.string(), true);
+		auto log = std::make_shared<spdlog::async_logger>("async", std::move(sink), spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
+		log->set_level(spdlog::level::trace);
+		log->set_pattern(Pattern);
+		log->flush_on(spdlog::level::warn);
+		spdlog::flush_every(std::chrono::seconds(1));
+
+		for (auto& load : loads) {
+			auto overruns = spdlog::thread_pool()->overrun_counter();
+			Print("async, overrun_oldest", load.name, Run(*log, load.frames, load.perFrame, load.frameTime));
+			std::printf("%-26s %-30s %zu messages dropped\n", "", "", spdlog::thread_pool()->overrun_counter() - overruns);
+		}
+		log->flush();
+		spdlog::shutdown();
+	}
+
+	{
+		auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(path.string(), true);
+		spdlog::logger log("sync", std::move(sink));
+		log.set_level(spdlog::level::trace);
+		log.set_pattern(Pattern);
+		log.flush_on(spdlog::level::info);
+
+		for (auto& load : loads)
+			Print("sync, flush every message", load.name, Run(log, load.frames, load.perFrame, load.frameTime));
+	}
+
+	std::error_code ec;
+	std::filesystem::remove(path, ec);
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include "LogLimiter.h"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Repeats reported in a " (suppressed N repeats)" suffix
+	uint64_t GetRepeats(const std::string& a_suffix)
+	{
+		if (a_suffix.empty())
+			return 0;
+		return std::stoull(a_suffix.substr(std::strlen(" (suppressed ")));
+	}
+}
+
+TEST_CASE("LogLimiter passes one message per interval", "[LogLimiter]")
+{
+	LogLimiter limiter(5s);
+	auto start = Clock::time_point(1h);
+
+	auto first = limiter.Check(start);
+	REQUIRE(first);
+	CHECK(first->empty());
+
+	// A failure every frame at 60 fps
+	for (int frame = 1; frame < 300; frame++)
+		CHECK_FALSE(limiter.Check(start + frame * 16ms));
+
+	auto next = limiter.Check(start + 5s);
+	REQUIRE(next);
+	CHECK(*next == " (suppressed 299 repeats)");
+
+	CHECK_FALSE(limiter.Check(start + 5s + 1ms));
+	// A quiet stretch longer than the interval, the message passes at once and reports the one repeat
+	auto later = limiter.Check(start + 1min);
+	REQUIRE(later);
+	CHECK(*later == " (suppressed 1 repeats)");
+	CHECK(limiter.Check(start + 2min) == ""s);
+}
+
+TEST_CASE("LogLimiter call sites are independent", "[LogLimiter]")
+{
+	LogLimiter frameToken(1s), constants(1s);
+	auto now = Clock::time_point(1h);
+	CHECK(frameToken.Check(now));
+	CHECK(constants.Check(now));
+	CHECK_FALSE(frameToken.Check(now));
+	CHECK_FALSE(constants.Check(now));
+}
+
+TEST_CASE("LogLimiter stress, every repeat is reported once", "[LogLimiter][stress]")
+{
+	constexpr uint Threads = 4;
+	constexpr uint CallsPerThread = 100000;
+
+	LogLimiter limiter(1ms);
+	std::atomic<uint64_t> passed = 0, reported = 0;
+
+	std::vector<std::thread> threads;
+	for (uint i = 0; i < Threads; i++) {
+		threads.emplace_back([&] {
+			for (uint call = 0; call < CallsPerThread; call++) {
+				if (auto suffix = limiter.Check()) {
+					passed++;
+					reported += GetRepeats(*suffix);
+				}
+				if (call % 64 == 0)
+					std::this_thread::yield();
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	// Flush whatever is still being counted
+	auto last = limiter.Check(Clock::now() + 1h);
+	REQUIRE(last);
+	reported += GetRepeats(*last);
+
+	CHECK(passed > 0);
+	CHECK(passed + reported == Threads * CallsPerThread);
+}
+
+TEST_CASE("LogLimiter throughput", "[.benchmark]")
+{
+	// The cost a persistent failure adds to every frame once it is suppressed
+	LogLimiter limiter(5s);
+	constexpr uint Calls = 10000000;
+	uint passed = 0;
+	auto begin = Clock::now();
+	for (uint call = 0; call < Calls; call++)
+		passed += limiter.Check().has_value();
+	std::chrono::duration<double, std::nano> elapsed = Clock::now() - begin;
+	std::printf("LogLimiter::Check: %.1f ns per call, %u of %u passed\n", elapsed.count() / Calls, passed, Calls);
+}
@@ -0,0 +1,146 @@
+#include "MemoryPolicy.h"
+
+namespace
+{
+	using Level = MemoryPolicy::Level;
+
+	constexpr uint64_t MB = 1ull << 20;
+
+	// A simulated DXGI budget, sampled every MemoryInterval frames like Upscaling does. The plugin holds its
+	// resources until the level it is at drops them, and takes them back when leaving that level.
+	struct Simulation
+	{
+		static constexpr uint64_t Interval = 60;
+
+		MemoryPolicy policy;
+		uint64_t budget = 8192 * MB;
+		// Everything but the plugin, the game and other applications
+		uint64_t otherUsage = 6000 * MB;
+		uint64_t frameGenerationBytes = 300 * MB;
+		uint64_t upscalingBytes = 400 * MB;
+
+		uint64_t frame = 0;
+		// Frames on which the level changed, and to what
+		std::vector<std::pair<uint64_t, Level>> changes;
+
+		MemoryPolicy::Sample GetSample() const
+		{
+			auto level = policy.GetLevel();
+			MemoryPolicy::Sample sample{ .budget = budget, .usage = otherUsage };
+			if (level < Level::kNoFrameGeneration)
+				sample.frameGenerationBytes = frameGenerationBytes;
+			if (level < Level::kTAAOnly)
+				sample.upscalingBytes = upscalingBytes;
+			sample.usage += sample.frameGenerationBytes + sample.upscalingBytes;
+			return sample;
+		}
+
+		void Run(uint64_t a_frames, const std::function<void(Simulation&)>& a_step = {})
+		{
+			for (auto end = frame + a_frames; frame < end; frame += Interval) {
+				if (a_step)
+					a_step(*this);
+				auto previous = policy.GetLevel();
+				if (policy.Update(frame, GetSample()) != previous)
+					changes.emplace_back(frame, policy.GetLevel());
+			}
+		}
+
+		// Headroom with everything the plugin holds at kNormal, negative when that would be over budget
+		void SetHeadroom(int64_t a_bytes) { otherUsage = budget - a_bytes - frameGenerationBytes - upscalingBytes; }
+	};
+}
+
+TEST_CASE("MemoryPolicy keeps everything while the budget allows", "[MemoryPolicy]")
+{
+	Simulation simulation;
+	simulation.Run(60000);
+	CHECK(simulation.policy.GetLevel() == Level::kNormal);
+	CHECK(simulation.changes.empty());
+
+	// An adapter without a budget
+	simulation.budget = 0;
+	simulation.otherUsage = 100000 * MB;
+	simulation.Run(60000);
+	CHECK(simulation.changes.empty());
+}
+
+TEST_CASE("MemoryPolicy drops only as much as the headroom needs", "[MemoryPolicy]")
+{
+	Simulation simulation;
+	simulation.Run(6000);
+
+	SECTION("Dropping frame generation is enough")
+	{
+		simulation.SetHeadroom(32 * MB);
+		simulation.Run(Simulation::Interval);
+		REQUIRE(simulation.changes.size() == 1);
+		CHECK(simulation.changes[0] == std::pair{ uint64_t(6000), Level::kNoFrameGeneration });
+	}
+
+	SECTION("Another application takes more than frame generation frees")
+	{
+		// Straight to TAA on the same sample instead of waiting minDwell at the first level
+		simulation.SetHeadroom(-400 * (int64_t)MB);
+		simulation.Run(Simulation::Interval);
+		REQUIRE(simulation.changes.size() == 1);
+		CHECK(simulation.changes[0] == std::pair{ uint64_t(6000), Level::kTAAOnly });
+	}
+
+	// What was dropped fits, nothing changes until the budget comes back
+	simulation.Run(60000);
+	CHECK(simulation.changes.size() == 1);
+}
+
+TEST_CASE("MemoryPolicy does not wait on a level that frees nothing", "[MemoryPolicy]")
+{
+	// Frame generation is off, so the first level has nothing to drop
+	Simulation simulation;
+	simulation.frameGenerationBytes = 0;
+	simulation.SetHeadroom(300 * MB);
+	simulation.Run(600);
+
+	// The headroom shrinks steadily, across the first threshold and then the second a few samples later
+	simulation.Run(1200, [](Simulation& a_simulation) { a_simulation.otherUsage += 20 * MB; });
+	REQUIRE(simulation.changes.size() == 2);
+	CHECK(simulation.changes[0].second == Level::kNoFrameGeneration);
+	CHECK(simulation.changes[1].second == Level::kTAAOnly);
+	CHECK(simulation.changes[1].first - simulation.changes[0].first < simulation.policy.thresholds.minDwell);
+}
+
+TEST_CASE("MemoryPolicy steps back up once the freed resources fit again", "[MemoryPolicy]")
+{
+	Simulation simulation;
+	auto& thresholds = simulation.policy.thresholds;
+	simulation.SetHeadroom(-400 * (int64_t)MB);
+	simulation.Run(600);
+	REQUIRE(simulation.policy.GetLevel() == Level::kTAAOnly);
+
+	// Room for the upscaling resources, but not for the hysteresis on top
+	auto restore = (int64_t)(thresholds.taaOnly + simulation.upscalingBytes) - (int64_t)(simulation.frameGenerationBytes + simulation.upscalingBytes);
+	simulation.SetHeadroom(restore + (int64_t)thresholds.hysteresis / 2);
+	simulation.Run(6000);
+	CHECK(simulation.policy.GetLevel() == Level::kTAAOnly);
+
+	simulation.SetHeadroom(4096 * MB);
+	simulation.Run(6000);
+	CHECK(simulation.policy.GetLevel() == Level::kNormal);
+	REQUIRE(simulation.changes.size() == 3);
+	// One level at a time, each after the previous change settled
+	CHECK(simulation.changes[1].second == Level::kNoFrameGeneration);
+	CHECK(simulation.changes[2].first - simulation.changes[1].first >= thresholds.minDwell);
+}
+
+TEST_CASE("MemoryPolicy does not oscillate around a threshold", "[MemoryPolicy]")
+{
+	// Other usage wanders by 200 MB around the point where frame generation no longer fits
+	Simulation simulation;
+	std::mt19937 rng{ 7 };
+	auto base = simulation.budget - simulation.policy.thresholds.noFrameGeneration - simulation.frameGenerationBytes - simulation.upscalingBytes;
+	simulation.Run(600000, [&](Simulation& a_simulation) {
+		a_simulation.otherUsage = base + (uint64_t)std::uniform_int_distribution<int64_t>(-100, 100)(rng) * MB;
+	});
+
+	CHECK(simulation.changes.size() == 1);
+	CHECK(simulation.policy.GetLevel() == Level::kNoFrameGeneration);
+}
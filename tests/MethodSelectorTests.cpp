@@ -0,0 +1,163 @@
+#include "MethodSelector.h"
+
+#include <deque>
+
+namespace
+{
+	using Method = MethodSelector::Method;
+
+	constexpr uint AllMethods = 0b111;
+
+	// GPU milliseconds of each method on a frame
+	using Trace = std::function<float(Method, uint64_t)>;
+
+	// Replays a timing trace through the selector the way Upscaling does: the method Update returns runs, and its
+	// GpuTimer result arrives a few frames later
+	struct Simulator
+	{
+		MethodSelector selector;
+		uint available = AllMethods;
+		Method ceiling = Method::kDLSS;
+		uint64_t latency = 4;
+		// Methods whose timings never arrive, like a failing backend's
+		uint lostTimings = 0;
+
+		std::mt19937 rng{ 3 };
+		float noise = 0.0f;
+
+		std::deque<std::tuple<uint64_t, Method, float>> inFlight;
+		std::array<uint64_t, MethodSelector::MethodCount> framesRun{};
+		// Frames on which the choice changed, and to what
+		std::vector<std::pair<uint64_t, Method>> switches;
+		uint64_t frame = 0;
+
+		void Run(uint64_t a_frames, const Trace& a_trace)
+		{
+			for (auto end = frame + a_frames; frame < end; frame++) {
+				auto previous = selector.GetChoice();
+				auto method = selector.Update(frame, available, ceiling);
+				if (frame > 0 && selector.GetChoice() != previous)
+					switches.emplace_back(frame, selector.GetChoice());
+				framesRun[(uint)method]++;
+
+				auto cost = a_trace(method, frame) + std::normal_distribution<float>(0.0f, noise)(rng);
+				if (!(lostTimings & (1u << (uint)method)))
+					inFlight.emplace_back(frame + latency, method, std::max(cost, 0.0f));
+
+				while (!inFlight.empty() && std::get<0>(inFlight.front()) <= frame) {
+					selector.Record(std::get<1>(inFlight.front()), std::get<2>(inFlight.front()));
+					inFlight.pop_front();
+				}
+			}
+		}
+	};
+
+	Trace Constant(float a_taa, float a_fsr, float a_dlss)
+	{
+		return [=](Method a_method, uint64_t) {
+			return a_method == Method::kDLSS ? a_dlss : a_method == Method::kFSR ? a_fsr : a_taa;
+		};
+	}
+}
+
+TEST_CASE("MethodSelector picks the best method within budget", "[MethodSelector]")
+{
+	Simulator simulator;
+	simulator.noise = 0.05f;
+
+	SECTION("Everything fits")
+	{
+		simulator.Run(2000, Constant(0.3f, 1.0f, 1.5f));
+		CHECK(simulator.selector.GetChoice() == Method::kDLSS);
+	}
+
+	SECTION("DLAA is over budget")
+	{
+		simulator.Run(2000, Constant(0.3f, 1.0f, 2.6f));
+		CHECK(simulator.selector.GetChoice() == Method::kFSR);
+	}
+
+	SECTION("Only TAA fits")
+	{
+		simulator.Run(2000, Constant(0.3f, 2.4f, 2.6f));
+		CHECK(simulator.selector.GetChoice() == Method::kTAA);
+	}
+
+	// Warm-up measured every method once and then settled
+	CHECK(simulator.selector.GetEstimate(Method::kTAA) >= 0.0f);
+	CHECK(simulator.selector.GetEstimate(Method::kFSR) >= 0.0f);
+	CHECK(simulator.selector.GetEstimate(Method::kDLSS) >= 0.0f);
+	CHECK_FALSE(simulator.selector.IsMeasuring());
+	CHECK(simulator.switches.size() <= 1);
+}
+
+TEST_CASE("MethodSelector respects availability and the ceiling", "[MethodSelector]")
+{
+	Simulator simulator;
+	auto trace = Constant(0.3f, 1.0f, 1.5f);
+
+	SECTION("No DLSS")
+	{
+		simulator.available = 0b011;
+	}
+
+	SECTION("Method set to FSR")
+	{
+		simulator.ceiling = Method::kFSR;
+	}
+
+	simulator.Run(2000, trace);
+	CHECK(simulator.selector.GetChoice() == Method::kFSR);
+	CHECK(simulator.framesRun[(uint)Method::kDLSS] == 0);
+	CHECK(simulator.selector.GetEstimate(Method::kDLSS) < 0.0f);
+}
+
+TEST_CASE("MethodSelector does not flip-flop around the budget", "[MethodSelector]")
+{
+	// DLAA's cost wanders between 1.6 and 2.2 ms, across the 2 ms budget, every few hundred frames
+	Simulator simulator;
+	simulator.noise = 0.1f;
+	simulator.Run(60000, [](Method a_method, uint64_t a_frame) {
+		if (a_method == Method::kDLSS)
+			return 1.9f + 0.3f * std::sin((float)a_frame * 0.01f);
+		return a_method == Method::kFSR ? 1.2f : 0.3f;
+	});
+
+	CHECK(simulator.switches.size() <= 2);
+	for (std::size_t i = 1; i < simulator.switches.size(); i++)
+		CHECK(simulator.switches[i].first - simulator.switches[i - 1].first >= simulator.selector.thresholds.minDwell);
+}
+
+TEST_CASE("MethodSelector follows the scene down and back up", "[MethodSelector]")
+{
+	Simulator simulator;
+	simulator.noise = 0.05f;
+	auto& thresholds = simulator.selector.thresholds;
+
+	simulator.Run(2000, Constant(0.3f, 1.0f, 1.5f));
+	REQUIRE(simulator.selector.GetChoice() == Method::kDLSS);
+
+	// A heavy scene, DLAA now clearly exceeds the budget
+	simulator.Run(3000, Constant(0.5f, 1.4f, 3.0f));
+	CHECK(simulator.selector.GetChoice() == Method::kFSR);
+	auto down = simulator.switches.back().first;
+	CHECK(down - 2000 < 300);
+
+	// Back to a light scene, DLAA is only tried again once its estimate is stale
+	simulator.Run(thresholds.resampleInterval + 2000, Constant(0.3f, 1.0f, 1.5f));
+	CHECK(simulator.selector.GetChoice() == Method::kDLSS);
+	CHECK(simulator.switches.back().first - down >= thresholds.resampleInterval);
+}
+
+TEST_CASE("MethodSelector treats missing timings as over budget", "[MethodSelector]")
+{
+	// A failing DLSS backend never produces a timing
+	Simulator simulator;
+	simulator.lostTimings = 1u << (uint)Method::kDLSS;
+	simulator.Run(2000, Constant(0.3f, 1.0f, 1.5f));
+
+	CHECK(simulator.selector.GetChoice() == Method::kFSR);
+	CHECK(simulator.selector.GetEstimate(Method::kDLSS) > simulator.selector.thresholds.budget);
+	// The measurement gives up instead of running DLSS indefinitely
+	CHECK(simulator.framesRun[(uint)Method::kDLSS] <= 4 * (simulator.selector.thresholds.discardSamples + simulator.selector.thresholds.samples) + 1);
+}
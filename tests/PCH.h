@@ -0,0 +1,66 @@
+#pragma once
+
+// Stands in for include/PCH.h, which needs CommonLibSSE, Windows and D3D
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if __has_include(<catch2/catch_all.hpp>)
+#	include <catch2/catch_all.hpp>
+#else
+#	include <catch2/catch.hpp>
+// Catch2 3 spells it Catch::Approx
+namespace Catch
+{
+	using Detail::Approx;
+}
+#endif
+
+using namespace std::literals;
+
+using uint = uint32_t;
+
+// Same layout as DirectX::SimpleMath::Matrix, which the plugin's PCH provides
+struct float4x4
+{
+	float _11 = 1, _12 = 0, _13 = 0, _14 = 0;
+	float _21 = 0, _22 = 1, _23 = 0, _24 = 0;
+	float _31 = 0, _32 = 0, _33 = 1, _34 = 0;
+	float _41 = 0, _42 = 0, _43 = 0, _44 = 1;
+};
+
+// CommonLibSSE's logger, messages are discarded
+namespace logger
+{
+	template <class... Args>
+	void trace(Args&&...)
+	{}
+	template <class... Args>
+	void debug(Args&&...)
+	{}
+	template <class... Args>
+	void info(Args&&...)
+	{}
+	template <class... Args>
+	void warn(Args&&...)
+	{}
+	template <class... Args>
+	void error(Args&&...)
+	{}
+	template <class... Args>
+	void critical(Args&&...)
+	{}
+}
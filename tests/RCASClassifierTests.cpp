@@ -0,0 +1,144 @@
+#include "RCASClassifier.h"
+
+namespace
+{
+	using RCASClassifier::Image;
+
+	Image MakeImage(uint32_t a_width, uint32_t a_height)
+	{
+		return { a_width, a_height, std::vector<float>((std::size_t)a_width * a_height * 3) };
+	}
+
+	template <class F>
+	Image MakeImage(uint32_t a_width, uint32_t a_height, F&& a_texel)
+	{
+		auto image = MakeImage(a_width, a_height);
+		for (uint32_t y = 0; y < a_height; y++) {
+			for (uint32_t x = 0; x < a_width; x++) {
+				auto rgb = a_texel(x, y);
+				std::copy(rgb.begin(), rgb.end(), image.rgb.begin() + ((std::size_t)y * a_width + x) * 3);
+			}
+		}
+		return image;
+	}
+
+	// Largest change RCAS makes to any texel of the tiles the classifier skips
+	float GetLargestSkippedChange(const Image& a_image, float a_sharpness)
+	{
+		auto threshold = RCASClassifier::GetSkipThreshold(a_sharpness);
+		float largest = 0.0f;
+		for (uint32_t tileY = 0; tileY * RCASClassifier::TileSize < a_image.height; tileY++) {
+			for (uint32_t tileX = 0; tileX * RCASClassifier::TileSize < a_image.width; tileX++) {
+				if (RCASClassifier::IsSharpened(a_image, tileX, tileY, threshold))
+					continue;
+				for (uint32_t y = tileY * RCASClassifier::TileSize; y < std::min((tileY + 1) * RCASClassifier::TileSize, a_image.height); y++) {
+					for (uint32_t x = tileX * RCASClassifier::TileSize; x < std::min((tileX + 1) * RCASClassifier::TileSize, a_image.width); x++) {
+						auto output = RCASClassifier::Filter(a_image, x, y, a_sharpness);
+						auto input = a_image.Load(x, y);
+						for (int c = 0; c < 3; c++)
+							largest = std::max(largest, std::abs(output[c] - input[c]));
+					}
+				}
+			}
+		}
+		return largest;
+	}
+
+	float GetSkippedFraction(const Image& a_image, float a_sharpness)
+	{
+		auto threshold = RCASClassifier::GetSkipThreshold(a_sharpness);
+		uint32_t tiles = 0, skipped = 0;
+		for (uint32_t tileY = 0; tileY * RCASClassifier::TileSize < a_image.height; tileY++) {
+			for (uint32_t tileX = 0; tileX * RCASClassifier::TileSize < a_image.width; tileX++) {
+				tiles++;
+				skipped += !RCASClassifier::IsSharpened(a_image, tileX, tileY, threshold);
+			}
+		}
+		return (float)skipped / (float)tiles;
+	}
+
+	// Sky gradient, flat fog and textured ground, the kinds of areas the classifier is meant to find
+	Image MakeScene(uint32_t a_width, uint32_t a_height)
+	{
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<float> grain(-1.0f, 1.0f);
+		return MakeImage(a_width, a_height, [&](uint32_t a_x, uint32_t a_y) {
+			auto v = (float)a_y / (float)a_height;
+			if (v < 0.4f)
+				return std::array<float, 3>{ 0.35f + v * 0.2f, 0.5f + v * 0.2f, 0.8f };
+			if (v < 0.55f)
+				return std::array<float, 3>{ 0.6f, 0.62f, 0.65f };
+			auto texture = 0.3f + 0.1f * std::sin((float)a_x * 0.7f) * std::cos((float)a_y * 0.3f) + 0.02f * grain(rng);
+			return std::array<float, 3>{ texture, texture * 0.9f, texture * 0.7f };
+		});
+	}
+}
+
+TEST_CASE("RCAS skip threshold follows sharpness", "[RCASClassifier]")
+{
+	CHECK(RCASClassifier::GetSkipThreshold(0.0f) == std::numeric_limits<float>::max());
+	CHECK(RCASClassifier::GetSkipThreshold(0.25f) > RCASClassifier::GetSkipThreshold(0.5f));
+	CHECK(RCASClassifier::GetSkipThreshold(0.5f) > RCASClassifier::GetSkipThreshold(1.0f));
+	// Full sharpness allows a lobe of -0.1875, so a range moves a texel by up to three times itself
+	CHECK(RCASClassifier::GetSkipThreshold(1.0f) == Catch::Approx(RCASClassifier::MaxSkippedChange / 3.0f));
+}
+
+TEST_CASE("RCAS changes skipped tiles by less than half an 8-bit step", "[RCASClassifier]")
+{
+	auto sharpness = GENERATE(0.1f, 0.5f, 0.8f, 1.0f);
+	auto threshold = RCASClassifier::GetSkipThreshold(sharpness);
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// Noise just under and over the threshold around several levels, including ones close to the limiter's clip points
+	for (auto amplitude : { 0.5f, 0.99f, 1.01f, 2.0f }) {
+		for (auto level : { 0.0f, 0.02f, 0.5f, 0.98f }) {
+			auto image = MakeImage(37, 29, [&](uint32_t, uint32_t) {
+				std::array<float, 3> rgb;
+				for (auto& c : rgb)
+					c = std::clamp(level + unit(rng) * amplitude * threshold, 0.0f, 1.0f);
+				return rgb;
+			});
+			CHECK(GetLargestSkippedChange(image, sharpness) < RCASClassifier::MaxSkippedChange);
+		}
+	}
+
+	// Single spikes, the worst case for the bound
+	auto spikes = MakeImage(40, 40, [&](uint32_t a_x, uint32_t a_y) {
+		float value = (a_x % 5 == 2 && a_y % 7 == 3) ? 0.5f + threshold * 0.999f : 0.5f;
+		return std::array<float, 3>{ value, value, value };
+	});
+	CHECK(GetLargestSkippedChange(spikes, sharpness) < RCASClassifier::MaxSkippedChange);
+
+	CHECK(GetLargestSkippedChange(MakeScene(160, 90), sharpness) < RCASClassifier::MaxSkippedChange);
+}
+
+TEST_CASE("RCAS classifier sees hue edges that keep luma", "[RCASClassifier]")
+{
+	// Red against green at the same RCAS luma, a luma range would call this tile flat
+	auto image = MakeImage(8, 8, [](uint32_t a_x, uint32_t) {
+		return a_x < 4 ? std::array<float, 3>{ 0.8f, 0.2f, 0.0f } : std::array<float, 3>{ 0.0f, 0.6f, 0.0f };
+	});
+	CHECK(RCASClassifier::IsSharpened(image, 0, 0, RCASClassifier::GetSkipThreshold(1.0f)));
+	CHECK(GetLargestSkippedChange(image, 1.0f) == 0.0f);
+}
+
+TEST_CASE("RCAS leaves flat borders alone", "[RCASClassifier]")
+{
+	// Taps past the edge repeat the edge texel, reading zeros instead would darken the border of a flat image
+	auto image = MakeImage(13, 11, [](uint32_t, uint32_t) { return std::array<float, 3>{ 0.7f, 0.7f, 0.7f }; });
+	CHECK_FALSE(RCASClassifier::IsSharpened(image, 1, 1, RCASClassifier::GetSkipThreshold(1.0f)));
+	for (uint32_t y = 0; y < image.height; y++) {
+		for (uint32_t x = 0; x < image.width; x++)
+			CHECK(RCASClassifier::Filter(image, x, y, 1.0f)[1] == Catch::Approx(0.7f));
+	}
+}
+
+TEST_CASE("RCAS skipped tile fraction", "[.benchmark]")
+{
+	auto scene = MakeScene(1920, 1080);
+	for (auto sharpness : { 0.25f, 0.5f, 0.75f, 1.0f }) {
+		std::printf("sharpness %.2f: threshold %.5f, %.1f%% of tiles skipped, largest skipped change %.3f/255\n", sharpness,
+			RCASClassifier::GetSkipThreshold(sharpness), 100.0f * GetSkippedFraction(scene, sharpness), GetLargestSkippedChange(scene, sharpness) * 255.0f);
+	}
+}
@@ -0,0 +1,187 @@
+#include "RCASClassifier.h"
+
+// Emulates the HALF variants of RCAS.hlsl and EncodeTexturesCS.hlsl by rounding every min16float result to binary16,
+// the lowest precision a driver may run them at, and bounds their error against the float kernels.
+namespace
+{
+	using RCASClassifier::Image;
+
+	// Nearest binary16 value, ties to even, including subnormals and overflow to infinity
+	float Half(float a_value)
+	{
+		if (!std::isfinite(a_value) || a_value == 0.0f)
+			return a_value;
+		auto magnitude = std::abs(a_value);
+		if (magnitude >= 65520.0f)
+			return std::copysign(std::numeric_limits<float>::infinity(), a_value);
+		int exponent;
+		std::frexp(magnitude, &exponent);
+		auto step = std::ldexp(1.0f, std::max(exponent - 11, -24));
+		return std::copysign(std::nearbyint(magnitude / step) * step, a_value);
+	}
+
+	using Half3 = std::array<float, 3>;
+
+	Half3 Load(const Image& a_image, int64_t a_x, int64_t a_y)
+	{
+		auto texel = a_image.Load(a_x, a_y);
+		return { Half(texel[0]), Half(texel[1]), Half(texel[2]) };
+	}
+
+	float Luma(const Half3& a_rgb)
+	{
+		return Half(Half(Half(a_rgb[0] * 0.5f) + a_rgb[1]) + Half(a_rgb[2] * 0.5f));
+	}
+
+	// RCASFilter with real = min16float. a_floatLimiter keeps hitMin, hitMax, the lobe and the resolve including the
+	// sum of the taps in float as the shader does, otherwise everything is 16-bit like the first version of the variant.
+	Half3 FilterHalf(const Image& a_image, uint32_t a_x, uint32_t a_y, float a_sharpness, bool a_floatLimiter)
+	{
+		auto b = Load(a_image, a_x, (int64_t)a_y - 1);
+		auto d = Load(a_image, (int64_t)a_x - 1, a_y);
+		auto e = Load(a_image, a_x, a_y);
+		auto f = Load(a_image, (int64_t)a_x + 1, a_y);
+		auto h = Load(a_image, a_x, (int64_t)a_y + 1);
+		float bL = Luma(b), dL = Luma(d), eL = Luma(e), fL = Luma(f), hL = Luma(h);
+
+		auto nz = Half(Half(Half(Half(Half(bL + dL) + fL) + hL) * 0.25f) - eL);
+		auto range = Half(std::max({ bL, dL, eL, fL, hL }) - std::min({ bL, dL, eL, fL, hL }));
+		auto ratio = Half(std::abs(nz) * Half(1.0f / range));
+		nz = std::isnan(ratio) ? 0.0f : std::clamp(ratio, 0.0f, 1.0f);
+		nz = Half(Half(-0.5f * nz) + 1.0f);
+
+		auto q = [&](float a_value) { return a_floatLimiter ? a_value : Half(a_value); };
+
+		auto lobeMax = -std::numeric_limits<float>::infinity();
+		Half3 sum;
+		for (int c = 0; c < 3; c++) {
+			auto minC = std::min({ b[c], d[c], f[c], h[c] });
+			auto maxC = std::max({ b[c], d[c], f[c], h[c] });
+			auto hitMin = q(minC * q(1.0f / q(4.0f * maxC)));
+			auto hitMax = q(q(1.0f - maxC) * q(1.0f / q(4.0f * minC - 4.0f)));
+			lobeMax = std::fmax(lobeMax, std::fmax(-hitMin, hitMax));
+			sum[c] = q(q(q(b[c] + d[c]) + f[c]) + h[c]);
+		}
+		auto lobe = q(q(std::fmax(-RCASClassifier::MaxLobe, std::fmin(lobeMax, 0.0f)) * (a_floatLimiter ? a_sharpness : Half(a_sharpness))) * nz);
+
+		auto rcpL = q(1.0f / q(4.0f * lobe + 1.0f));
+		Half3 output;
+		for (int c = 0; c < 3; c++)
+			output[c] = Half(q(q(sum[c] * lobe) + e[c]) * rcpL);
+		return output;
+	}
+
+	struct Error
+	{
+		float largest = 0.0f;
+		double total = 0.0;
+		uint64_t count = 0;
+		// Texels whose R8G8B8A8_UNORM output differs from the float kernel's
+		uint64_t stepsOff = 0;
+
+		void Add(float a_half, float a_reference)
+		{
+			auto error = std::abs(a_half - a_reference);
+			largest = std::max(largest, error);
+			total += error;
+			count++;
+			stepsOff += std::lround(std::clamp(a_half, 0.0f, 1.0f) * 255.0f) != std::lround(std::clamp(a_reference, 0.0f, 1.0f) * 255.0f);
+		}
+
+		float Mean() const { return count ? (float)(total / (double)count) : 0.0f; }
+	};
+
+	// Frames of 8-bit content, the upscaled image RCAS sharpens is stored at that precision
+	std::vector<Image> MakeCorpus()
+	{
+		std::vector<Image> corpus;
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		auto add = [&](auto&& a_texel) {
+			Image image{ 96, 64, std::vector<float>(96 * 64 * 3) };
+			for (uint32_t y = 0; y < image.height; y++) {
+				for (uint32_t x = 0; x < image.width; x++) {
+					for (int c = 0; c < 3; c++)
+						image.rgb[((std::size_t)y * image.width + x) * 3 + c] = std::round(std::clamp(a_texel(x, y, c), 0.0f, 1.0f) * 255.0f) / 255.0f;
+				}
+			}
+			corpus.push_back(std::move(image));
+		};
+
+		add([&](uint32_t, uint32_t, int) { return unit(rng); });
+		add([&](uint32_t a_x, uint32_t a_y, int a_c) { return 0.5f + 0.4f * std::sin((float)a_x * 0.2f + (float)a_c) * std::cos((float)a_y * 0.15f); });
+		add([&](uint32_t a_x, uint32_t a_y, int) { return ((a_x / 6 + a_y / 6) % 2) ? 0.95f : 0.05f; });
+		// Dark and bright areas, near the limiter's clip points
+		add([&](uint32_t, uint32_t a_y, int) { return (a_y < 32 ? 0.02f : 0.97f) + (unit(rng) - 0.5f) * 0.04f; });
+		add([&](uint32_t a_x, uint32_t a_y, int a_c) { return (float)((a_x + a_y * 3 + a_c * 50) % 256) / 255.0f; });
+		return corpus;
+	}
+
+	Error Measure(const std::vector<Image>& a_corpus, float a_sharpness, bool a_floatLimiter)
+	{
+		Error error;
+		for (auto& image : a_corpus) {
+			for (uint32_t y = 0; y < image.height; y++) {
+				for (uint32_t x = 0; x < image.width; x++) {
+					auto reference = RCASClassifier::Filter(image, x, y, a_sharpness);
+					auto half = FilterHalf(image, x, y, a_sharpness, a_floatLimiter);
+					for (int c = 0; c < 3; c++)
+						error.Add(half[c], reference[c]);
+				}
+			}
+		}
+		return error;
+	}
+}
+
+TEST_CASE("Half rounding matches binary16", "[RCASHalf]")
+{
+	CHECK(Half(1.0f) == 1.0f);
+	CHECK(Half(1.0f + 1.0f / 4096.0f) == 1.0f);
+	CHECK(Half(1.0f + 3.0f / 2048.0f) == 1.0f + 2.0f / 1024.0f);
+	CHECK(Half(65504.0f) == 65504.0f);
+	CHECK(std::isinf(Half(70000.0f)));
+	CHECK(Half(std::ldexp(1.0f, -24)) == std::ldexp(1.0f, -24));
+	CHECK(Half(std::ldexp(1.0f, -26)) == 0.0f);
+}
+
+TEST_CASE("Half precision RCAS stays within an output step of float", "[RCASHalf]")
+{
+	static const auto corpus = MakeCorpus();
+	auto sharpness = GENERATE(0.25f, 0.5f, 1.0f);
+	auto error = Measure(corpus, sharpness, true);
+	CAPTURE(sharpness, error.largest * 255.0f, error.Mean() * 255.0f, error.stepsOff);
+
+	CHECK(error.largest < 1.0f / 255.0f);
+	CHECK(error.Mean() < 0.1f / 255.0f);
+	// Rounding to 8 bits only differs where the float result sits next to a rounding boundary
+	CHECK(error.stepsOff < error.count / 20);
+}
+
+TEST_CASE("Half precision mask encode matches float", "[RCASHalf]")
+{
+	// EncodeTexturesCS: alphaMask = lerp(taaMask.x * 0.5, 1.0, taaMask.y), for every 8-bit input pair
+	float largest = 0.0f;
+	for (int x = 0; x < 256; x++) {
+		for (int y = 0; y < 256; y++) {
+			auto maskX = (float)x / 255.0f, maskY = (float)y / 255.0f;
+			auto reference = maskX * 0.5f + (1.0f - maskX * 0.5f) * maskY;
+			auto a = Half(Half(maskX) * 0.5f);
+			auto half = Half(a + Half(Half(1.0f - a) * Half(maskY)));
+			largest = std::max(largest, std::abs(half - reference));
+		}
+	}
+	CHECK(largest < 0.5f / 255.0f);
+}
+
+TEST_CASE("Half precision RCAS error", "[.benchmark]")
+{
+	auto corpus = MakeCorpus();
+	for (auto sharpness : { 0.25f, 0.5f, 1.0f }) {
+		for (auto floatLimiter : { false, true }) {
+			auto error = Measure(corpus, sharpness, floatLimiter);
+			std::printf("sharpness %.2f, %-13s max %.3f/255, mean %.4f/255, %.2f%% of 8-bit outputs differ\n", sharpness,
+				floatLimiter ? "float limiter" : "all 16-bit", error.largest * 255.0f, error.Mean() * 255.0f, 100.0 * (double)error.stepsOff / (double)error.count);
+		}
+	}
+}
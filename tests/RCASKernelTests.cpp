@@ -0,0 +1,261 @@
+#include "RCASClassifier.h"
+
+// Software executor for RCAS.hlsl. Each kernel is mirrored line for line, and a group runs its threads one phase at
+// a time, which is what GroupMemoryBarrierWithGroupSync guarantees on the GPU.
+namespace
+{
+	using RCASClassifier::Image;
+
+	struct GroupSize
+	{
+		uint32_t x;
+		uint32_t y;
+	};
+
+	// GroupSizeTuner::Candidates, which cannot be included here because it pulls in D3D
+	constexpr std::array<GroupSize, 4> Candidates = { { { 8, 8 }, { 16, 8 }, { 16, 16 }, { 32, 4 } } };
+
+	struct Counters
+	{
+		uint64_t textureLoads = 0;
+		uint64_t ldsWrites = 0;
+		uint64_t ldsReads = 0;
+		uint64_t pixels = 0;
+	};
+
+	struct Executor
+	{
+		const Image& source;
+		float sharpness;
+		Image dest;
+		Counters counters;
+
+		explicit Executor(const Image& a_source, float a_sharpness) :
+			source(a_source), sharpness(a_sharpness), dest(a_source) {}
+
+		const float* LoadClamped(int64_t a_x, int64_t a_y)
+		{
+			counters.textureLoads++;
+			return source.Load(a_x, a_y);
+		}
+
+		// UAV writes past the texture are dropped
+		void Store(int64_t a_x, int64_t a_y, const std::array<float, 3>& a_rgb)
+		{
+			if (a_x < 0 || a_y < 0 || a_x >= source.width || a_y >= source.height)
+				return;
+			std::copy(a_rgb.begin(), a_rgb.end(), dest.rgb.begin() + ((std::size_t)a_y * source.width + (std::size_t)a_x) * 3);
+			counters.pixels++;
+		}
+
+		void RunDirect(GroupSize a_group, int64_t a_originX, int64_t a_originY)
+		{
+			for (uint32_t ty = 0; ty < a_group.y; ty++) {
+				for (uint32_t tx = 0; tx < a_group.x; tx++) {
+					auto x = a_originX + tx, y = a_originY + ty;
+					auto e = LoadClamped(x, y);
+					auto b = LoadClamped(x, y - 1);
+					auto d = LoadClamped(x - 1, y);
+					auto f = LoadClamped(x + 1, y);
+					auto h = LoadClamped(x, y + 1);
+					using RCASClassifier::GetLuma;
+					Store(x, y, RCASClassifier::Filter(b, d, e, f, h, GetLuma(b), GetLuma(d), GetLuma(e), GetLuma(f), GetLuma(h), sharpness));
+				}
+			}
+		}
+
+		void RunGroupshared(GroupSize a_group, int64_t a_originX, int64_t a_originY)
+		{
+			auto haloWidth = a_group.x + 2, haloHeight = a_group.y + 2;
+			std::vector<std::array<float, 3>> cachedColor(haloWidth * haloHeight);
+			std::vector<float> cachedLuma(haloWidth * haloHeight);
+			std::vector<bool> written(haloWidth * haloHeight);
+
+			// Before the barrier
+			for (uint32_t groupIndex = 0; groupIndex < a_group.x * a_group.y; groupIndex++) {
+				for (auto i = groupIndex; i < haloWidth * haloHeight; i += a_group.x * a_group.y) {
+					auto color = LoadClamped(a_originX + i % haloWidth - 1, a_originY + i / haloWidth - 1);
+					REQUIRE_FALSE(written[i]);
+					std::copy(color, color + 3, cachedColor[i].begin());
+					cachedLuma[i] = RCASClassifier::GetLuma(color);
+					written[i] = true;
+					counters.ldsWrites += 2;
+				}
+			}
+			REQUIRE(std::all_of(written.begin(), written.end(), [](bool a_written) { return a_written; }));
+
+			// After the barrier
+			for (uint32_t ty = 0; ty < a_group.y; ty++) {
+				for (uint32_t tx = 0; tx < a_group.x; tx++) {
+					auto center = (ty + 1) * haloWidth + tx + 1;
+					counters.ldsReads += 10;
+					auto output = RCASClassifier::Filter(
+						cachedColor[center - haloWidth].data(), cachedColor[center - 1].data(), cachedColor[center].data(), cachedColor[center + 1].data(), cachedColor[center + haloWidth].data(),
+						cachedLuma[center - haloWidth], cachedLuma[center - 1], cachedLuma[center], cachedLuma[center + 1], cachedLuma[center + haloWidth], sharpness);
+					Store(a_originX + tx, a_originY + ty, output);
+				}
+			}
+		}
+
+		// Full screen dispatch of CountX by CountY groups
+		void Dispatch(bool a_groupshared, GroupSize a_group)
+		{
+			for (uint32_t gy = 0; gy < (source.height + a_group.y - 1) / a_group.y; gy++) {
+				for (uint32_t gx = 0; gx < (source.width + a_group.x - 1) / a_group.x; gx++) {
+					if (a_groupshared)
+						RunGroupshared(a_group, (int64_t)gx * a_group.x, (int64_t)gy * a_group.y);
+					else
+						RunDirect(a_group, (int64_t)gx * a_group.x, (int64_t)gy * a_group.y);
+				}
+			}
+		}
+
+		// Tiled dispatch over the tiles the classifier appended, the rest of dest keeps the source
+		void DispatchTiles(bool a_groupshared)
+		{
+			auto threshold = RCASClassifier::GetSkipThreshold(sharpness);
+			for (uint32_t tileY = 0; tileY * RCASClassifier::TileSize < source.height; tileY++) {
+				for (uint32_t tileX = 0; tileX * RCASClassifier::TileSize < source.width; tileX++) {
+					if (!RCASClassifier::IsSharpened(source, tileX, tileY, threshold))
+						continue;
+					GroupSize tile{ RCASClassifier::TileSize, RCASClassifier::TileSize };
+					if (a_groupshared)
+						RunGroupshared(tile, (int64_t)tileX * tile.x, (int64_t)tileY * tile.y);
+					else
+						RunDirect(tile, (int64_t)tileX * tile.x, (int64_t)tileY * tile.y);
+				}
+			}
+		}
+	};
+
+	Image MakeNoise(uint32_t a_width, uint32_t a_height, uint32_t a_seed)
+	{
+		std::mt19937 rng(a_seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		Image image{ a_width, a_height, std::vector<float>((std::size_t)a_width * a_height * 3) };
+		// Mostly smooth with some hard edges, so the limiter and the noise detection both get exercised
+		for (uint32_t y = 0; y < a_height; y++) {
+			for (uint32_t x = 0; x < a_width; x++) {
+				auto base = ((x / 5 + y / 3) % 4 == 0) ? 0.9f : 0.2f + 0.3f * std::sin((float)(x + y) * 0.1f);
+				for (int c = 0; c < 3; c++)
+					image.rgb[((std::size_t)y * a_width + x) * 3 + c] = std::clamp(base + (unit(rng) - 0.5f) * 0.1f, 0.0f, 1.0f);
+			}
+		}
+		return image;
+	}
+
+	bool BitExact(const Image& a_lhs, const Image& a_rhs)
+	{
+		return a_lhs.rgb.size() == a_rhs.rgb.size() && std::memcmp(a_lhs.rgb.data(), a_rhs.rgb.data(), a_lhs.rgb.size() * sizeof(float)) == 0;
+	}
+
+	float GetLargestDifference(const Image& a_lhs, const Image& a_rhs)
+	{
+		float largest = 0.0f;
+		for (std::size_t i = 0; i < a_lhs.rgb.size(); i++)
+			largest = std::max(largest, std::abs(a_lhs.rgb[i] - a_rhs.rgb[i]));
+		return largest;
+	}
+
+	// A few detailed patches between faint checkers whose contrast grows by a_contrastStep from tile to tile, stepping
+	// through the skip threshold of every sharpness so some tiles are skipped just below it
+	Image MakeMostlyFlat(uint32_t a_width, uint32_t a_height, uint32_t a_seed, float a_contrastStep)
+	{
+		auto image = MakeNoise(a_width, a_height, a_seed);
+		for (uint32_t y = 0; y < a_height; y++) {
+			for (uint32_t x = 0; x < a_width; x++) {
+				if ((x / 64 + y / 64) % 5 == 0)
+					continue;
+				auto contrast = a_contrastStep * (float)((x / RCASClassifier::TileSize * 7 + y / RCASClassifier::TileSize * 3) % 61);
+				for (int c = 0; c < 3; c++)
+					image.rgb[((std::size_t)y * a_width + x) * 3 + c] = 0.3f + 0.05f * (float)c + ((x + y) % 2 ? contrast : 0.0f);
+			}
+		}
+		return image;
+	}
+}
+
+TEST_CASE("RCAS groupshared kernel is bit exact with the direct kernel", "[RCASKernel]")
+{
+	auto sharpness = GENERATE(0.3f, 1.0f);
+	// Sizes that are not multiples of any group size, so partial groups at the right and bottom edges are covered
+	auto image = MakeNoise(67, 45, 3);
+
+	Executor reference(image, sharpness);
+	for (uint32_t y = 0; y < image.height; y++) {
+		for (uint32_t x = 0; x < image.width; x++)
+			reference.Store(x, y, RCASClassifier::Filter(image, x, y, sharpness));
+	}
+
+	for (auto group : Candidates) {
+		CAPTURE(group.x, group.y);
+		Executor direct(image, sharpness), groupshared(image, sharpness);
+		direct.Dispatch(false, group);
+		groupshared.Dispatch(true, group);
+		CHECK(BitExact(direct.dest, reference.dest));
+		CHECK(BitExact(groupshared.dest, reference.dest));
+	}
+
+	Executor direct(image, sharpness), groupshared(image, sharpness);
+	direct.DispatchTiles(false);
+	groupshared.DispatchTiles(true);
+	CHECK(BitExact(direct.dest, groupshared.dest));
+}
+
+TEST_CASE("RCAS into the output matches the tiled path", "[RCASKernel]")
+{
+	// SharpenToOutput runs the full screen kernel on every texel, Sharpen runs it on the classified tiles of a copy
+	auto sharpness = GENERATE(0.1f, 0.5f, 1.0f);
+	auto image = GENERATE(MakeNoise(67, 45, 7), MakeMostlyFlat(200, 136, 9, 0.0005f));
+	CAPTURE(sharpness, image.width, image.height);
+
+	Executor tiled(image, sharpness);
+	tiled.DispatchTiles(true);
+	for (auto group : Candidates) {
+		CAPTURE(group.x, group.y);
+		for (auto groupshared : { false, true }) {
+			Executor fused(image, sharpness);
+			fused.Dispatch(groupshared, group);
+			CHECK(GetLargestDifference(fused.dest, tiled.dest) < RCASClassifier::MaxSkippedChange);
+		}
+	}
+}
+
+TEST_CASE("RCAS output path memory traffic", "[.benchmark]")
+{
+	// R8G8B8A8 at 4K, texel reads counted once per group like the groupshared kernel does, which is the traffic the
+	// direct kernel's cache hits reduce to
+	constexpr uint32_t Width = 3840, Height = 2160;
+	constexpr double TexelBytes = 4.0, Megabyte = 1000.0 * 1000.0;
+	constexpr double FrameBytes = Width * Height * TexelBytes;
+	constexpr double TileCount = (double)((Width + 7) / 8) * ((Height + 7) / 8);
+
+	for (auto& [name, image] : { std::pair{ "noise", MakeNoise(Width, Height, 5) }, std::pair{ "mostly flat", MakeMostlyFlat(Width, Height, 5, 0.0f) } }) {
+		Executor tiled(image, 0.5f), fused(image, 0.5f);
+		tiled.DispatchTiles(true);
+		fused.Dispatch(true, Candidates[0]);
+
+		// Copy back into the game texture, classifier with its halo, tiles, copy to the output
+		auto copy = 2.0 * FrameBytes;
+		auto classify = TileCount * 100.0 * TexelBytes;
+		auto tiledBytes = copy + classify + (double)(tiled.counters.textureLoads + tiled.counters.pixels) * TexelBytes + copy;
+		auto fusedBytes = (double)(fused.counters.textureLoads + fused.counters.pixels) * TexelBytes;
+		std::printf("%-11s %5.1f%% of tiles sharpened, tiled path %.1f MB, into the output %.1f MB, %.1f MB saved per frame\n", name,
+			100.0 * (double)tiled.counters.pixels / ((double)Width * Height), tiledBytes / Megabyte, fusedBytes / Megabyte, (tiledBytes - fusedBytes) / Megabyte);
+	}
+}
+
+TEST_CASE("RCAS kernel memory operations", "[.benchmark]")
+{
+	auto image = MakeNoise(1920, 1080, 5);
+	for (auto group : Candidates) {
+		Executor direct(image, 0.5f), groupshared(image, 0.5f);
+		direct.Dispatch(false, group);
+		groupshared.Dispatch(true, group);
+
+		auto perPixel = [](uint64_t a_count, const Counters& a_counters) { return (double)a_count / (double)a_counters.pixels; };
+		std::printf("%2ux%-2u direct: %.2f texture loads per pixel, groupshared: %.2f texture loads, %.2f LDS writes, %.2f LDS reads per pixel\n",
+			group.x, group.y, perPixel(direct.counters.textureLoads, direct.counters), perPixel(groupshared.counters.textureLoads, groupshared.counters),
+			perPixel(groupshared.counters.ldsWrites, groupshared.counters), perPixel(groupshared.counters.ldsReads, groupshared.counters));
+	}
+}
@@ -0,0 +1,154 @@
+#include "ReadbackRing.h"
+
+#include <deque>
+
+namespace
+{
+	// A GPU that finishes each copy a number of frames after it was recorded, in submission order, and writes its
+	// result into the slot's staging memory only then
+	struct SimulatedGPU
+	{
+		std::function<uint64_t(uint64_t)> latency = [](uint64_t) { return 2; };
+
+		// Staging memory of each slot, the frame whose result it holds
+		std::array<uint64_t, ReadbackRing::MaxSlots> staging{};
+		// Frame each slot's copy finishes, in submission order
+		std::deque<std::pair<uint, uint64_t>> queue;
+		std::array<bool, ReadbackRing::MaxSlots> finished{};
+		uint64_t lastFinish = 0;
+
+		void Record(uint a_index, uint64_t a_frame)
+		{
+			// A later copy cannot finish before an earlier one
+			lastFinish = std::max(lastFinish, a_frame + latency(a_frame));
+			queue.emplace_back(a_index, lastFinish);
+			finished[a_index] = false;
+			staging[a_index] = a_frame;
+		}
+
+		void Advance(uint64_t a_frame)
+		{
+			while (!queue.empty() && queue.front().second <= a_frame) {
+				finished[queue.front().first] = true;
+				queue.pop_front();
+			}
+		}
+	};
+
+	// What GpuReadback and GpuTimer do each frame: read what finished, then record this frame's copy
+	struct Simulation
+	{
+		ReadbackRing ring;
+		SimulatedGPU gpu;
+		std::vector<uint64_t> results;
+
+		explicit Simulation(uint a_slots) :
+			ring(a_slots)
+		{}
+
+		void Run(uint64_t a_begin, uint64_t a_end)
+		{
+			for (auto frame = a_begin; frame < a_end; frame++) {
+				gpu.Advance(frame);
+				ring.Poll(frame, [&](uint a_index, const ReadbackRing::Slot& a_slot) {
+					if (!gpu.finished[a_index])
+						return false;
+					// The staging memory still holds the copy this slot was claimed for
+					CHECK(gpu.staging[a_index] == a_slot.frame);
+					results.push_back(a_slot.frame);
+					return true;
+				});
+				if (auto index = ring.Claim(frame, 0))
+					gpu.Record(*index, frame);
+			}
+		}
+	};
+}
+
+TEST_CASE("ReadbackRing reads every result once the GPU latency is covered", "[ReadbackRing]")
+{
+	auto latency = GENERATE(1u, 2u, 3u, 5u);
+	CAPTURE(latency);
+
+	// One slot per frame in flight, and the one recorded this frame
+	Simulation simulation(latency + 1);
+	simulation.gpu.latency = [=](uint64_t) { return latency; };
+	simulation.Run(0, 1000);
+
+	auto& statistics = simulation.ring.GetStatistics();
+	CHECK(statistics.dropped == 0);
+	CHECK(statistics.latency == latency);
+	CHECK(statistics.maxLatency == latency);
+	REQUIRE(simulation.results.size() == 1000 - latency);
+	for (uint64_t i = 0; i < simulation.results.size(); i++)
+		CHECK(simulation.results[i] == i);
+}
+
+TEST_CASE("ReadbackRing drops copies instead of waiting on a full ring", "[ReadbackRing]")
+{
+	// Three frames of latency, but only two slots
+	Simulation simulation(2);
+	simulation.gpu.latency = [](uint64_t) { return 3; };
+	simulation.Run(0, 1000);
+
+	auto& statistics = simulation.ring.GetStatistics();
+	CHECK(statistics.dropped > 0);
+	CHECK(statistics.completed + statistics.dropped + 2 >= 1000);
+	CHECK(statistics.maxLatency == 3);
+	// Results stay in order, with gaps for the dropped frames
+	CHECK(std::is_sorted(simulation.results.begin(), simulation.results.end()));
+	CHECK(std::adjacent_find(simulation.results.begin(), simulation.results.end()) == simulation.results.end());
+}
+
+TEST_CASE("ReadbackRing follows a GPU with varying latency", "[ReadbackRing]")
+{
+	// A hitch every hundred frames stalls the queue for eight frames
+	Simulation simulation(4);
+	simulation.gpu.latency = [](uint64_t a_frame) { return a_frame % 100 == 50 ? 8 : 1 + a_frame % 3; };
+	simulation.Run(0, 1000);
+
+	auto& statistics = simulation.ring.GetStatistics();
+	CHECK(statistics.dropped > 0);
+	CHECK(statistics.maxLatency == 8);
+	CHECK(std::is_sorted(simulation.results.begin(), simulation.results.end()));
+	// The ring catches up after each hitch
+	CHECK(simulation.results.back() >= 990);
+	CHECK(simulation.results.size() + statistics.dropped >= 990);
+}
+
+TEST_CASE("ReadbackRing polling stops at the first unfinished slot", "[ReadbackRing]")
+{
+	ReadbackRing ring(4);
+	REQUIRE(ring.Claim(10, 1) == 0u);
+	REQUIRE(ring.Claim(11, 2) == 1u);
+	REQUIRE(ring.Claim(12, 3) == 2u);
+
+	std::vector<uint> visited;
+	auto read = [&](std::initializer_list<uint> a_ready) {
+		visited.clear();
+		return ring.Poll(13, [&](uint a_index, const ReadbackRing::Slot& a_slot) {
+			visited.push_back(a_slot.tag);
+			return std::find(a_ready.begin(), a_ready.end(), a_index) != a_ready.end();
+		});
+	};
+
+	// The newest slot reports ready out of order, it is not read before the older one
+	CHECK(read({ 0, 2 }) == 1);
+	CHECK(visited == std::vector<uint>{ 1, 2 });
+	CHECK(read({ 1, 2 }) == 2);
+	CHECK(visited == std::vector<uint>{ 2, 3 });
+	CHECK(ring.GetStatistics().completed == 3);
+
+	ring.Reset();
+	CHECK(ring.GetStatistics().completed == 0);
+	CHECK(read({ 0, 1, 2, 3 }) == 0);
+	CHECK(ring.Claim(20, 0) == 0u);
+
+	// FrameCapture checks this before copying any plane of a frame
+	for (uint frame = 21; frame < 24; frame++) {
+		CHECK_FALSE(ring.IsFull());
+		ring.Claim(frame, 0);
+	}
+	CHECK(ring.IsFull());
+	CHECK_FALSE(ring.Claim(24, 0));
+}
@@ -0,0 +1,167 @@
+#include "RingAllocator.h"
+
+namespace
+{
+	// Fences complete a fixed number of frames after they were issued, like a GPU running behind the CPU
+	struct SimulatedGpu
+	{
+		uint64_t latency;
+		uint64_t frame = 0;
+		uint64_t issued[RingAllocator::FrameLatency] = {};
+
+		bool Reached(uint32_t a_fence) const { return issued[a_fence] + latency <= frame; }
+	};
+
+	struct Live
+	{
+		uint64_t frame;
+		uint32_t offset;
+		uint32_t size;
+	};
+}
+
+TEST_CASE("RingAllocator aligns to constant buffer offsets", "[RingAllocator]")
+{
+	CHECK(RingAllocator::AlignUp(1) == 256);
+	CHECK(RingAllocator::AlignUp(256) == 256);
+	CHECK(RingAllocator::AlignUp(257) == 512);
+	CHECK(RingAllocator::AlignUp(0) == 0);
+}
+
+TEST_CASE("RingAllocator hands out space linearly until full", "[RingAllocator]")
+{
+	RingAllocator ring(1024);
+	ring.BeginFrame([](uint32_t) { return false; });
+	CHECK(ring.Reserve(256) == 0);
+	CHECK(ring.Reserve(512) == 256);
+	CHECK(ring.Reserve(256) == 768);
+	CHECK(ring.Reserve(256) == RingAllocator::Full);
+	CHECK(ring.Reserve(2048) == RingAllocator::Full);
+	CHECK(ring.GetUsed() == 1024);
+}
+
+TEST_CASE("RingAllocator frees a frame only once its fence is reached", "[RingAllocator]")
+{
+	RingAllocator ring(1024);
+	bool reached = false;
+	auto reachedFence = [&](uint32_t) { return reached; };
+
+	ring.BeginFrame(reachedFence);
+	CHECK(ring.Reserve(768) == 0);
+	ring.EndFrame();
+
+	ring.BeginFrame(reachedFence);
+	CHECK(ring.GetPendingFrames() == 1);
+	CHECK(ring.Reserve(512) == RingAllocator::Full);
+
+	reached = true;
+	ring.BeginFrame(reachedFence);
+	CHECK(ring.GetPendingFrames() == 0);
+	CHECK(ring.GetUsed() == 0);
+	// The 256 bytes left at the end are too small, so the allocation wraps and they count as used until retired
+	CHECK(ring.Reserve(512) == 0);
+	CHECK(ring.GetUsed() == 768);
+}
+
+TEST_CASE("RingAllocator wraps around live data", "[RingAllocator]")
+{
+	RingAllocator ring(1024);
+	SimulatedGpu gpu{ 2 };
+	auto reached = [&](uint32_t a_fence) { return gpu.Reached(a_fence); };
+
+	ring.BeginFrame(reached);
+	CHECK(ring.Reserve(512) == 0);
+	gpu.issued[ring.EndFrame()] = gpu.frame++;
+
+	ring.BeginFrame(reached);
+	CHECK(ring.Reserve(256) == 512);
+	gpu.issued[ring.EndFrame()] = gpu.frame++;
+
+	// The first frame is retired, the second one still lives at 512
+	ring.BeginFrame(reached);
+	CHECK(ring.Reserve(768) == RingAllocator::Full);
+	CHECK(ring.Reserve(256) == 768);
+	CHECK(ring.Reserve(256) == 0);
+	CHECK(ring.Reserve(256) == 256);
+	CHECK(ring.Reserve(256) == RingAllocator::Full);
+}
+
+TEST_CASE("RingAllocator folds frames once every fence is in flight", "[RingAllocator]")
+{
+	RingAllocator ring(4096);
+	bool reached = false;
+	auto reachedFence = [&](uint32_t) { return reached; };
+
+	for (uint32_t i = 0; i < RingAllocator::FrameLatency + 2; i++) {
+		ring.BeginFrame(reachedFence);
+		CHECK(ring.Reserve(256) != RingAllocator::Full);
+		ring.EndFrame();
+		CHECK(ring.GetPendingFrames() <= RingAllocator::FrameLatency);
+	}
+	CHECK(ring.GetUsed() == 256 * (RingAllocator::FrameLatency + 2));
+
+	reached = true;
+	ring.BeginFrame(reachedFence);
+	CHECK(ring.GetPendingFrames() == 0);
+	CHECK(ring.GetUsed() == 0);
+}
+
+TEST_CASE("RingAllocator never overwrites data the GPU may still read", "[RingAllocator]")
+{
+	auto latency = GENERATE(0u, 1u, 2u, 3u, 5u);
+	std::mt19937 rng(latency);
+	RingAllocator ring(128 * 1024);
+	SimulatedGpu gpu{ latency };
+	std::vector<Live> live;
+	uint64_t renames = 0;
+
+	for (uint64_t frame = 0; frame < 2000; frame++) {
+		ring.BeginFrame([&](uint32_t a_fence) { return gpu.Reached(a_fence); });
+
+		auto allocations = 1 + rng() % 12;
+		for (uint32_t i = 0; i < allocations; i++) {
+			auto size = RingAllocator::AlignUp(16 + rng() % 1024);
+			auto offset = ring.Reserve(size);
+			if (offset == RingAllocator::Full) {
+				// ConstantBufferRing renames the buffer with WRITE_DISCARD, the GPU keeps reading the old copy
+				ring.Reset();
+				live.clear();
+				renames++;
+				offset = ring.Reserve(size);
+				REQUIRE(offset != RingAllocator::Full);
+			}
+
+			REQUIRE(offset % RingAllocator::Alignment == 0);
+			REQUIRE(offset + size <= ring.GetCapacity());
+			for (auto& other : live) {
+				bool overlaps = offset < other.offset + other.size && other.offset < offset + size;
+				bool completed = other.frame + latency <= gpu.frame;
+				REQUIRE((!overlaps || completed));
+			}
+			live.push_back({ gpu.frame, offset, size });
+		}
+
+		gpu.issued[ring.EndFrame()] = gpu.frame++;
+		std::erase_if(live, [&](const Live& a_live) { return a_live.frame + latency <= gpu.frame; });
+	}
+
+	// Frames of up to 15 KB fit without renaming unless the GPU runs further behind than there are fences
+	if (latency <= RingAllocator::FrameLatency)
+		CHECK(renames == 0);
+}
+
+TEST_CASE("RingAllocator throughput", "[.benchmark]")
+{
+	RingAllocator ring(64 * 1024);
+	SimulatedGpu gpu{ 2 };
+
+	BENCHMARK("frame of 16 allocations")
+	{
+		ring.BeginFrame([&](uint32_t a_fence) { return gpu.Reached(a_fence); });
+		uint32_t sum = 0;
+		for (uint32_t i = 0; i < 16; i++)
+			sum += ring.Reserve(RingAllocator::AlignUp(64 + i * 32));
+		gpu.issued[ring.EndFrame()] = gpu.frame++;
+		return sum;
+	};
+}
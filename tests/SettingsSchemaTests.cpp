@@ -0,0 +1,146 @@
+#include "SettingsSchema.h"
+
+namespace
+{
+	std::string Serialize(const UpscalingSettings& a_settings)
+	{
+		std::array<char, 4 * 1024> buffer;
+		auto size = SettingsSchema::SerializeINI(a_settings, buffer.data(), buffer.size());
+		return { buffer.data(), size };
+	}
+
+	UpscalingSettings Parse(std::string_view a_text)
+	{
+		UpscalingSettings settings;
+		SettingsSchema::ParseINI(a_text, settings);
+		return settings;
+	}
+}
+
+TEST_CASE("SettingsSchema round trips every field through the INI", "[SettingsSchema]")
+{
+	UpscalingSettings settings;
+	settings.upscaleMethod = (uint)UpscaleMethod::kFSR;
+	settings.upscaleMethodNoDLSS = (uint)UpscaleMethod::kTAA;
+	settings.sharpness = 0.25f;
+	settings.dlssPreset = (uint)DLSSPreset::kPresetC;
+	settings.menuBypass = false;
+	settings.idleReuse = false;
+	settings.sharpenKernel = (uint)SharpenKernel::kDirect;
+	settings.halfPrecision = false;
+	settings.autoMethod = true;
+	settings.autoBudget = 3.75f;
+	settings.frameGeneration = true;
+	settings.frameGenerationRenderStart = true;
+	settings.bypassMenus.Assign("Main Menu, Loading Menu");
+
+	auto text = Serialize(settings);
+	auto parsed = Parse(text);
+
+	CHECK(parsed.upscaleMethod == settings.upscaleMethod);
+	CHECK(parsed.upscaleMethodNoDLSS == settings.upscaleMethodNoDLSS);
+	CHECK(parsed.sharpness == settings.sharpness);
+	CHECK(parsed.dlssPreset == settings.dlssPreset);
+	CHECK(parsed.menuBypass == settings.menuBypass);
+	CHECK(parsed.idleReuse == settings.idleReuse);
+	CHECK(parsed.sharpenKernel == settings.sharpenKernel);
+	CHECK(parsed.halfPrecision == settings.halfPrecision);
+	CHECK(parsed.autoMethod == settings.autoMethod);
+	CHECK(parsed.autoBudget == settings.autoBudget);
+	CHECK(parsed.frameGeneration == settings.frameGeneration);
+	CHECK(parsed.frameGenerationRenderStart == settings.frameGenerationRenderStart);
+	CHECK(parsed.bypassMenus.View() == settings.bypassMenus.View());
+	CHECK(Serialize(parsed) == text);
+}
+
+TEST_CASE("SettingsSchema writes defaults and keys under the section", "[SettingsSchema]")
+{
+	auto text = Serialize(UpscalingSettings{});
+	CHECK(text.starts_with("[ANTIALIASING]\n\n"));
+	CHECK(text.find("# Default: 0.5\nSharpness = 0.5\n") != std::string::npos);
+	CHECK(text.find("# Default: 5 (Preset E)\nDLAAPreset = 5\n") != std::string::npos);
+	CHECK(text.find("BypassMenus = Loading Menu,MapMenu,") != std::string::npos);
+}
+
+TEST_CASE("SettingsSchema clamps values to the field range", "[SettingsSchema]")
+{
+	auto parsed = Parse("[ANTIALIASING]\nSharpness = 5\nAutoBudget = 0.1\n");
+	CHECK(parsed.sharpness == 1.0f);
+	CHECK(parsed.autoBudget == 0.5f);
+
+	UpscalingSettings settings;
+	settings.sharpness = -1.0f;
+	settings.autoBudget = std::numeric_limits<float>::quiet_NaN();
+	settings.upscaleMethod = 3;
+	settings.upscaleMethodNoDLSS = (uint)UpscaleMethod::kDLSS;
+	settings.dlssPreset = 100;
+	SettingsSchema::Validate(settings);
+
+	CHECK(settings.sharpness == 0.0f);
+	CHECK(settings.autoBudget == UpscalingSettings{}.autoBudget);
+	CHECK(settings.upscaleMethod == UpscalingSettings{}.upscaleMethod);
+	// DLAA is not offered when DLSS is missing
+	CHECK(settings.upscaleMethodNoDLSS == UpscalingSettings{}.upscaleMethodNoDLSS);
+	CHECK(settings.dlssPreset == UpscalingSettings{}.dlssPreset);
+}
+
+TEST_CASE("SettingsSchema keeps the previous value for malformed keys", "[SettingsSchema]")
+{
+	UpscalingSettings settings;
+	settings.sharpness = 0.75f;
+	settings.menuBypass = false;
+	settings.bypassMenus.Assign("Main Menu");
+
+	SettingsSchema::ParseINI(
+		"[ANTIALIASING]\n"
+		"Sharpness = abc\n"
+		"Method = 3\n"
+		"MethodNoDLAA = 2\n"
+		"DLAAPreset = -1\n"
+		"MenuBypass = maybe\n"
+		"AutoBudget = nan\n"
+		"Unknown = 1\n"
+		"BypassMenus = " +
+			std::string(600, 'x') +
+			"\n"
+			"[OTHER]\n"
+			"IdleReuse = 0\n",
+		settings);
+
+	CHECK(settings.sharpness == 0.75f);
+	CHECK(settings.upscaleMethod == UpscalingSettings{}.upscaleMethod);
+	CHECK(settings.upscaleMethodNoDLSS == UpscalingSettings{}.upscaleMethodNoDLSS);
+	CHECK(settings.dlssPreset == UpscalingSettings{}.dlssPreset);
+	CHECK(settings.menuBypass == false);
+	CHECK(settings.autoBudget == UpscalingSettings{}.autoBudget);
+	CHECK(settings.bypassMenus.View() == "Main Menu");
+	CHECK(settings.idleReuse == true);
+}
+
+TEST_CASE("SettingsSchema visibility follows DLSS", "[SettingsSchema]")
+{
+	using SettingsSchema::Visibility;
+	CHECK(SettingsSchema::IsVisible(Visibility::kAlways, false));
+	CHECK(SettingsSchema::IsVisible(Visibility::kWithDLSS, true));
+	CHECK_FALSE(SettingsSchema::IsVisible(Visibility::kWithDLSS, false));
+	CHECK(SettingsSchema::IsVisible(Visibility::kWithoutDLSS, false));
+	CHECK_FALSE(SettingsSchema::IsVisible(Visibility::kHidden, true));
+}
+
+TEST_CASE("SettingsSchema throughput", "[.benchmark]")
+{
+	auto text = Serialize(UpscalingSettings{});
+	std::array<char, 4 * 1024> buffer;
+
+	BENCHMARK("parse INI")
+	{
+		UpscalingSettings settings;
+		SettingsSchema::ParseINI(text, settings);
+		return settings.sharpness;
+	};
+
+	BENCHMARK("serialize INI")
+	{
+		return SettingsSchema::SerializeINI(UpscalingSettings{}, buffer.data(), buffer.size());
+	};
+}
@@ -0,0 +1,83 @@
+#include "Snapshot.h"
+
+namespace
+{
+	// Every field derives from the sequence number, a torn read shows up as a mismatch
+	struct Payload
+	{
+		uint64_t sequence = 0;
+		uint64_t words[15] = {};
+
+		static Payload Make(uint64_t a_sequence)
+		{
+			Payload payload;
+			payload.sequence = a_sequence;
+			for (uint64_t i = 0; i < std::size(payload.words); i++)
+				payload.words[i] = a_sequence * (i + 1);
+			return payload;
+		}
+
+		bool Consistent() const
+		{
+			for (uint64_t i = 0; i < std::size(words); i++) {
+				if (words[i] != sequence * (i + 1))
+					return false;
+			}
+			return true;
+		}
+	};
+}
+
+TEST_CASE("Snapshot returns the default value before anything is published", "[Snapshot]")
+{
+	Snapshot<Payload> snapshot;
+	CHECK(snapshot.Acquire().sequence == 0);
+	CHECK(snapshot.Version() == 0);
+}
+
+TEST_CASE("Snapshot hands out the latest published value", "[Snapshot]")
+{
+	Snapshot<Payload> snapshot;
+	snapshot.Publish(Payload::Make(1));
+	snapshot.Publish(Payload::Make(2));
+	CHECK(snapshot.Acquire().sequence == 2);
+	CHECK(snapshot.Version() == 2);
+
+	// Nothing new, the same value is kept
+	CHECK(snapshot.Acquire().sequence == 2);
+	snapshot.Publish(Payload::Make(3));
+	CHECK(snapshot.Acquire().sequence == 3);
+	CHECK(snapshot.Version() == 3);
+}
+
+TEST_CASE("Snapshot stress, one writer and one reader", "[Snapshot][stress]")
+{
+	constexpr uint64_t Publishes = 100000;
+	Snapshot<Payload> snapshot;
+	std::atomic<bool> done = false;
+
+	std::thread writer([&] {
+		for (uint64_t i = 1; i <= Publishes; i++)
+			snapshot.Publish(Payload::Make(i));
+		done.store(true, std::memory_order_release);
+	});
+
+	uint64_t lastSequence = 0, lastVersion = 0, torn = 0, reordered = 0;
+	auto check = [&] {
+		auto& value = snapshot.Acquire();
+		torn += !value.Consistent();
+		reordered += value.sequence < lastSequence || snapshot.Version() < lastVersion || snapshot.Version() != value.sequence;
+		lastSequence = value.sequence;
+		lastVersion = snapshot.Version();
+	};
+	while (!done.load(std::memory_order_acquire)) {
+		check();
+		std::this_thread::yield();
+	}
+	writer.join();
+	check();
+
+	CHECK(torn == 0);
+	CHECK(reordered == 0);
+	CHECK(lastSequence == Publishes);
+}
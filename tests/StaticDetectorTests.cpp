@@ -0,0 +1,244 @@
+#include "StaticDetector.h"
+
+namespace
+{
+	using State = StaticDetector::State;
+
+	StaticDetector::Statistics Still(uint64_t a_frame)
+	{
+		return { .frame = a_frame, .motion = 0.0f, .color = 0.0f, .hasMotion = true, .hasColor = true };
+	}
+
+	// Runs still frames with statistics arriving a_delay frames late, returns the frame kStatic was reached on
+	uint64_t ConvergeFrom(StaticDetector& a_detector, uint64_t a_frame, uint64_t a_delay, uint64_t a_limit = 100)
+	{
+		for (auto frame = a_frame; frame < a_frame + a_limit; frame++) {
+			auto statistics = Still(frame - std::min(frame, a_delay));
+			if (a_detector.Update(frame, true, frame >= a_delay ? &statistics : nullptr) == State::kStatic)
+				return frame;
+		}
+		return UINT64_MAX;
+	}
+
+	// One row per frame in the layout FrameCapture records the camera in, position and yaw around the up axis, with
+	// the largest motion vector in pixels and the largest colour change the statistics pass measured for it
+	struct TraceFrame
+	{
+		float position[3];
+		float yaw;
+		float motion;
+		float color;
+	};
+
+	// Hand written to the shape of a walk up to a spot, standing there and turning away. No gameplay capture was
+	// available to record it from, so it checks the decisions rather than tunes the thresholds.
+	constexpr TraceFrame CameraTrace[] = {
+		{ { 0.0f, 0.0f, 120.0f }, 90.0f, 4.0f, 0.06f }, // walking forward
+		{ { 6.0f, 0.0f, 120.0f }, 90.0f, 4.0f, 0.06f },
+		{ { 12.0f, 0.0f, 120.0f }, 90.0f, 4.0f, 0.06f },
+		{ { 18.0f, 0.0f, 120.0f }, 90.0f, 4.0f, 0.06f },
+		{ { 24.0f, 0.0f, 120.0f }, 90.0f, 4.0f, 0.06f },
+		{ { 30.0f, 0.0f, 120.0f }, 90.0f, 4.0f, 0.06f },
+		{ { 34.0f, 0.0f, 120.0f }, 90.0f, 2.0f, 0.04f }, // stopping
+		{ { 36.0f, 0.0f, 120.0f }, 90.0f, 0.6f, 0.02f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.15f, 0.01f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.08f, 0.002f }, // standing, float noise on y
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.000001f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.000001f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.000001f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.35f, 0.004f }, // grass in the wind
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.35f, 0.004f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.35f, 0.004f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.35f, 0.004f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.35f, 0.004f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.35f, 0.004f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.35f, 0.004f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.35f, 0.004f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.03f }, // torch flickers
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.03f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.03f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.03f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f }, // still again
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 90.0f, 0.03f, 0.002f },
+		{ { 36.5f, 0.0f, 120.0f }, 92.0f, 3.0f, 0.05f }, // turning
+		{ { 36.5f, 0.0f, 120.0f }, 94.0f, 3.0f, 0.05f },
+		{ { 36.5f, 0.0f, 120.0f }, 96.0f, 3.0f, 0.05f },
+		{ { 36.5f, 0.0f, 120.0f }, 98.0f, 3.0f, 0.05f },
+		{ { 36.5f, 0.0f, 120.0f }, 100.0f, 3.0f, 0.05f },
+	};
+
+	float4x4 GetViewMatrix(const TraceFrame& a_frame)
+	{
+		auto yaw = a_frame.yaw * 3.14159265f / 180.0f;
+		float4x4 view;
+		view._11 = std::cos(yaw);
+		view._12 = -std::sin(yaw);
+		view._21 = std::sin(yaw);
+		view._22 = std::cos(yaw);
+		view._41 = -a_frame.position[0];
+		view._42 = -a_frame.position[1];
+		view._43 = -a_frame.position[2];
+		return view;
+	}
+
+	// Replays the trace with statistics a_delay frames late, as GpuReadback delivers them, returns the state after
+	// every frame
+	std::vector<StaticDetector::State> Replay(StaticDetector& a_detector, uint64_t a_delay)
+	{
+		std::vector<StaticDetector::State> states;
+		for (uint64_t frame = 1; frame < std::size(CameraTrace); frame++) {
+			bool cameraStatic = StaticDetector::IsCameraStatic(GetViewMatrix(CameraTrace[frame]), GetViewMatrix(CameraTrace[frame - 1]), a_detector.thresholds.camera);
+
+			StaticDetector::Statistics statistics;
+			if (frame >= a_delay) {
+				auto& measured = CameraTrace[frame - a_delay];
+				statistics = { .frame = frame - a_delay, .motion = measured.motion, .color = measured.color, .hasMotion = true, .hasColor = true };
+			}
+			states.push_back(a_detector.Update(frame, cameraStatic, frame >= a_delay ? &statistics : nullptr));
+		}
+		return states;
+	}
+}
+
+TEST_CASE("StaticDetector stays in motion while the camera moves", "[StaticDetector]")
+{
+	StaticDetector detector;
+	for (uint64_t frame = 0; frame < 50; frame++) {
+		auto statistics = Still(frame);
+		CHECK(detector.Update(frame, false, &statistics) == State::kMoving);
+	}
+}
+
+TEST_CASE("StaticDetector needs a full convergence window and a confirming statistic", "[StaticDetector]")
+{
+	StaticDetector detector;
+	auto converge = detector.thresholds.convergeFrames;
+
+	SECTION("statistics on time")
+	{
+		CHECK(ConvergeFrom(detector, 10, 0) == 10 + converge - 1);
+	}
+
+	SECTION("statistics arriving late only confirm once one from after the camera stopped arrives")
+	{
+		CHECK(ConvergeFrom(detector, 10, 3) == 10 + converge - 1);
+		detector.Reset();
+		CHECK(ConvergeFrom(detector, 100, converge + 2) == 100 + converge + 2);
+	}
+
+	SECTION("no statistics never converges")
+	{
+		for (uint64_t frame = 0; frame < 100; frame++)
+			CHECK(detector.Update(frame, true, nullptr) == State::kConverging);
+	}
+}
+
+TEST_CASE("StaticDetector restarts convergence when something moves", "[StaticDetector]")
+{
+	StaticDetector detector;
+	auto converge = detector.thresholds.convergeFrames;
+
+	for (uint64_t frame = 0; frame < 5; frame++) {
+		auto statistics = Still(frame);
+		detector.Update(frame, true, &statistics);
+	}
+
+	auto moving = Still(5);
+	moving.motion = detector.thresholds.motion * 2.0f;
+	CHECK(detector.Update(5, true, &moving) == State::kConverging);
+	CHECK(ConvergeFrom(detector, 6, 0) == 6 + converge - 1);
+}
+
+TEST_CASE("StaticDetector reports becoming static once", "[StaticDetector]")
+{
+	StaticDetector detector;
+	auto reached = ConvergeFrom(detector, 0, 0);
+	CHECK(detector.JustBecameStatic());
+
+	auto statistics = Still(reached + 1);
+	CHECK(detector.Update(reached + 1, true, &statistics) == State::kStatic);
+	CHECK_FALSE(detector.JustBecameStatic());
+}
+
+TEST_CASE("StaticDetector leaves kStatic on a colour change measured after entering it", "[StaticDetector]")
+{
+	StaticDetector detector;
+	auto reached = ConvergeFrom(detector, 0, 0);
+
+	// Measured on the frame the reference colour was captured, compares the reference with itself
+	auto stale = Still(reached);
+	stale.color = 1.0f;
+	CHECK(detector.Update(reached + 1, true, &stale) == State::kStatic);
+
+	auto small = Still(reached + 1);
+	small.color = detector.thresholds.color * 0.5f;
+	CHECK(detector.Update(reached + 2, true, &small) == State::kStatic);
+
+	auto changed = Still(reached + 2);
+	changed.color = detector.thresholds.color * 2.0f;
+	CHECK(detector.Update(reached + 3, true, &changed) == State::kMoving);
+}
+
+TEST_CASE("StaticDetector leaves kStatic as soon as the camera moves", "[StaticDetector]")
+{
+	StaticDetector detector;
+	auto reached = ConvergeFrom(detector, 0, 0);
+	CHECK(detector.Update(reached + 1, false, nullptr) == State::kMoving);
+	CHECK_FALSE(detector.IsStatic());
+}
+
+TEST_CASE("StaticDetector compares camera matrices per element", "[StaticDetector]")
+{
+	float4x4 previous, current;
+	CHECK(StaticDetector::IsCameraStatic(current, previous, 1e-5f));
+
+	current._43 += 0.5e-5f;
+	CHECK(StaticDetector::IsCameraStatic(current, previous, 1e-5f));
+
+	current._43 += 1e-5f;
+	CHECK_FALSE(StaticDetector::IsCameraStatic(current, previous, 1e-5f));
+}
+
+TEST_CASE("StaticDetector decisions on a camera trace", "[StaticDetector]")
+{
+	StaticDetector detector;
+	auto states = Replay(detector, 3);
+
+	// Frame each state was entered on
+	std::vector<std::pair<uint64_t, State>> changes;
+	auto previous = State::kMoving;
+	for (uint64_t i = 0; i < states.size(); i++) {
+		if (states[i] != previous)
+			changes.push_back({ i + 1, states[i] });
+		previous = states[i];
+	}
+
+	CHECK(changes == std::vector<std::pair<uint64_t, State>>{
+						 // The camera stops on frame 9, float noise does not count as movement. Statistics of the
+						 // slowing frames before it arrive late and are ignored, frame 9's confirms on frame 12.
+						 { 9, State::kConverging },
+						 { 16, State::kStatic },
+						 // Grass moving in the wind is kept, only the colour change of the torch ends reuse
+						 { 36, State::kMoving },
+						 { 37, State::kConverging },
+						 { 44, State::kStatic },
+						 { 45, State::kMoving } });
+}
@@ -0,0 +1,148 @@
+#include "StereoViewports.h"
+
+namespace
+{
+	// A headset eye: tangents of its half angles, the outer side wider than the one towards the nose
+	struct Eye
+	{
+		float left, right, up, down;
+	};
+
+	constexpr Eye LeftEye{ 1.39f, 0.98f, 1.12f, 1.12f };
+	constexpr Eye RightEye{ 0.98f, 1.39f, 1.12f, 1.12f };
+
+	// Off-center perspective projection in the row vector layout of SimpleMath and the game's ViewData::viewMat
+	float4x4 Projection(const Eye& a_eye)
+	{
+		float4x4 projection;
+		projection._11 = 2.0f / (a_eye.left + a_eye.right);
+		projection._22 = 2.0f / (a_eye.up + a_eye.down);
+		projection._31 = (a_eye.right - a_eye.left) / (a_eye.left + a_eye.right);
+		projection._32 = (a_eye.up - a_eye.down) / (a_eye.up + a_eye.down);
+		projection._33 = 1.0f;
+		projection._34 = 1.0f;
+		projection._43 = -0.1f;
+		projection._44 = 0.0f;
+		return projection;
+	}
+
+	struct Pixel
+	{
+		float x, y;
+	};
+
+	// Where a view space point lands in the whole target, with the game's projection offset added in NDC
+	Pixel Project(const StereoViewports& a_viewports, uint a_eye, const float4x4& a_projection, float a_x, float a_y, float a_z, std::pair<float, float> a_offset = {})
+	{
+		auto w = a_x * a_projection._14 + a_y * a_projection._24 + a_z * a_projection._34 + a_projection._44;
+		auto ndcX = (a_x * a_projection._11 + a_y * a_projection._21 + a_z * a_projection._31 + a_projection._41) / w + a_offset.first;
+		auto ndcY = (a_x * a_projection._12 + a_y * a_projection._22 + a_z * a_projection._32 + a_projection._42) / w + a_offset.second;
+		auto& rect = a_viewports.GetRect(a_eye);
+		return { (float)rect.left + (ndcX + 1.0f) * 0.5f * (float)rect.width, (float)rect.top + (1.0f - ndcY) * 0.5f * (float)rect.height };
+	}
+}
+
+TEST_CASE("Eyes cover the target exactly", "[StereoViewports]")
+{
+	StereoViewports viewports;
+
+	SECTION("Flat")
+	{
+		viewports.Configure(1, 2560, 1440);
+		CHECK_FALSE(viewports.IsStereo());
+		auto& rect = viewports.GetRect(0);
+		CHECK((rect.left == 0 && rect.top == 0 && rect.width == 2560 && rect.height == 1440));
+		CHECK(viewports.GetAspectRatio(0) == Approx(16.0f / 9.0f));
+		CHECK(viewports.GetMotionVectorScale(0) == 1.0f);
+	}
+
+	SECTION("Side by side, odd width")
+	{
+		// Index at 100% per eye is 2016 wide, a supersampled target can be odd
+		viewports.Configure(2, 4033, 2240);
+		REQUIRE(viewports.IsStereo());
+		auto& left = viewports.GetRect(0);
+		auto& right = viewports.GetRect(1);
+		CHECK(left.left == 0);
+		CHECK(left.left + left.width == right.left);
+		CHECK(right.left + right.width == 4033);
+		CHECK(right.width - left.width == 1);
+		CHECK((left.height == 2240 && right.height == 2240));
+		CHECK(viewports.GetAspectRatio(0) == Approx(2016.0f / 2240.0f));
+	}
+
+	SECTION("Eye count is clamped")
+	{
+		viewports.Configure(0, 1920, 1080);
+		CHECK(viewports.GetEyeCount() == 1);
+		viewports.Configure(4, 1920, 1080);
+		CHECK(viewports.GetEyeCount() == StereoViewports::MaxEyes);
+	}
+}
+
+TEST_CASE("Switching to flat clears the second eye", "[StereoViewports]")
+{
+	StereoViewports viewports;
+	viewports.Configure(2, 4032, 2240);
+	viewports.Configure(1, 1920, 1080);
+	CHECK(viewports.GetRect(0).width == 1920);
+	CHECK(viewports.GetRect(1).width == 0);
+}
+
+TEST_CASE("Each eye gets its own backend slot", "[StereoViewports]")
+{
+	// Flat keeps viewport 0, the handle Streamline always used
+	CHECK(StereoViewports::GetViewportId(0) == 0);
+	CHECK(StereoViewports::GetViewportId(1) != StereoViewports::GetViewportId(0));
+}
+
+TEST_CASE("Eye FOV comes from the eye's projection", "[StereoViewports]")
+{
+	auto expected = 2.0f * std::atan(1.12f);
+	CHECK(StereoViewports::GetVerticalFOV(Projection(LeftEye)) == Approx(expected));
+	CHECK(StereoViewports::GetVerticalFOV(Projection(RightEye)) == Approx(expected));
+
+	// A wider headset
+	Eye wide{ 1.6f, 1.2f, 1.5f, 1.5f };
+	CHECK(StereoViewports::GetVerticalFOV(Projection(wide)) == Approx(2.0f * std::atan(1.5f)));
+}
+
+TEST_CASE("Jitter moves every eye by the same pixels", "[StereoViewports]")
+{
+	StereoViewports viewports;
+	viewports.Configure(2, 4032, 2240);
+	std::array projections{ Projection(LeftEye), Projection(RightEye) };
+
+	auto jitterX = GENERATE(0.25f, -0.4f);
+	auto jitterY = GENERATE(-0.3f, 0.45f);
+	auto offset = viewports.GetProjectionOffset(jitterX, jitterY);
+
+	// Streamline is given the negated jitter, the scene has to move by exactly that in each eye
+	for (uint eye = 0; eye < 2; eye++) {
+		for (auto [x, y, z] : { std::array{ 0.0f, 0.0f, 2.0f }, std::array{ -3.0f, 1.5f, 5.0f }, std::array{ 20.0f, -8.0f, 40.0f } }) {
+			CAPTURE(eye, x, y, z);
+			auto unjittered = Project(viewports, eye, projections[eye], x, y, z);
+			auto jittered = Project(viewports, eye, projections[eye], x, y, z, offset);
+			CHECK(jittered.x - unjittered.x == Approx(-jitterX).margin(1e-3));
+			CHECK(jittered.y - unjittered.y == Approx(-jitterY).margin(1e-3));
+		}
+	}
+}
+
+TEST_CASE("Motion vectors are scaled to each eye's extent", "[StereoViewports]")
+{
+	StereoViewports viewports;
+	viewports.Configure(2, 4033, 2240);
+	std::array projections{ Projection(LeftEye), Projection(RightEye) };
+
+	for (uint eye = 0; eye < 2; eye++) {
+		CAPTURE(eye);
+		auto& rect = viewports.GetRect(eye);
+		// The game writes motion in UV of the whole target, DLSS reads it in UV of the eye's extent
+		auto previous = Project(viewports, eye, projections[eye], -1.0f, 0.5f, 4.0f);
+		auto current = Project(viewports, eye, projections[eye], -0.8f, 0.5f, 4.0f);
+		auto targetUV = (previous.x - current.x) / (float)viewports.GetWidth();
+		auto eyeUV = (previous.x - current.x) / (float)rect.width;
+		CHECK(targetUV * viewports.GetMotionVectorScale(eye) == Approx(eyeUV));
+	}
+}
@@ -0,0 +1,3 @@
+// Catch2 3 ships its own main, Catch2 2 needs one translation unit to define it
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
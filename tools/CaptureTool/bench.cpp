@@ -0,0 +1,248 @@
+// Measures compression ratio and throughput of the capture codecs on depth and motion vector planes, taken from a
+// capture or generated when none is given, against zstd and LZ4
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <lz4.h>
+#include <zstd.h>
+
+#include "CaptureFile.h"
+
+struct Sample
+{
+	std::string name;
+	PlaneCodec::Layout layout;
+	std::vector<uint8_t> data;
+};
+
+struct Method
+{
+	std::string name;
+	std::function<void(const Sample&, std::vector<uint8_t>&)> encode;
+	std::function<bool(const Sample&, std::span<const uint8_t>, std::vector<uint8_t>&)> decode;
+};
+
+// Bench formats, DXGI_FORMAT values
+static constexpr uint32_t FormatR16G16Float = 34;
+static constexpr uint32_t FormatR32Float = 41;
+static constexpr uint32_t FormatR24G8Typeless = 44;
+
+static constexpr uint32_t MaxSamplesPerType = 4;
+static constexpr double MinSeconds = 0.25;
+
+static uint16_t ToHalf(float a_value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &a_value, sizeof(bits));
+	auto sign = (uint16_t)((bits >> 16) & 0x8000u);
+	auto exponent = (int)((bits >> 23) & 0xFFu) - 127 + 15;
+	auto mantissa = bits & 0x7FFFFFu;
+	if (exponent <= 0)
+		return sign;
+	if (exponent >= 31)
+		return (uint16_t)(sign | 0x7C00u);
+	return (uint16_t)(sign | (exponent << 10) | (mantissa >> 13));
+}
+
+// A floor, a back wall and a few spheres seen through a perspective camera, with the camera turning and one sphere
+// moving on its own, roughly what a game frame's depth and motion look like
+static void GenerateSamples(uint32_t a_width, uint32_t a_height, std::vector<Sample>& a_samples)
+{
+	Sample depth24{ "synthetic depth D24S8", { a_width, a_height, FormatR24G8Typeless, 4 }, {} };
+	Sample depth32{ "synthetic depth R32F", { a_width, a_height, FormatR32Float, 4 }, {} };
+	Sample motion{ "synthetic motion R16G16F", { a_width, a_height, FormatR16G16Float, 4 }, {} };
+	depth24.data.resize((std::size_t)a_width * a_height * 4);
+	depth32.data.resize(depth24.data.size());
+	motion.data.resize(depth24.data.size());
+
+	struct Sphere
+	{
+		float x, y, z, radius;
+		bool moving;
+	};
+	const Sphere spheres[] = { { -2.0f, 0.0f, 8.0f, 1.5f, false }, { 1.5f, -0.5f, 5.0f, 1.0f, true }, { 4.0f, 1.0f, 14.0f, 3.0f, false } };
+	const float nearPlane = 0.1f, farPlane = 400.0f, floorHeight = -1.5f, wall = 60.0f, turn = 0.004f;
+
+	auto aspect = (float)a_width / (float)a_height;
+	for (uint32_t y = 0; y < a_height; y++) {
+		for (uint32_t x = 0; x < a_width; x++) {
+			auto u = ((float)x + 0.5f) / (float)a_width * 2.0f - 1.0f;
+			auto v = 1.0f - ((float)y + 0.5f) / (float)a_height * 2.0f;
+			float ray[3] = { u * aspect * 0.6f, v * 0.6f, 1.0f };
+
+			auto distance = wall;
+			if (ray[1] < 0.0f)
+				distance = std::min(distance, floorHeight / ray[1]);
+
+			bool moving = false;
+			for (auto& sphere : spheres) {
+				auto b = ray[0] * sphere.x + ray[1] * sphere.y + ray[2] * sphere.z;
+				auto a = ray[0] * ray[0] + ray[1] * ray[1] + ray[2] * ray[2];
+				auto c = sphere.x * sphere.x + sphere.y * sphere.y + sphere.z * sphere.z - sphere.radius * sphere.radius;
+				auto discriminant = b * b - a * c;
+				if (discriminant < 0.0f)
+					continue;
+				auto t = (b - std::sqrt(discriminant)) / a;
+				if (t > 0.0f && t < distance) {
+					distance = t;
+					moving = sphere.moving;
+				}
+			}
+
+			// Reversed depth is not used by the game, this is the usual D3D projection
+			auto z = distance;
+			auto ndc = std::clamp((farPlane / (farPlane - nearPlane)) * (1.0f - nearPlane / z), 0.0f, 1.0f);
+			auto index = (std::size_t)y * a_width + x;
+
+			uint32_t packed = (uint32_t)std::lround(ndc * 16777215.0f) | (moving ? 0x01000000u : 0u);
+			std::memcpy(depth24.data.data() + index * 4, &packed, 4);
+			std::memcpy(depth32.data.data() + index * 4, &ndc, 4);
+
+			// Yaw moves everything sideways by about the same amount, the moving sphere adds its own velocity
+			auto mx = turn * (1.0f + u * u * 0.3f) + (moving ? 0.01f : 0.0f);
+			auto my = turn * u * v * 0.2f - (moving ? 0.004f : 0.0f);
+			uint16_t halves[2] = { ToHalf(mx), ToHalf(my) };
+			std::memcpy(motion.data.data() + index * 4, halves, 4);
+		}
+	}
+
+	a_samples.push_back(std::move(depth24));
+	a_samples.push_back(std::move(depth32));
+	a_samples.push_back(std::move(motion));
+}
+
+static bool LoadSamples(const char* a_path, std::vector<Sample>& a_samples)
+{
+	CaptureFile::Reader reader;
+	if (!reader.Open(a_path))
+		return false;
+
+	uint32_t depthCount = 0, motionCount = 0;
+	for (auto& chunk : reader.GetChunks()) {
+		auto type = chunk.GetType();
+		auto& count = type == CaptureFile::ChunkType::kDepth ? depthCount : motionCount;
+		if ((type != CaptureFile::ChunkType::kDepth && type != CaptureFile::ChunkType::kMotionVectors) || count >= MaxSamplesPerType || !chunk.header->width)
+			continue;
+
+		Sample sample;
+		sample.name = std::string(type == CaptureFile::ChunkType::kDepth ? "depth" : "motion") + " frame " + std::to_string(chunk.header->frame);
+		sample.layout = { chunk.header->width, chunk.header->height, chunk.header->format, chunk.header->pixelSize };
+		if (!CaptureFile::Reader::Decode(chunk, sample.data))
+			continue;
+		a_samples.push_back(std::move(sample));
+		count++;
+	}
+	return true;
+}
+
+static std::vector<Method> GetMethods()
+{
+	std::vector<Method> methods;
+
+	std::vector<uint32_t> threadCounts = { 1 };
+	if (auto threads = std::thread::hardware_concurrency(); threads > 1)
+		threadCounts.push_back(threads);
+	for (auto count : threadCounts) {
+		methods.push_back({ "plane x" + std::to_string(count),
+			[count](const Sample& a_sample, std::vector<uint8_t>& a_out) { CaptureCodec::Encode(CaptureCodec::Codec::kPlane, a_sample.data, a_out, a_sample.layout, count); },
+			[count](const Sample& a_sample, std::span<const uint8_t> a_data, std::vector<uint8_t>& a_out) {
+				return CaptureCodec::Decode(CaptureCodec::Codec::kPlane, a_data, a_sample.data.size(), a_out, count);
+			} });
+	}
+
+	for (auto level : { 1, 3 }) {
+		methods.push_back({ "zstd -" + std::to_string(level),
+			[level](const Sample& a_sample, std::vector<uint8_t>& a_out) {
+				a_out.resize(ZSTD_compressBound(a_sample.data.size()));
+				auto size = ZSTD_compress(a_out.data(), a_out.size(), a_sample.data.data(), a_sample.data.size(), level);
+				a_out.resize(ZSTD_isError(size) ? 0 : size);
+			},
+			[](const Sample& a_sample, std::span<const uint8_t> a_data, std::vector<uint8_t>& a_out) {
+				a_out.resize(a_sample.data.size());
+				auto size = ZSTD_decompress(a_out.data(), a_out.size(), a_data.data(), a_data.size());
+				return !ZSTD_isError(size) && size == a_out.size();
+			} });
+	}
+
+	methods.push_back({ "lz4",
+		[](const Sample& a_sample, std::vector<uint8_t>& a_out) {
+			a_out.resize(LZ4_compressBound((int)a_sample.data.size()));
+			auto size = LZ4_compress_default(reinterpret_cast<const char*>(a_sample.data.data()), reinterpret_cast<char*>(a_out.data()), (int)a_sample.data.size(), (int)a_out.size());
+			a_out.resize(size > 0 ? (std::size_t)size : 0);
+		},
+		[](const Sample& a_sample, std::span<const uint8_t> a_data, std::vector<uint8_t>& a_out) {
+			a_out.resize(a_sample.data.size());
+			auto size = LZ4_decompress_safe(reinterpret_cast<const char*>(a_data.data()), reinterpret_cast<char*>(a_out.data()), (int)a_data.size(), (int)a_out.size());
+			return size >= 0 && (std::size_t)size == a_out.size();
+		} });
+
+	return methods;
+}
+
+// Repeats a_func until MinSeconds have passed, returns seconds per call
+static double Time(const std::function<void()>& a_func)
+{
+	using Clock = std::chrono::steady_clock;
+	uint64_t calls = 0;
+	auto start = Clock::now();
+	std::chrono::duration<double> elapsed{};
+	do {
+		a_func();
+		calls++;
+		elapsed = Clock::now() - start;
+	} while (elapsed.count() < MinSeconds);
+	return elapsed.count() / (double)calls;
+}
+
+int main(int a_argc, char** a_argv)
+{
+	std::vector<Sample> samples;
+	if (a_argc == 2) {
+		if (!LoadSamples(a_argv[1], samples)) {
+			std::fprintf(stderr, "%s is not a readable capture\n", a_argv[1]);
+			return 1;
+		}
+		if (samples.empty()) {
+			std::fprintf(stderr, "%s has no depth or motion vector planes\n", a_argv[1]);
+			return 1;
+		}
+	} else if (a_argc == 1) {
+		GenerateSamples(2560, 1440, samples);
+	} else {
+		std::fprintf(stderr, "usage: codecbench [capture]\n  without a capture, generated 2560x1440 planes are used\n");
+		return 2;
+	}
+
+	auto methods = GetMethods();
+	std::vector<uint8_t> encoded, decoded;
+	bool failed = false;
+	for (auto& sample : samples) {
+		std::printf("\n%s, %ux%u format %u, %zu bytes\n", sample.name.c_str(), sample.layout.width, sample.layout.height, sample.layout.format, sample.data.size());
+		std::printf("  %-10s %8s %12s %12s\n", "codec", "ratio", "encode GB/s", "decode GB/s");
+		for (auto& method : methods) {
+			auto encodeTime = Time([&] {
+				encoded.clear();
+				method.encode(sample, encoded);
+			});
+
+			bool valid = true;
+			auto decodeTime = Time([&] { valid = method.decode(sample, encoded, decoded) && valid; });
+			if (!valid || decoded != sample.data) {
+				std::printf("  %-10s did not round trip\n", method.name.c_str());
+				failed = true;
+				continue;
+			}
+
+			auto gigabytes = (double)sample.data.size() / 1e9;
+			std::printf("  %-10s %8.2f %12.2f %12.2f\n", method.name.c_str(), encoded.empty() ? 0.0 : (double)sample.data.size() / (double)encoded.size(),
+				gigabytes / encodeTime, gigabytes / decodeTime);
+		}
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+// Inspects captures written by the plugin's frame capture mode and extracts decoded planes for offline tuning
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string_view>
+
+#include "CaptureFile.h"
+
+static std::string_view GetTypeName(CaptureFile::ChunkType a_type)
+{
+	switch (a_type) {
+	case CaptureFile::ChunkType::kFrame:
+		return "frame";
+	case CaptureFile::ChunkType::kColor:
+		return "color";
+	case CaptureFile::ChunkType::kDepth:
+		return "depth";
+	case CaptureFile::ChunkType::kMotionVectors:
+		return "motion";
+	case CaptureFile::ChunkType::kMask:
+		return "mask";
+	case CaptureFile::ChunkType::kIndex:
+		return "index";
+	default:
+		return "unknown";
+	}
+}
+
+static std::string_view GetCodecName(uint32_t a_codec)
+{
+	switch ((CaptureFile::Codec)a_codec) {
+	case CaptureFile::Codec::kNone:
+		return "none";
+	case CaptureFile::Codec::kPlane:
+		return "plane";
+	default:
+		return "unknown";
+	}
+}
+
+static bool ParseFrame(const char* a_text, uint64_t& a_frame)
+{
+	auto end = a_text + std::strlen(a_text);
+	auto [ptr, ec] = std::from_chars(a_text, end, a_frame);
+	return ec == std::errc() && ptr == end;
+}
+
+static int Info(const CaptureFile::Reader& a_reader)
+{
+	struct Totals
+	{
+		uint64_t count = 0;
+		uint64_t stored = 0;
+		uint64_t raw = 0;
+	};
+
+	std::map<uint32_t, Totals> totals;
+	uint64_t firstFrame = UINT64_MAX;
+	uint64_t lastFrame = 0;
+	for (auto& chunk : a_reader.GetChunks()) {
+		auto& total = totals[chunk.header->type];
+		total.count++;
+		total.stored += chunk.header->storedSize;
+		total.raw += chunk.header->rawSize;
+		firstFrame = std::min(firstFrame, chunk.header->frame);
+		lastFrame = std::max(lastFrame, chunk.header->frame);
+	}
+
+	std::printf("%zu chunks, %s\n", a_reader.GetChunks().size(), a_reader.HasIndex() ? "indexed" : "no index, capture was cut short");
+	if (!a_reader.GetChunks().empty())
+		std::printf("frames %llu to %llu\n", (unsigned long long)firstFrame, (unsigned long long)lastFrame);
+	for (auto& [type, total] : totals) {
+		std::printf("%-8.*s %8llu chunks %12llu bytes stored %12llu raw (%.1f%%)\n", (int)GetTypeName((CaptureFile::ChunkType)type).size(), GetTypeName((CaptureFile::ChunkType)type).data(),
+			(unsigned long long)total.count, (unsigned long long)total.stored, (unsigned long long)total.raw, total.raw ? 100.0 * (double)total.stored / (double)total.raw : 100.0);
+	}
+	return 0;
+}
+
+static int List(const CaptureFile::Reader& a_reader)
+{
+	for (auto& chunk : a_reader.GetChunks()) {
+		auto& header = *chunk.header;
+		auto name = GetTypeName(chunk.GetType());
+		auto codec = GetCodecName(header.codec);
+		std::printf("%10llu %-8.*s %-6.*s %12llu / %12llu", (unsigned long long)header.frame, (int)name.size(), name.data(), (int)codec.size(), codec.data(),
+			(unsigned long long)header.storedSize, (unsigned long long)header.rawSize);
+		if (header.width)
+			std::printf("  %ux%u format %u, %u bytes per pixel", header.width, header.height, header.format, header.pixelSize);
+		std::printf("\n");
+	}
+	return 0;
+}
+
+static int PrintFrame(const CaptureFile::Reader& a_reader, uint64_t a_frame)
+{
+	std::vector<uint8_t> decoded;
+	bool found = false;
+	for (auto& chunk : a_reader.GetChunks()) {
+		if (chunk.GetType() != CaptureFile::ChunkType::kFrame || chunk.header->frame != a_frame)
+			continue;
+		if (!CaptureFile::Reader::Decode(chunk, decoded) || decoded.size() != sizeof(CaptureFile::FrameInfo)) {
+			std::fprintf(stderr, "frame %llu has a corrupt frame chunk\n", (unsigned long long)a_frame);
+			return 1;
+		}
+
+		CaptureFile::FrameInfo info;
+		std::memcpy(&info, decoded.data(), sizeof(info));
+		std::printf("frame %llu eye %u of %u, rect %u,%u %ux%u, method %u%s\n", (unsigned long long)a_frame, info.eye, info.eyeCount, info.left, info.top, info.width, info.height,
+			info.method, info.reset ? ", reset" : "");
+		std::printf("  jitter %.4f %.4f, near %.3f, far %.1f, fov %.4f rad, aspect %.4f, frame time %.2f ms\n", info.jitter[0], info.jitter[1], info.cameraNear, info.cameraFar,
+			info.verticalFOV, info.aspectRatio, info.frameTime * 1000.0f);
+		std::printf("  position %.3f %.3f %.3f, forward %.4f %.4f %.4f\n", info.position[0], info.position[1], info.position[2], info.forward[0], info.forward[1], info.forward[2]);
+		found = true;
+	}
+
+	if (!found) {
+		std::fprintf(stderr, "frame %llu is not in the capture\n", (unsigned long long)a_frame);
+		return 1;
+	}
+	return 0;
+}
+
+static int Extract(const CaptureFile::Reader& a_reader, uint64_t a_frame, std::string_view a_type, const char* a_output)
+{
+	std::vector<uint8_t> decoded;
+	for (auto& chunk : a_reader.GetChunks()) {
+		if (chunk.header->frame != a_frame || GetTypeName(chunk.GetType()) != a_type)
+			continue;
+		if (!CaptureFile::Reader::Decode(chunk, decoded)) {
+			std::fprintf(stderr, "%.*s of frame %llu is corrupt\n", (int)a_type.size(), a_type.data(), (unsigned long long)a_frame);
+			return 1;
+		}
+
+		std::ofstream output(a_output, std::ios::binary);
+		output.write(reinterpret_cast<const char*>(decoded.data()), (std::streamsize)decoded.size());
+		if (!output) {
+			std::fprintf(stderr, "could not write %s\n", a_output);
+			return 1;
+		}
+		std::printf("wrote %zu bytes", decoded.size());
+		if (chunk.header->width)
+			std::printf(", %ux%u format %u, %u bytes per pixel", chunk.header->width, chunk.header->height, chunk.header->format, chunk.header->pixelSize);
+		std::printf("\n");
+		return 0;
+	}
+
+	std::fprintf(stderr, "frame %llu has no %.*s chunk\n", (unsigned long long)a_frame, (int)a_type.size(), a_type.data());
+	return 1;
+}
+
+static int Verify(const CaptureFile::Reader& a_reader)
+{
+	std::vector<uint8_t> decoded;
+	uint64_t failures = 0;
+	for (auto& chunk : a_reader.GetChunks()) {
+		if (!CaptureFile::Reader::Decode(chunk, decoded)) {
+			auto name = GetTypeName(chunk.GetType());
+			std::fprintf(stderr, "%.*s of frame %llu is corrupt\n", (int)name.size(), name.data(), (unsigned long long)chunk.header->frame);
+			failures++;
+		}
+	}
+	std::printf("%zu chunks, %llu corrupt\n", a_reader.GetChunks().size(), (unsigned long long)failures);
+	return failures ? 1 : 0;
+}
+
+static void PrintUsage()
+{
+	std::fprintf(stderr,
+		"usage: capturetool <command> <capture> [arguments]\n"
+		"  info <capture>                           chunk counts and sizes\n"
+		"  list <capture>                           every chunk in file order\n"
+		"  verify <capture>                         decodes every chunk\n"
+		"  frame <capture> <frame>                  camera data of a frame\n"
+		"  extract <capture> <frame> <type> <file>  decoded plane, type is color, depth, motion or mask\n");
+}
+
+int main(int a_argc, char** a_argv)
+{
+	if (a_argc < 3) {
+		PrintUsage();
+		return 2;
+	}
+
+	std::string_view command = a_argv[1];
+	CaptureFile::Reader reader;
+	if (!reader.Open(a_argv[2])) {
+		std::fprintf(stderr, "%s is not a readable capture\n", a_argv[2]);
+		return 1;
+	}
+
+	uint64_t frame = 0;
+	if (command == "info" && a_argc == 3)
+		return Info(reader);
+	if (command == "list" && a_argc == 3)
+		return List(reader);
+	if (command == "verify" && a_argc == 3)
+		return Verify(reader);
+	if (command == "frame" && a_argc == 4 && ParseFrame(a_argv[3], frame))
+		return PrintFrame(reader, frame);
+	if (command == "extract" && a_argc == 6 && ParseFrame(a_argv[3], frame))
+		return Extract(reader, frame, a_argv[4], a_argv[5]);
+
+	PrintUsage();
+	return 2;
+}